@@ -29,12 +29,21 @@
 #include "watch.h"
 #include "lfs.h"
 #include "base64.h"
-#include "delay.h"
+
+#ifdef HAS_SPI_FLASH
+#include "spiflash.h"
+#endif
+
+#if !__EMSCRIPTEN__
+#include "watch_usb_cdc.h"
+#endif
 
 #ifndef min
 #define min(x, y) ((x) > (y) ? (y) : (x))
 #endif
 
+#define FILESYSTEM_BLOCK_NULL ((lfs_block_t)-1)
+
 int lfs_storage_read(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size);
 int lfs_storage_prog(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
 int lfs_storage_erase(const struct lfs_config *cfg, lfs_block_t block);
@@ -80,6 +89,126 @@ const struct lfs_config watch_lfs_cfg = {
 lfs_t eeprom_filesystem;
 static lfs_file_t file;
 static struct lfs_info info;
+static bool filesystem_mount_attempted = false;
+static bool filesystem_mounted = false;
+
+#ifdef HAS_SPI_FLASH
+
+// Boards with SPI flash get a second, much larger volume for bulk data like sensor logs. It is reached by
+// prefixing a path with EXT_FLASH_MOUNT_POINT, e.g. "/ext/accel.csv"; every other path lives in RWWEE.
+#define EXT_FLASH_MOUNT_POINT "/ext"
+#define EXT_FLASH_SECTOR_SIZE 4096
+#define EXT_FLASH_PAGE_SIZE 256
+
+// The simulator builds this against a RAM-backed spiflash.c (watch-library/simulator/driver) with the same interface.
+
+int lfs_ext_flash_read(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size);
+int lfs_ext_flash_prog(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
+int lfs_ext_flash_erase(const struct lfs_config *cfg, lfs_block_t block);
+int lfs_ext_flash_sync(const struct lfs_config *cfg);
+
+int lfs_ext_flash_read(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size) {
+    (void) cfg;
+    // one READ command streams the whole range in a single chip select.
+    return !spi_flash_read_data(block * EXT_FLASH_SECTOR_SIZE + off, (uint8_t *)buffer, size);
+}
+
+int lfs_ext_flash_prog(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
+    (void) cfg;
+    uint32_t address = block * EXT_FLASH_SECTOR_SIZE + off;
+    uint8_t *data = (uint8_t *)buffer;
+
+    while (size > 0) {
+        // a page program wraps around at the end of its 256-byte page, so never let a burst cross one.
+        lfs_size_t length = min(size, EXT_FLASH_PAGE_SIZE - (address % EXT_FLASH_PAGE_SIZE));
+        if (!spi_flash_command(CMD_ENABLE_WRITE)) return 1;
+        if (!spi_flash_write_data(address, data, length)) return 1;
+        spi_flash_wait_until_ready();
+        address += length;
+        data += length;
+        size -= length;
+    }
+
+    return 0;
+}
+
+int lfs_ext_flash_erase(const struct lfs_config *cfg, lfs_block_t block) {
+    (void) cfg;
+    if (!spi_flash_command(CMD_ENABLE_WRITE)) return 1;
+    if (!spi_flash_sector_command(CMD_SECTOR_ERASE, block * EXT_FLASH_SECTOR_SIZE)) return 1;
+    return !spi_flash_wait_until_ready();
+}
+
+int lfs_ext_flash_sync(const struct lfs_config *cfg) {
+    (void) cfg;
+    return !spi_flash_wait_until_ready();
+}
+
+// Not const: the block count is filled in from the flash chip's JEDEC ID when the volume is mounted.
+struct lfs_config watch_ext_lfs_cfg = {
+    // block device operations
+    .read  = lfs_ext_flash_read,
+    .prog  = lfs_ext_flash_prog,
+    .erase = lfs_ext_flash_erase,
+    .sync  = lfs_ext_flash_sync,
+
+    // block device configuration
+    .read_size = 16,
+    .prog_size = 16,
+    .block_size = EXT_FLASH_SECTOR_SIZE,
+    .block_count = 0,
+    .cache_size = EXT_FLASH_PAGE_SIZE,
+    .lookahead_size = 32,
+    .block_cycles = 500,
+};
+
+lfs_t ext_filesystem;
+static bool ext_filesystem_mounted = false;
+
+static bool _filesystem_ext_init(void) {
+    spi_flash_init();
+
+    // the third byte of the JEDEC ID is the log2 of the chip's capacity in bytes.
+    uint8_t jedec_id[3] = {0};
+    spi_flash_read_command(CMD_READ_JEDEC_ID, jedec_id, 3);
+    if (jedec_id[2] < 16 || jedec_id[2] > 27) {
+        printf("No SPI flash found.\r\n");
+        return false;
+    }
+    watch_ext_lfs_cfg.block_count = (1UL << jedec_id[2]) / EXT_FLASH_SECTOR_SIZE;
+
+    int err = lfs_mount(&ext_filesystem, &watch_ext_lfs_cfg);
+    if (err < 0) {
+        printf("Formatting external flash...\r\n");
+        err = lfs_format(&ext_filesystem, &watch_ext_lfs_cfg);
+        if (err < 0) return false;
+        err = lfs_mount(&ext_filesystem, &watch_ext_lfs_cfg);
+    }
+
+    ext_filesystem_mounted = (err == LFS_ERR_OK);
+
+    return ext_filesystem_mounted;
+}
+
+#endif // HAS_SPI_FLASH
+
+// Picks the volume a path lives on. For paths on the external volume, the mount point is stripped off.
+static lfs_t *_filesystem_for_path(const char **path) {
+    // every file access comes through here, so this is where the filesystem gets mounted on first use.
+    filesystem_init();
+
+#ifdef HAS_SPI_FLASH
+    size_t mount_point_length = strlen(EXT_FLASH_MOUNT_POINT);
+    if (ext_filesystem_mounted && strncmp(*path, EXT_FLASH_MOUNT_POINT, mount_point_length) == 0 &&
+        ((*path)[mount_point_length] == '\0' || (*path)[mount_point_length] == '/')) {
+        *path += mount_point_length;
+        if (**path == '\0') *path = "/";
+        return &ext_filesystem;
+    }
+#endif
+
+    return &eeprom_filesystem;
+}
 
 static int _traverse_df_cb(void *p, lfs_block_t block) {
     (void) block;
@@ -88,20 +217,25 @@ static int _traverse_df_cb(void *p, lfs_block_t block) {
 	return 0;
 }
 
-int32_t filesystem_get_free_space(void) {
+static int32_t _filesystem_get_free_space(lfs_t *lfs) {
 	int err;
 
 	uint32_t free_blocks = 0;
-	err = lfs_fs_traverse(&eeprom_filesystem, _traverse_df_cb, &free_blocks);
+	err = lfs_fs_traverse(lfs, _traverse_df_cb, &free_blocks);
 	if(err < 0){
 		return err;
 	}
 
-	uint32_t available = watch_lfs_cfg.block_count * watch_lfs_cfg.block_size - free_blocks * watch_lfs_cfg.block_size;
+	uint32_t available = lfs->cfg->block_count * lfs->cfg->block_size - free_blocks * lfs->cfg->block_size;
 
 	return (int32_t)available;
 }
 
+int32_t filesystem_get_free_space(void) {
+	filesystem_init();
+	return _filesystem_get_free_space(&eeprom_filesystem);
+}
+
 static int filesystem_ls(lfs_t *lfs, const char *path) {
     lfs_dir_t dir;
     int err = lfs_dir_open(lfs, &dir, path);
@@ -140,6 +274,9 @@ static int filesystem_ls(lfs_t *lfs, const char *path) {
 }
 
 bool filesystem_init(void) {
+    if (filesystem_mount_attempted) return filesystem_mounted;
+    filesystem_mount_attempted = true;
+
     int err = lfs_mount(&eeprom_filesystem, &watch_lfs_cfg);
 
     // reformat if we can't mount the filesystem
@@ -148,11 +285,17 @@ bool filesystem_init(void) {
         printf("Ignore that error! Formatting filesystem...\r\n");
         err = lfs_format(&eeprom_filesystem, &watch_lfs_cfg);
         if (err < 0) return false;
-        err = lfs_mount(&eeprom_filesystem, &watch_lfs_cfg) == LFS_ERR_OK;
-        printf("Filesystem mounted with %ld bytes free.\r\n", filesystem_get_free_space());
+        err = lfs_mount(&eeprom_filesystem, &watch_lfs_cfg);
+        printf("Filesystem mounted with %ld bytes free.\r\n", _filesystem_get_free_space(&eeprom_filesystem));
     }
 
-    return err == LFS_ERR_OK;
+#ifdef HAS_SPI_FLASH
+    _filesystem_ext_init();
+#endif
+
+    filesystem_mounted = (err == LFS_ERR_OK);
+
+    return filesystem_mounted;
 }
 
 int _filesystem_format(void);
@@ -166,22 +309,25 @@ int _filesystem_format(void) {
     if (err < 0) return err;
 
     err = lfs_mount(&eeprom_filesystem, &watch_lfs_cfg);
+    filesystem_mounted = (err == LFS_ERR_OK);
     if (err < 0) return err;
     printf("Filesystem re-mounted with %ld bytes free.\r\n", filesystem_get_free_space());
     return 0;
 }
 
 bool filesystem_file_exists(char *filename) {
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
     info.type = 0;
-    lfs_stat(&eeprom_filesystem, filename, &info);
+    lfs_stat(lfs, path, &info);
     return info.type == LFS_TYPE_REG;
 }
 
 bool filesystem_rm(char *filename) {
-    info.type = 0;
-    lfs_stat(&eeprom_filesystem, filename, &info);
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
     if (filesystem_file_exists(filename)) {
-        return lfs_remove(&eeprom_filesystem, filename) == LFS_ERR_OK;
+        return lfs_remove(lfs, path) == LFS_ERR_OK;
     } else {
         printf("rm: %s: No such file\r\n", filename);
         return false;
@@ -198,13 +344,15 @@ int32_t filesystem_get_file_size(char *filename) {
 
 bool filesystem_read_file(char *filename, char *buf, int32_t length) {
     memset(buf, 0, length);
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
     int32_t file_size = filesystem_get_file_size(filename);
     if (file_size > 0) {
-        int err = lfs_file_open(&eeprom_filesystem, &file, filename, LFS_O_RDONLY);
+        int err = lfs_file_open(lfs, &file, path, LFS_O_RDONLY);
         if (err < 0) return false;
-        err = lfs_file_read(&eeprom_filesystem, &file, buf, min(length, file_size));
+        err = lfs_file_read(lfs, &file, buf, min(length, file_size));
         if (err < 0) return false;
-        return lfs_file_close(&eeprom_filesystem, &file) == LFS_ERR_OK;
+        return lfs_file_close(lfs, &file) == LFS_ERR_OK;
     }
 
     return false;
@@ -212,13 +360,15 @@ bool filesystem_read_file(char *filename, char *buf, int32_t length) {
 
 bool filesystem_read_line(char *filename, char *buf, int32_t *offset, int32_t length) {
     memset(buf, 0, length + 1);
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
     int32_t file_size = filesystem_get_file_size(filename);
     if (file_size > 0) {
-        int err = lfs_file_open(&eeprom_filesystem, &file, filename, LFS_O_RDONLY);
+        int err = lfs_file_open(lfs, &file, path, LFS_O_RDONLY);
         if (err < 0) return false;
-        err = lfs_file_seek(&eeprom_filesystem, &file, *offset, LFS_SEEK_SET);
+        err = lfs_file_seek(lfs, &file, *offset, LFS_SEEK_SET);
         if (err < 0) return false;
-        err = lfs_file_read(&eeprom_filesystem, &file, buf, min(length - 1, file_size - *offset));
+        err = lfs_file_read(lfs, &file, buf, min(length - 1, file_size - *offset));
         if (err < 0) return false;
         for(int i = 0; i < length; i++) {
             (*offset)++;
@@ -227,62 +377,240 @@ bool filesystem_read_line(char *filename, char *buf, int32_t *offset, int32_t le
                 break;
             }
         }
-        return lfs_file_close(&eeprom_filesystem, &file) == LFS_ERR_OK;
+        return lfs_file_close(lfs, &file) == LFS_ERR_OK;
     }
 
     return false;
 }
 
-static void filesystem_cat(char *filename) {
-    info.type = 0;
-    lfs_stat(&eeprom_filesystem, filename, &info);
-    if (filesystem_file_exists(filename)) {
-        if (info.size > 0) {
-            char *buf = malloc(info.size + 1);
-            filesystem_read_file(filename, buf, info.size);
-            buf[info.size] = '\0';
-            printf("%s\r\n", buf);
-            free(buf);
-        } else {
-            printf("\r\n");
+int32_t filesystem_read_file_at(char *filename, int32_t offset, char *buf, int32_t length) {
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
+    int err = lfs_file_open(lfs, &file, path, LFS_O_RDONLY);
+    if (err < 0) return -1;
+    lfs_ssize_t bytes_read = -1;
+    if (lfs_file_seek(lfs, &file, offset, LFS_SEEK_SET) >= 0) {
+        bytes_read = lfs_file_read(lfs, &file, buf, length);
+    }
+    if (lfs_file_close(lfs, &file) < 0) return -1;
+    return bytes_read < 0 ? -1 : bytes_read;
+}
+
+bool filesystem_get_file_name(uint16_t index, char *buf, size_t length) {
+    lfs_t *lfs = &eeprom_filesystem;
+    lfs_dir_t dir;
+    if (!filesystem_init()) return false;
+    if (lfs_dir_open(lfs, &dir, "/") < 0) return false;
+
+    struct lfs_info entry;
+    bool found = false;
+    while (lfs_dir_read(lfs, &dir, &entry) > 0) {
+        if (entry.type != LFS_TYPE_REG) continue;
+        if (index-- == 0) {
+            strncpy(buf, entry.name, length - 1);
+            buf[length - 1] = 0;
+            found = true;
+            break;
         }
-    } else {
+    }
+
+    lfs_dir_close(lfs, &dir);
+    return found;
+}
+
+// filesystem_map_file reads littlefs's files in place, which means walking the CTZ skip-lists itself and peeking at
+// lfs_file_t's ctz and flags fields, none of which are part of the littlefs API. They have been the same for the
+// whole of littlefs 2.x; on anything else, check filesystem/test (which compares mapped files with lfs_file_read)
+// before lifting this.
+#if LFS_VERSION_MAJOR != 2 || LFS_DISK_VERSION_MAJOR != 2
+#error "filesystem_map_file only knows the littlefs 2.x file layout; run filesystem/test against this version."
+#endif
+
+// Walks a CTZ skip-list back from its head to the block with the given index.
+// Each block with index i > 0 begins with ctz(i) + 1 little-endian pointers: pointer n leads to block i - 2^n.
+static lfs_block_t _filesystem_ctz_find(lfs_block_t head, lfs_off_t head_index, lfs_off_t target_index) {
+    lfs_off_t current = head_index;
+
+    while (current > target_index) {
+        lfs_off_t distance = current - target_index;
+        uint32_t skip = 31 - __builtin_clz(distance);
+        uint32_t max_skip = __builtin_ctz(current);
+        if (skip > max_skip) skip = max_skip;
+
+        const uint8_t *pointer = watch_storage_get_address(head, 4 * skip);
+        if (pointer == NULL) return FILESYSTEM_BLOCK_NULL;
+        head = (lfs_block_t)pointer[0] | ((lfs_block_t)pointer[1] << 8) | ((lfs_block_t)pointer[2] << 16) | ((lfs_block_t)pointer[3] << 24);
+        current -= 1 << skip;
+    }
+
+    return head;
+}
+
+// Same as littlefs's lfs_ctz_index: returns the index of the block containing byte `offset` of a CTZ file.
+static lfs_off_t _filesystem_ctz_index(lfs_off_t offset) {
+    lfs_off_t b = watch_lfs_cfg.block_size - 2 * 4;
+    lfs_off_t i = offset / b;
+    if (i == 0) return 0;
+
+    return (offset - 4 * (__builtin_popcount(i - 1) + 2)) / b;
+}
+
+bool filesystem_map_file(char *filename, filesystem_map_cb_t callback, void *context) {
+    if (!filesystem_file_exists(filename)) return false;
+
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
+    int err = lfs_file_open(lfs, &file, path, LFS_O_RDONLY);
+    if (err < 0) return false;
+
+    bool completed = true;
+    // inline files live inside a metadata pair and aren't contiguous; they are tiny, so just copy them. The external
+    // volume isn't memory mapped at all, so it has to take this path too. And if the size littlefs reports doesn't
+    // match what we found in its private fields, we're not looking at the layout we think we are: copy it then, too.
+    bool in_place = lfs == &eeprom_filesystem && !(file.flags & LFS_F_INLINE) &&
+                    lfs_file_size(lfs, &file) == (lfs_soff_t)file.ctz.size;
+
+    if (!in_place) {
+        uint8_t buf[32];
+        lfs_ssize_t len;
+        while ((len = lfs_file_read(lfs, &file, buf, sizeof(buf))) > 0) {
+            if (!callback(buf, len, context)) {
+                completed = false;
+                break;
+            }
+        }
+        if (len < 0) completed = false;
+    } else if (file.ctz.size > 0) {
+        lfs_off_t head_index = _filesystem_ctz_index(file.ctz.size - 1);
+        lfs_size_t remaining = file.ctz.size;
+
+        // data fills each block after its skip pointers, so every block holds one contiguous span of the file.
+        for (lfs_off_t index = 0; index <= head_index && remaining > 0; index++) {
+            lfs_block_t block = _filesystem_ctz_find(file.ctz.head, head_index, index);
+            lfs_off_t data_offset = index ? 4 * (__builtin_ctz(index) + 1) : 0;
+            lfs_size_t length = min(watch_lfs_cfg.block_size - data_offset, remaining);
+            const uint8_t *data = (block == FILESYSTEM_BLOCK_NULL) ? NULL : watch_storage_get_address(block, data_offset);
+
+            if (data == NULL || !callback(data, length, context)) {
+                completed = false;
+                break;
+            }
+            remaining -= length;
+        }
+    }
+
+    lfs_file_close(lfs, &file);
+
+    return completed;
+}
+
+// cat and b64encode stream files through a buffer of this size, so that dumping a large file never needs
+// more RAM than this.
+#define FILESYSTEM_STREAM_BUF_SZ (256)
+
+// Waits until the shell's output buffer can take another length bytes without dropping any of them.
+// Returns false if there's nobody listening anymore.
+static bool _filesystem_stream_wait(size_t length) {
+#if __EMSCRIPTEN__
+    (void) length;
+    return true;
+#else
+    return cdc_wait_for_write_space(length);
+#endif
+}
+
+static void filesystem_cat(char *filename) {
+    if (!filesystem_file_exists(filename)) {
         printf("cat: %s: No such file\r\n", filename);
+        return;
     }
+
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
+    if (lfs_file_open(lfs, &file, path, LFS_O_RDONLY) < 0) return;
+
+    char buf[FILESYSTEM_STREAM_BUF_SZ];
+    lfs_ssize_t len;
+    while ((len = lfs_file_read(lfs, &file, buf, sizeof(buf))) > 0) {
+        if (!_filesystem_stream_wait(len)) break;
+        fwrite(buf, 1, len, stdout);
+        fflush(stdout);
+    }
+
+    lfs_file_close(lfs, &file);
+    printf("\r\n");
 }
 
 bool filesystem_write_file(char *filename, char *text, int32_t length) {
-    if (filesystem_get_free_space() <= 256) {
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
+    if (_filesystem_get_free_space(lfs) <= 256) {
         printf("No free space!\n");
         return false;    
     }
 
-    int err = lfs_file_open(&eeprom_filesystem, &file, filename, LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC);
+    int err = lfs_file_open(lfs, &file, path, LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC);
     if (err < 0) return false;
-    err = lfs_file_write(&eeprom_filesystem, &file, text, length);
+    err = lfs_file_write(lfs, &file, text, length);
     if (err < 0) return false;
-    return lfs_file_close(&eeprom_filesystem, &file) == LFS_ERR_OK;
+    return lfs_file_close(lfs, &file) == LFS_ERR_OK;
 }
 
 bool filesystem_append_file(char *filename, char *text, int32_t length) {
-    if (filesystem_get_free_space() <= 256) {
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
+    if (_filesystem_get_free_space(lfs) <= 256) {
         printf("No free space!\n");
         return false;    
     }
 
-    int err = lfs_file_open(&eeprom_filesystem, &file, filename, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+    int err = lfs_file_open(lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
     if (err < 0) return false;
-    err = lfs_file_write(&eeprom_filesystem, &file, text, length);
+    err = lfs_file_write(lfs, &file, text, length);
     if (err < 0) return false;
-    return lfs_file_close(&eeprom_filesystem, &file) == LFS_ERR_OK;
+    return lfs_file_close(lfs, &file) == LFS_ERR_OK;
+}
+
+// The stream API keeps its own file handle, so other filesystem calls can still be made while a stream is open.
+static lfs_file_t stream_file;
+static lfs_t *stream_lfs = NULL;
+
+bool filesystem_stream_open(char *filename) {
+    if (stream_lfs != NULL) filesystem_stream_close();
+
+    const char *path = filename;
+    lfs_t *lfs = _filesystem_for_path(&path);
+    if (lfs_file_open(lfs, &stream_file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) < 0) return false;
+    stream_lfs = lfs;
+
+    return true;
+}
+
+bool filesystem_stream_write(uint32_t offset, char *data, int32_t length) {
+    if (stream_lfs == NULL) return false;
+
+    if (lfs_file_seek(stream_lfs, &stream_file, offset, LFS_SEEK_SET) < 0) return false;
+    return lfs_file_write(stream_lfs, &stream_file, data, length) == length;
+}
+
+bool filesystem_stream_close(void) {
+    if (stream_lfs == NULL) return false;
+
+    int err = lfs_file_close(stream_lfs, &stream_file);
+    stream_lfs = NULL;
+
+    return err == LFS_ERR_OK;
 }
 
 int filesystem_cmd_ls(int argc, char *argv[]) {
-    if (argc >= 2) {
-        filesystem_ls(&eeprom_filesystem, argv[1]);
-    } else {
-        filesystem_ls(&eeprom_filesystem, "/");
+    const char *path = (argc >= 2) ? argv[1] : "/";
+    lfs_t *lfs = _filesystem_for_path(&path);
+    filesystem_ls(lfs, path);
+#ifdef HAS_SPI_FLASH
+    if (ext_filesystem_mounted && lfs == &eeprom_filesystem && !strcmp(path, "/")) {
+        printf("dir     0 bytes %s\r\n", EXT_FLASH_MOUNT_POINT + 1);
     }
+#endif
     return 0;
 }
 
@@ -294,27 +622,36 @@ int filesystem_cmd_cat(int argc, char *argv[]) {
 
 int filesystem_cmd_b64encode(int argc, char *argv[]) {
     (void) argc;
-    info.type = 0;
-    lfs_stat(&eeprom_filesystem, argv[1], &info);
-    if (filesystem_file_exists(argv[1])) {
-        if (info.size > 0) {
-            char *buf = malloc(info.size + 1);
-            filesystem_read_file(argv[1], buf, info.size);
-            // print a base 64 encoding of the file, 12 bytes at a time
-            for (lfs_size_t i = 0; i < info.size; i += 12) {
-                lfs_size_t len = min(12, info.size - i);
-                char base64_line[17];
-                b64_encode((unsigned char *)buf + i, len, (unsigned char *)base64_line);
-                printf("%s\n", base64_line);
-                delay_ms(10);
-            }
-            free(buf);
-        } else {
-            printf("\r\n");
-        }
-    } else {
+    if (!filesystem_file_exists(argv[1])) {
         printf("b64encode: %s: No such file\r\n", argv[1]);
+        return 0;
     }
+
+    if (info.size == 0) {
+        printf("\r\n");
+        return 0;
+    }
+
+    const char *path = argv[1];
+    lfs_t *lfs = _filesystem_for_path(&path);
+    if (lfs_file_open(lfs, &file, path, LFS_O_RDONLY) < 0) return 0;
+
+    // print a base 64 encoding of the file, 12 bytes (16 characters) per line. Read a whole number of lines
+    // at a time, so that only the very last line of the file can come up short.
+    char buf[FILESYSTEM_STREAM_BUF_SZ];
+    const lfs_size_t chunk_size = sizeof(buf) - sizeof(buf) % 12;
+    lfs_ssize_t len;
+    while ((len = lfs_file_read(lfs, &file, buf, chunk_size)) > 0) {
+        if (!_filesystem_stream_wait(((len + 11) / 12) * 17)) break;
+        for (lfs_ssize_t i = 0; i < len; i += 12) {
+            char base64_line[17];
+            b64_encode((unsigned char *)buf + i, min(12, len - i), (unsigned char *)base64_line);
+            printf("%s\n", base64_line);
+        }
+        fflush(stdout);
+    }
+
+    lfs_file_close(lfs, &file);
     return 0;
 }
 
@@ -322,6 +659,11 @@ int filesystem_cmd_df(int argc, char *argv[]) {
     (void) argc;
     (void) argv;
     printf("free space: %ld bytes\r\n", filesystem_get_free_space());
+#ifdef HAS_SPI_FLASH
+    if (ext_filesystem_mounted) {
+        printf("%s free space: %ld bytes\r\n", EXT_FLASH_MOUNT_POINT, _filesystem_get_free_space(&ext_filesystem));
+    }
+#endif
     return 0;
 }
 
@@ -332,11 +674,26 @@ int filesystem_cmd_rm(int argc, char *argv[]) {
 }
 
 int filesystem_cmd_format(int argc, char *argv[]) {
-    (void) argc;
-    if(strcmp(argv[1], "YES") == 0) {
+    // make sure the volumes are mounted first, so a later first access doesn't mount them a second time.
+    filesystem_init();
+
+#ifdef HAS_SPI_FLASH
+    if (argc == 3 && strcmp(argv[1], EXT_FLASH_MOUNT_POINT) == 0 && strcmp(argv[2], "YES") == 0) {
+        lfs_unmount(&ext_filesystem);
+        ext_filesystem_mounted = false;
+        int err = lfs_format(&ext_filesystem, &watch_ext_lfs_cfg);
+        if (err < 0) return err;
+        err = lfs_mount(&ext_filesystem, &watch_ext_lfs_cfg);
+        if (err < 0) return err;
+        ext_filesystem_mounted = true;
+        printf("%s re-mounted with %ld bytes free.\r\n", EXT_FLASH_MOUNT_POINT, _filesystem_get_free_space(&ext_filesystem));
+        return 0;
+    }
+#endif
+    if(argc == 2 && strcmp(argv[1], "YES") == 0) {
         return _filesystem_format();
     }
-    printf("usage: format YES\r\n");
+    printf("usage: format [/ext] YES\r\n");
     return 1;
 }
 
@@ -352,7 +709,10 @@ int filesystem_cmd_echo(int argc, char *argv[]) {
         line[line_len] = '\0';
     }
 
-    if (strchr(argv[3], '/')) {
+    // a leading mount point like /ext is fine, but subdirectories below it are not.
+    const char *path = argv[3];
+    _filesystem_for_path(&path);
+    if (strchr(path + (path[0] == '/'), '/')) {
         printf("subdirectories are not supported\r\n");
         return -2;
     }
@@ -369,3 +729,291 @@ int filesystem_cmd_echo(int argc, char *argv[]) {
 
     return 0;
 }
+
+/*
+ * Binary file transfer for the rx and tx commands. The host drives it with utils/file_transfer/file_transfer.py.
+ *
+ * Every frame looks like this, with multi-byte fields little-endian:
+ *   0x7E | type | seq | offset (4 bytes) | length (2 bytes) | payload (length bytes) | CRC-16/CCITT (2 bytes)
+ * The CRC covers everything from type through the end of the payload.
+ *
+ * The protocol is stop-and-wait. The sender sends one DATA frame at a time, carrying the file offset of its payload.
+ * The receiver answers with an ACK carrying the offset it expects next, or a NAK carrying the offset it wants the
+ * sender to go back to. Since every frame names its offset, a lost frame or a lost ACK just means sending it again,
+ * and an interrupted transfer can be resumed from however much the receiver already has.
+ */
+
+#define FILESYSTEM_XFER_SOF (0x7E)
+#define FILESYSTEM_XFER_HEADER_SZ (9)
+#define FILESYSTEM_XFER_MAX_PAYLOAD (128)
+#define FILESYSTEM_XFER_TIMEOUT_SECONDS (2)
+#define FILESYSTEM_XFER_MAX_RETRIES (5)
+
+typedef enum {
+    FILESYSTEM_XFER_READY = 'R',    // transfer is starting; offset is where rx resumes, or the file size for tx.
+    FILESYSTEM_XFER_DATA = 'D',
+    FILESYSTEM_XFER_EOF = 'E',      // offset is the total file size.
+    FILESYSTEM_XFER_ACK = 'A',
+    FILESYSTEM_XFER_NAK = 'N',
+    FILESYSTEM_XFER_CANCEL = 'C',
+} filesystem_xfer_frame_type_t;
+
+typedef enum {
+    FILESYSTEM_XFER_RESULT_OK = 0,
+    FILESYSTEM_XFER_RESULT_TIMEOUT,
+    FILESYSTEM_XFER_RESULT_BAD_FRAME,
+} filesystem_xfer_result_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint32_t offset;
+    uint16_t length;
+    uint8_t payload[FILESYSTEM_XFER_MAX_PAYLOAD];
+} filesystem_xfer_frame_t;
+
+#if !__EMSCRIPTEN__
+
+static uint16_t _filesystem_xfer_crc16(uint16_t crc, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static bool _filesystem_xfer_send(uint8_t type, uint8_t seq, uint32_t offset, const uint8_t *payload, uint16_t length) {
+    uint8_t buf[FILESYSTEM_XFER_HEADER_SZ + FILESYSTEM_XFER_MAX_PAYLOAD + 2];
+
+    buf[0] = FILESYSTEM_XFER_SOF;
+    buf[1] = type;
+    buf[2] = seq;
+    for (uint8_t i = 0; i < 4; i++) buf[3 + i] = offset >> (8 * i);
+    buf[7] = length & 0xFF;
+    buf[8] = length >> 8;
+    if (length) memcpy(buf + FILESYSTEM_XFER_HEADER_SZ, payload, length);
+
+    uint16_t crc = _filesystem_xfer_crc16(0xFFFF, buf + 1, FILESYSTEM_XFER_HEADER_SZ - 1 + length);
+    buf[FILESYSTEM_XFER_HEADER_SZ + length] = crc & 0xFF;
+    buf[FILESYSTEM_XFER_HEADER_SZ + length + 1] = crc >> 8;
+
+    size_t frame_length = FILESYSTEM_XFER_HEADER_SZ + length + 2;
+    if (!cdc_wait_for_write_space(frame_length)) return false;
+    fwrite(buf, 1, frame_length, stdout);
+    fflush(stdout);
+
+    return true;
+}
+
+// Returns the next byte from the host, or -1 if nothing arrives before the deadline.
+static int _filesystem_xfer_getc(rtc_counter_t deadline) {
+    while (true) {
+        int c = getchar();
+        if (c >= 0) return c;
+        clearerr(stdin);
+        if ((int32_t)(watch_rtc_get_counter() - deadline) >= 0) return -1;
+        if (!cdc_service()) return -1;
+    }
+}
+
+static filesystem_xfer_result_t _filesystem_xfer_receive(filesystem_xfer_frame_t *frame) {
+    rtc_counter_t deadline = watch_rtc_get_counter() + FILESYSTEM_XFER_TIMEOUT_SECONDS * watch_rtc_get_frequency();
+    uint8_t header[FILESYSTEM_XFER_HEADER_SZ - 1];
+    int c;
+
+    // skip anything that isn't the start of a frame, like stray line endings from the command line.
+    do {
+        if ((c = _filesystem_xfer_getc(deadline)) < 0) return FILESYSTEM_XFER_RESULT_TIMEOUT;
+    } while (c != FILESYSTEM_XFER_SOF);
+
+    for (uint8_t i = 0; i < sizeof(header); i++) {
+        if ((c = _filesystem_xfer_getc(deadline)) < 0) return FILESYSTEM_XFER_RESULT_TIMEOUT;
+        header[i] = c;
+    }
+
+    frame->type = header[0];
+    frame->seq = header[1];
+    frame->offset = header[2] | (header[3] << 8) | ((uint32_t)header[4] << 16) | ((uint32_t)header[5] << 24);
+    frame->length = header[6] | (header[7] << 8);
+    if (frame->length > FILESYSTEM_XFER_MAX_PAYLOAD) return FILESYSTEM_XFER_RESULT_BAD_FRAME;
+
+    for (uint16_t i = 0; i < frame->length; i++) {
+        if ((c = _filesystem_xfer_getc(deadline)) < 0) return FILESYSTEM_XFER_RESULT_TIMEOUT;
+        frame->payload[i] = c;
+    }
+
+    uint16_t crc = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        if ((c = _filesystem_xfer_getc(deadline)) < 0) return FILESYSTEM_XFER_RESULT_TIMEOUT;
+        crc |= c << (8 * i);
+    }
+
+    uint16_t expected_crc = _filesystem_xfer_crc16(0xFFFF, header, sizeof(header));
+    expected_crc = _filesystem_xfer_crc16(expected_crc, frame->payload, frame->length);
+    if (crc != expected_crc) return FILESYSTEM_XFER_RESULT_BAD_FRAME;
+
+    return FILESYSTEM_XFER_RESULT_OK;
+}
+
+#endif
+
+int filesystem_cmd_rx(int argc, char *argv[]) {
+#if __EMSCRIPTEN__
+    (void) argc;
+    (void) argv;
+    printf("rx is not available in the simulator\r\n");
+    return 1;
+#else
+    bool resume = (argc >= 3) && !strcmp(argv[2], "resume");
+
+    const char *path = argv[1];
+    lfs_t *lfs = _filesystem_for_path(&path);
+    int flags = LFS_O_WRONLY | LFS_O_CREAT | (resume ? LFS_O_APPEND : LFS_O_TRUNC);
+    if (lfs_file_open(lfs, &file, path, flags) < 0) {
+        _filesystem_xfer_send(FILESYSTEM_XFER_CANCEL, 0, 0, NULL, 0);
+        return 1;
+    }
+
+    uint32_t offset = lfs_file_size(lfs, &file);
+    uint8_t last_type = FILESYSTEM_XFER_READY;
+    uint8_t last_seq = 0;
+    uint8_t retries = 0;
+    bool done = false;
+    int retval = 1;
+
+    static filesystem_xfer_frame_t frame;
+
+    _filesystem_xfer_send(FILESYSTEM_XFER_READY, 0, offset, NULL, 0);
+
+    while (!done && retries <= FILESYSTEM_XFER_MAX_RETRIES) {
+        filesystem_xfer_result_t result = _filesystem_xfer_receive(&frame);
+        if (result == FILESYSTEM_XFER_RESULT_TIMEOUT) {
+            // repeat whatever we said last, in case the host never heard it.
+            retries++;
+            if (!_filesystem_xfer_send(last_type, last_seq, offset, NULL, 0)) break;
+            continue;
+        } else if (result == FILESYSTEM_XFER_RESULT_BAD_FRAME) {
+            retries++;
+            last_type = FILESYSTEM_XFER_NAK;
+            _filesystem_xfer_send(last_type, frame.seq, offset, NULL, 0);
+            continue;
+        }
+
+        retries = 0;
+        last_seq = frame.seq;
+
+        switch (frame.type) {
+            case FILESYSTEM_XFER_DATA:
+                if (frame.offset == offset) {
+                    if (lfs_file_write(lfs, &file, frame.payload, frame.length) != frame.length) {
+                        // most likely out of space; nothing the host can do about that.
+                        _filesystem_xfer_send(FILESYSTEM_XFER_CANCEL, frame.seq, offset, NULL, 0);
+                        done = true;
+                        break;
+                    }
+                    offset += frame.length;
+                    last_type = FILESYSTEM_XFER_ACK;
+                } else if (frame.offset < offset) {
+                    // a repeat of something we already have: our ACK must have gotten lost.
+                    last_type = FILESYSTEM_XFER_ACK;
+                } else {
+                    last_type = FILESYSTEM_XFER_NAK;
+                }
+                _filesystem_xfer_send(last_type, frame.seq, offset, NULL, 0);
+                break;
+            case FILESYSTEM_XFER_EOF:
+                last_type = (frame.offset == offset) ? FILESYSTEM_XFER_ACK : FILESYSTEM_XFER_NAK;
+                _filesystem_xfer_send(last_type, frame.seq, offset, NULL, 0);
+                if (last_type == FILESYSTEM_XFER_ACK) {
+                    done = true;
+                    retval = 0;
+                }
+                break;
+            case FILESYSTEM_XFER_CANCEL:
+                done = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // whatever we received is kept, so an interrupted transfer can pick up where it left off with "resume".
+    lfs_file_close(lfs, &file);
+
+    return retval;
+#endif
+}
+
+int filesystem_cmd_tx(int argc, char *argv[]) {
+#if __EMSCRIPTEN__
+    (void) argc;
+    (void) argv;
+    printf("tx is not available in the simulator\r\n");
+    return 1;
+#else
+    if (!filesystem_file_exists(argv[1])) {
+        _filesystem_xfer_send(FILESYSTEM_XFER_CANCEL, 0, 0, NULL, 0);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    lfs_t *lfs = _filesystem_for_path(&path);
+    if (lfs_file_open(lfs, &file, path, LFS_O_RDONLY) < 0) {
+        _filesystem_xfer_send(FILESYSTEM_XFER_CANCEL, 0, 0, NULL, 0);
+        return 1;
+    }
+
+    uint32_t size = lfs_file_size(lfs, &file);
+    uint32_t offset = (argc >= 3) ? strtoul(argv[2], NULL, 10) : 0;
+    if (offset > size) offset = size;
+
+    uint8_t payload[FILESYSTEM_XFER_MAX_PAYLOAD];
+    uint8_t seq = 0;
+    uint8_t retries = 0;
+    int retval = 1;
+
+    static filesystem_xfer_frame_t frame;
+
+    _filesystem_xfer_send(FILESYSTEM_XFER_READY, seq, size, NULL, 0);
+
+    while (retries <= FILESYSTEM_XFER_MAX_RETRIES) {
+        lfs_ssize_t length = 0;
+        if (offset < size) {
+            lfs_file_seek(lfs, &file, offset, LFS_SEEK_SET);
+            length = lfs_file_read(lfs, &file, payload, FILESYSTEM_XFER_MAX_PAYLOAD);
+            if (length < 0) {
+                _filesystem_xfer_send(FILESYSTEM_XFER_CANCEL, seq, offset, NULL, 0);
+                break;
+            }
+            if (!_filesystem_xfer_send(FILESYSTEM_XFER_DATA, seq, offset, payload, length)) break;
+        } else {
+            if (!_filesystem_xfer_send(FILESYSTEM_XFER_EOF, seq, size, NULL, 0)) break;
+        }
+
+        filesystem_xfer_result_t result = _filesystem_xfer_receive(&frame);
+        if (result != FILESYSTEM_XFER_RESULT_OK) {
+            // send the same frame again.
+            retries++;
+            continue;
+        }
+
+        retries = 0;
+        if (frame.type == FILESYSTEM_XFER_CANCEL) break;
+        if (frame.type == FILESYSTEM_XFER_ACK && offset == size && frame.offset == size) {
+            retval = 0;
+            break;
+        }
+        if ((frame.type == FILESYSTEM_XFER_ACK || frame.type == FILESYSTEM_XFER_NAK) && frame.offset <= size) {
+            // either way, the host tells us where it wants us to continue from.
+            if (frame.type == FILESYSTEM_XFER_ACK && frame.offset != offset) seq++;
+            offset = frame.offset;
+        }
+    }
+
+    lfs_file_close(lfs, &file);
+
+    return retval;
+#endif
+}
@@ -29,6 +29,8 @@
 #include "watch.h"
 
 /** @brief Initializes and mounts the tiny 8kb filesystem, formatting it if need be.
+  * @details You don't have to call this before using the filesystem: the first file access mounts it
+  *          automatically. Calling it again after the first attempt does nothing.
   * @return true if the filesystem was mounted successfully.
   */
 bool filesystem_init(void);
@@ -69,6 +71,46 @@ int32_t filesystem_get_file_size(char *filename);
   */
 bool filesystem_read_file(char *filename, char *buf, int32_t length);
 
+/** @brief Reads part of a file into a buffer
+  * @param filename the file you wish to read
+  * @param offset Where in the file to start reading
+  * @param buf A buffer of at least length bytes
+  * @param length The maximum number of bytes to read
+  * @return the number of bytes read, which is less than length at the end of the file, or -1 on error.
+  * @note Unlike filesystem_read_file, this does not zero the buffer or null-terminate what it reads.
+  */
+int32_t filesystem_read_file_at(char *filename, int32_t offset, char *buf, int32_t length);
+
+/** @brief Gets the name of a file in the root directory, for walking through all the files on the watch.
+  * @param index Which file you want; 0 for the first one. Directories are skipped.
+  * @param buf A buffer to hold the file name.
+  * @param length The size of buf; longer names are truncated.
+  * @return true if there is a file with this index; false if there are fewer files than that.
+  */
+bool filesystem_get_file_name(uint16_t index, char *buf, size_t length);
+
+/** @brief Callback for filesystem_map_file.
+  * @param data A pointer to the next span of the file's contents. This may point directly into flash, so it
+  *             must not be written to, and it is only valid until the filesystem is next modified.
+  * @param length The number of bytes in this span.
+  * @param context The context pointer passed to filesystem_map_file.
+  * @return true to continue to the next span; false to stop early.
+  */
+typedef bool (*filesystem_map_cb_t)(const uint8_t *data, uint32_t length, void *context);
+
+/** @brief Visits a file's contents in place, without reading the whole file into a RAM buffer.
+  * @details Large, read-only assets (word lists, tables, tune libraries) can be scanned this way without
+  *          allocating anything. The file is presented as a series of contiguous spans, one per flash row,
+  *          each pointing directly into the storage area. Very small files that littlefs stores inline in
+  *          their directory entry are copied through a short stack buffer instead.
+  * @param filename the file you wish to read
+  * @param callback A function that will be called with each span of the file, in order.
+  * @param context An arbitrary pointer that will be passed to the callback.
+  * @return true if every span of the file was visited; false if the file does not exist, could not be read,
+  *         or the callback returned false.
+  */
+bool filesystem_map_file(char *filename, filesystem_map_cb_t callback, void *context);
+
 /** @brief Reads a line from a file into a buffer
   * @param filename the file you wish to read
   * @param buf A buffer of at least length + 1 bytes; the file will be read into this buffer,
@@ -96,6 +138,29 @@ bool filesystem_write_file(char *filename, char *text, int32_t length);
   */
 bool filesystem_append_file(char *filename, char *text, int32_t length);
 
+/** @brief Creates (or truncates) a file and keeps it open for a series of writes.
+  * @details For data that arrives in pieces, like a file coming in over IR: each piece can be written as it
+  *          arrives, without having to buffer the whole file in RAM or reopen the file for every piece.
+  *          Only one stream can be open at a time; opening another one closes the first.
+  * @param filename the file you wish to write
+  * @return true if the file was opened successfully; false otherwise
+  */
+bool filesystem_stream_open(char *filename);
+
+/** @brief Writes to the file opened with filesystem_stream_open.
+  * @param offset Where in the file to write. Writing past the end of the file fills the gap with zeroes,
+  *               so pieces can be written out of order.
+  * @param data The bytes to write
+  * @param length The number of bytes to write
+  * @return true if the write was successful; false otherwise
+  */
+bool filesystem_stream_write(uint32_t offset, char *data, int32_t length);
+
+/** @brief Closes the file opened with filesystem_stream_open, committing everything written to it.
+  * @return true if the file was closed successfully; false otherwise
+  */
+bool filesystem_stream_close(void);
+
 int filesystem_cmd_ls(int argc, char *argv[]);
 int filesystem_cmd_cat(int argc, char *argv[]);
 int filesystem_cmd_b64encode(int argc, char *argv[]);
@@ -103,3 +168,5 @@ int filesystem_cmd_df(int argc, char *argv[]);
 int filesystem_cmd_rm(int argc, char *argv[]);
 int filesystem_cmd_format(int argc, char *argv[]);
 int filesystem_cmd_echo(int argc, char *argv[]);
+int filesystem_cmd_rx(int argc, char *argv[]);
+int filesystem_cmd_tx(int argc, char *argv[]);
@@ -0,0 +1,320 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Host tests for the filesystem layer, on the simulator's RAM-backed RWWEE and SPI flash. From this directory:
+ *
+ *     make test
+ *
+ * `make bench` times scanning a file in place with filesystem_map_file against reading it through littlefs
+ * into a RAM buffer. The RAM array stands in for the memory-mapped RWWEE, so the numbers only say how much
+ * work littlefs's read path adds on top of the bytes themselves, not how fast either is on the watch.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include "filesystem.h"
+#include "lfs.h"
+#include "unity.h"
+
+extern uint8_t storage[NVMCTRL_ROW_SIZE * NVMCTRL_RWWEE_PAGES];
+extern lfs_t eeprom_filesystem;
+extern uint8_t spi_flash_storage[1UL << SPI_FLASH_RAM_SIZE_LOG2];
+extern struct lfs_config watch_ext_lfs_cfg;
+
+#define MAX_FILE_SIZE (4096)
+
+typedef struct {
+    uint8_t data[MAX_FILE_SIZE];
+    uint32_t length;
+    uint16_t spans;
+    bool in_place;  // every span pointed straight into the storage array
+} mapped_file_t;
+
+static bool _collect_span(const uint8_t *data, uint32_t length, void *context) {
+    mapped_file_t *mapped = (mapped_file_t *)context;
+    if (mapped->length + length > sizeof(mapped->data)) return false;
+
+    memcpy(mapped->data + mapped->length, data, length);
+    mapped->length += length;
+    mapped->spans++;
+    if (data < storage || data + length > storage + sizeof(storage)) mapped->in_place = false;
+
+    return true;
+}
+
+static bool _stop_after_first_span(const uint8_t *data, uint32_t length, void *context) {
+    (void) data;
+    (void) length;
+    (*(uint16_t *)context)++;
+    return false;
+}
+
+// bytes that look nothing like littlefs's own metadata, so a span from the wrong place can't match by accident.
+static void _fill(char *buf, uint32_t length, uint32_t seed) {
+    for (uint32_t i = 0; i < length; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        buf[i] = seed;
+    }
+}
+
+// reads the whole file with lfs_file_read, which is what the mapped bytes have to match.
+static uint32_t _read_through_littlefs(const char *filename, uint8_t *buf) {
+    lfs_file_t file;
+    TEST_ASSERT_EQUAL_INT(0, lfs_file_open(&eeprom_filesystem, &file, filename, LFS_O_RDONLY));
+    lfs_ssize_t length = lfs_file_read(&eeprom_filesystem, &file, buf, MAX_FILE_SIZE);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, length);
+    lfs_file_close(&eeprom_filesystem, &file);
+
+    return length;
+}
+
+// maps the file, checks it against lfs_file_read, and returns how many spans it came in.
+static uint16_t _check_mapping(char *filename, uint32_t expected_length, bool expect_in_place) {
+    static uint8_t expected[MAX_FILE_SIZE];
+    static mapped_file_t mapped;
+
+    TEST_ASSERT_EQUAL_UINT32(expected_length, _read_through_littlefs(filename, expected));
+
+    memset(&mapped, 0, sizeof(mapped));
+    mapped.in_place = true;
+    TEST_ASSERT_TRUE(filesystem_map_file(filename, _collect_span, &mapped));
+    TEST_ASSERT_EQUAL_UINT32(expected_length, mapped.length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, mapped.data, expected_length);
+    TEST_ASSERT_EQUAL(expect_in_place, mapped.in_place);
+
+    return mapped.spans;
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(filesystem_init());
+}
+
+void tearDown(void) {
+}
+
+void test_map_inline_file(void) {
+    // small enough that littlefs keeps it in its directory entry, so it has to be copied out.
+    char data[20];
+    _fill(data, sizeof(data), 1);
+    TEST_ASSERT_TRUE(filesystem_write_file("inline.bin", data, sizeof(data)));
+
+    _check_mapping("inline.bin", sizeof(data), false);
+
+    filesystem_rm("inline.bin");
+}
+
+void test_map_single_block_file(void) {
+    char data[200];
+    _fill(data, sizeof(data), 2);
+    TEST_ASSERT_TRUE(filesystem_write_file("single.bin", data, sizeof(data)));
+
+    TEST_ASSERT_EQUAL_UINT16(1, _check_mapping("single.bin", sizeof(data), true));
+
+    filesystem_rm("single.bin");
+}
+
+void test_map_multi_block_file(void) {
+    // long enough for skip pointers of every length up to 4 blocks back.
+    static char data[2400];
+    _fill(data, sizeof(data), 3);
+    TEST_ASSERT_TRUE(filesystem_write_file("multi.bin", data, sizeof(data)));
+
+    // each block after the first gives up a few bytes to its skip pointers, so there can be one more than this.
+    uint16_t spans = _check_mapping("multi.bin", sizeof(data), true);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT16((sizeof(data) + NVMCTRL_ROW_SIZE - 1) / NVMCTRL_ROW_SIZE, spans);
+
+    filesystem_rm("multi.bin");
+}
+
+void test_map_appended_file(void) {
+    // appending rewrites the tail block and extends the skip-list from there, rather than writing it in one go.
+    char data[300];
+    for (uint32_t i = 0; i < 5; i++) {
+        _fill(data, sizeof(data), 10 + i);
+        TEST_ASSERT_TRUE(filesystem_append_file("appended.bin", data, sizeof(data)));
+    }
+
+    _check_mapping("appended.bin", 5 * sizeof(data), true);
+
+    filesystem_rm("appended.bin");
+}
+
+void test_map_stops_when_asked(void) {
+    static char data[1000];
+    _fill(data, sizeof(data), 4);
+    TEST_ASSERT_TRUE(filesystem_write_file("stop.bin", data, sizeof(data)));
+
+    uint16_t calls = 0;
+    TEST_ASSERT_FALSE(filesystem_map_file("stop.bin", _stop_after_first_span, &calls));
+    TEST_ASSERT_EQUAL_UINT16(1, calls);
+    TEST_ASSERT_FALSE(filesystem_map_file("missing.bin", _stop_after_first_span, &calls));
+
+    filesystem_rm("stop.bin");
+}
+
+void test_ext_volume_is_sized_from_jedec_id(void) {
+    TEST_ASSERT_EQUAL_UINT32((1UL << SPI_FLASH_RAM_SIZE_LOG2) / 4096, watch_ext_lfs_cfg.block_count);
+}
+
+void test_ext_volume_is_formatted_on_first_mount(void) {
+    // the flash starts out erased, so mounting it the first time has to lay down a superblock in block 0 or 1.
+    const char magic[] = "littlefs";
+    bool found = false;
+    for (uint32_t i = 0; !found && i + sizeof(magic) - 1 <= 2 * 4096; i++) {
+        found = !memcmp(spi_flash_storage + i, magic, sizeof(magic) - 1);
+    }
+    TEST_ASSERT_TRUE(found);
+}
+
+void test_ext_write_and_read(void) {
+    char line[] = "1700000000,12,-3,1021\n";
+    char buf[sizeof(line)];
+    TEST_ASSERT_TRUE(filesystem_write_file("/ext/log.csv", line, strlen(line)));
+    TEST_ASSERT_TRUE(filesystem_append_file("/ext/log.csv", line, strlen(line)));
+    TEST_ASSERT_EQUAL_INT32(2 * strlen(line), filesystem_get_file_size("/ext/log.csv"));
+
+    TEST_ASSERT_TRUE(filesystem_read_file("/ext/log.csv", buf, strlen(line)));
+    TEST_ASSERT_EQUAL_STRING(line, buf);
+
+    TEST_ASSERT_TRUE(filesystem_rm("/ext/log.csv"));
+}
+
+void test_ext_multi_sector_file(void) {
+    // more than two 4 KB sectors, so the file spans blocks and its pages are programmed across sector boundaries.
+    static char data[10000];
+    static char buf[sizeof(data)];
+    _fill(data, sizeof(data), 6);
+    TEST_ASSERT_TRUE(filesystem_write_file("/ext/big.bin", data, sizeof(data)));
+
+    TEST_ASSERT_TRUE(filesystem_read_file("/ext/big.bin", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_MEMORY(data, buf, sizeof(data));
+
+    // the external volume isn't memory-mapped, so mapping a file there copies it out through littlefs. The file is
+    // bigger than the collector's buffer, so the collector stops it once it has the first MAX_FILE_SIZE bytes.
+    static mapped_file_t mapped;
+    memset(&mapped, 0, sizeof(mapped));
+    mapped.in_place = true;
+    TEST_ASSERT_FALSE(filesystem_map_file("/ext/big.bin", _collect_span, &mapped));
+    TEST_ASSERT_EQUAL_MEMORY(data, mapped.data, MAX_FILE_SIZE);
+    TEST_ASSERT_FALSE(mapped.in_place);
+
+    TEST_ASSERT_TRUE(filesystem_rm("/ext/big.bin"));
+}
+
+void test_ext_files_stay_off_rwwee(void) {
+    char text[] = "ext only";
+    TEST_ASSERT_TRUE(filesystem_write_file("/ext/only.txt", text, strlen(text)));
+
+    TEST_ASSERT_TRUE(filesystem_file_exists("/ext/only.txt"));
+    TEST_ASSERT_FALSE(filesystem_file_exists("only.txt"));
+
+    TEST_ASSERT_TRUE(filesystem_rm("/ext/only.txt"));
+}
+
+void test_ext_format(void) {
+    char text[] = "to be erased";
+    char *argv[] = {"format", "/ext", "YES"};
+    TEST_ASSERT_TRUE(filesystem_write_file("/ext/erase.txt", text, strlen(text)));
+    TEST_ASSERT_TRUE(filesystem_write_file("kept.txt", text, strlen(text)));
+
+    TEST_ASSERT_EQUAL_INT(0, filesystem_cmd_format(3, argv));
+
+    TEST_ASSERT_FALSE(filesystem_file_exists("/ext/erase.txt"));
+    TEST_ASSERT_TRUE(filesystem_file_exists("kept.txt"));
+    TEST_ASSERT_TRUE(filesystem_rm("kept.txt"));
+}
+
+typedef struct {
+    uint8_t needle;
+    uint32_t matches;
+} scan_t;
+
+static bool _scan_span(const uint8_t *data, uint32_t length, void *context) {
+    scan_t *scan = (scan_t *)context;
+    for (uint32_t i = 0; i < length; i++) if (data[i] == scan->needle) scan->matches++;
+    return true;
+}
+
+// Scans a 3 KB table for a byte, the way a face would look something up in a word list, both ways.
+static void _benchmark(void) {
+    const uint32_t rounds = 5000;
+    static char table[3072];
+    uint8_t buf[64];
+    _fill(table, sizeof(table), 5);
+    filesystem_write_file("table.bin", table, sizeof(table));
+
+    scan_t mapped_scan = { .needle = 0x42 };
+    clock_t start = clock();
+    for (uint32_t round = 0; round < rounds; round++) filesystem_map_file("table.bin", _scan_span, &mapped_scan);
+    double mapped_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    scan_t read_scan = { .needle = 0x42 };
+    start = clock();
+    for (uint32_t round = 0; round < rounds; round++) {
+        lfs_file_t file;
+        lfs_ssize_t length;
+        lfs_file_open(&eeprom_filesystem, &file, "table.bin", LFS_O_RDONLY);
+        while ((length = lfs_file_read(&eeprom_filesystem, &file, buf, sizeof(buf))) > 0) _scan_span(buf, length, &read_scan);
+        lfs_file_close(&eeprom_filesystem, &file);
+    }
+    double read_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    filesystem_rm("table.bin");
+
+    if (mapped_scan.matches != read_scan.matches) {
+        printf("mismatch: mapped scan found %u, read scan found %u\n", mapped_scan.matches, read_scan.matches);
+        exit(1);
+    }
+    double megabytes = (double)rounds * sizeof(table) / 1e6;
+    printf("filesystem_map_file:        %8.1f MB/s\n", megabytes / mapped_seconds);
+    printf("lfs_file_read, 64 B chunks: %8.1f MB/s\n", megabytes / read_seconds);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "bench")) {
+        filesystem_init();
+        _benchmark();
+        return 0;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_map_inline_file);
+    RUN_TEST(test_map_single_block_file);
+    RUN_TEST(test_map_multi_block_file);
+    RUN_TEST(test_map_appended_file);
+    RUN_TEST(test_map_stops_when_asked);
+    RUN_TEST(test_ext_volume_is_sized_from_jedec_id);
+    RUN_TEST(test_ext_volume_is_formatted_on_first_mount);
+    RUN_TEST(test_ext_write_and_read);
+    RUN_TEST(test_ext_multi_sector_file);
+    RUN_TEST(test_ext_files_stay_off_rwwee);
+    RUN_TEST(test_ext_format);
+    return UNITY_END();
+}
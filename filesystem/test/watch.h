@@ -0,0 +1,45 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// Just enough of watch.h to build filesystem.c and the simulator's watch_storage.c on the host. The real
+// header pulls in the whole HAL, but filesystem.c built for the simulator only needs the storage API, so
+// that's all this declares; keep it in step with watch-library/shared/watch/watch_storage.h.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define NVMCTRL_ROW_SIZE 256
+#define NVMCTRL_PAGE_SIZE 64
+#define NVMCTRL_RWWEE_PAGES 128
+
+bool watch_storage_read(uint32_t row, uint32_t offset, uint8_t *buffer, uint32_t size);
+const uint8_t *watch_storage_get_address(uint32_t row, uint32_t offset);
+bool watch_storage_write(uint32_t row, uint32_t offset, const uint8_t *buffer, uint32_t size);
+bool watch_storage_erase(uint32_t row);
+bool watch_storage_is_busy(void);
+bool watch_storage_sync(void);
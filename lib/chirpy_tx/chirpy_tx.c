@@ -29,18 +29,33 @@
 #include "chirpy_tx.h"
 
 static const uint32_t chirpy_min_freq = 2500;
-static const uint32_t chirpy_freq_step = 250;
+
+// Tones of the fast profile are this far apart; legacy tones are every other one of them.
+static const uint32_t chirpy_freq_step = 125;
 
 // This many bytes are followed by a CRC and block separator
 // It's a multiple of 3 so no bits are wasted (a tone encodes 3 bits)
 // Last block can be shorter
 static const uint8_t chirpy_default_block_size = 15;
 
+// Same for the fast profile, where a tone encodes 4 bits
+static const uint8_t chirpy_fast_block_size = 16;
+
 // The dedicated control tone. This is the highest tone index.
 static const uint8_t chirpy_control_tone = 8;
+static const uint8_t chirpy_fast_control_tone = 16;
+
+// Tone durations, in ticks of 64 Hz
+static const uint8_t chirpy_default_tone_ticks = 3;
+static const uint8_t chirpy_fast_tone_ticks = 2;
 
-// Pre-computed tone periods. This is allocated and populated on-demand.
-static uint32_t *chirpy_tone_periods = NULL;
+static const uint8_t chirpy_default_bits_per_tone = 3;
+static const uint8_t chirpy_fast_bits_per_tone = 4;
+
+// Pre-computed tone periods for the fast alphabet. This is populated on-demand.
+// No division at play time: the buzzer source runs in an interrupt, and the M0+ has no hardware divider.
+static uint16_t chirpy_tone_periods[17];
+static bool chirpy_tone_periods_ready = false;
 
 uint8_t chirpy_crc8(const uint8_t *addr, uint16_t len) {
     uint8_t crc = 0;
@@ -60,6 +75,14 @@ uint8_t chirpy_update_crc8(uint8_t next_byte, uint8_t crc) {
     return crc;
 }
 
+static inline uint8_t _chirpy_control_tone(chirpy_encoder_state_t *ces) {
+    return ces->profile == CHIRPY_PROFILE_FAST ? chirpy_fast_control_tone : chirpy_control_tone;
+}
+
+static inline uint8_t _chirpy_bits_per_tone(chirpy_encoder_state_t *ces) {
+    return ces->profile == CHIRPY_PROFILE_FAST ? chirpy_fast_bits_per_tone : chirpy_default_bits_per_tone;
+}
+
 static void _chirpy_append_tone(chirpy_encoder_state_t *ces, uint8_t tone) {
     // This is BAD and should never happen. But if it does, we'd rather
     // create a corrupt transmission than corrupt memory #$^@
@@ -70,13 +93,7 @@ static void _chirpy_append_tone(chirpy_encoder_state_t *ces, uint8_t tone) {
 }
 
 void chirpy_init_encoder(chirpy_encoder_state_t *ces, chirpy_get_next_byte_t get_next_byte) {
-    memset(ces, 0, sizeof(chirpy_encoder_state_t));
-    ces->block_size = chirpy_default_block_size;
-    ces->get_next_byte = get_next_byte;
-    _chirpy_append_tone(ces, 8);
-    _chirpy_append_tone(ces, 0);
-    _chirpy_append_tone(ces, 8);
-    _chirpy_append_tone(ces, 0);
+    chirpy_init_encoder_with_profile(ces, get_next_byte, CHIRPY_PROFILE_LEGACY);
 }
 
 static uint8_t _chirpy_retrieve_next_tone(chirpy_encoder_state_t *ces) {
@@ -90,17 +107,27 @@ static uint8_t _chirpy_retrieve_next_tone(chirpy_encoder_state_t *ces) {
         ces->tone_pos = 0;
         ces->tone_count = 0;
     }
+
+    // The preamble and header go out at legacy speed, whatever the profile
+    if (ces->header_tones > 0) {
+        --ces->header_tones;
+        ces->tone_ticks = chirpy_default_tone_ticks;
+    } else {
+        ces->tone_ticks = ces->profile == CHIRPY_PROFILE_FAST ? chirpy_fast_tone_ticks : chirpy_default_tone_ticks;
+    }
     return res;
 }
 
-static void _chirpy_encode_bits(chirpy_encoder_state_t *ces, uint8_t force_partial) {
+// Turns the top bits_per_tone bits of the bit buffer into tones. Tone indices are multiplied by tone_step,
+// so that the header of a fast transmission can use only tones that are also in the legacy alphabet.
+static void _chirpy_encode_bits_with(chirpy_encoder_state_t *ces, uint8_t force_partial, uint8_t bits_per_tone, uint8_t tone_step) {
     while (ces->bit_count > 0) {
-        if (ces->bit_count < 3 && !force_partial) break;
-        uint8_t tone = (uint8_t)(ces->bits >> 13);
-        _chirpy_append_tone(ces, tone);
-        if (ces->bit_count >= 3) {
-            ces->bits <<= 3;
-            ces->bit_count -= 3;
+        if (ces->bit_count < bits_per_tone && !force_partial) break;
+        uint8_t tone = (uint8_t)(ces->bits >> (16 - bits_per_tone));
+        _chirpy_append_tone(ces, tone * tone_step);
+        if (ces->bit_count >= bits_per_tone) {
+            ces->bits <<= bits_per_tone;
+            ces->bit_count -= bits_per_tone;
         } else {
             ces->bits = 0;
             ces->bit_count = 0;
@@ -108,8 +135,37 @@ static void _chirpy_encode_bits(chirpy_encoder_state_t *ces, uint8_t force_parti
     }
 }
 
+static void _chirpy_encode_bits(chirpy_encoder_state_t *ces, uint8_t force_partial) {
+    _chirpy_encode_bits_with(ces, force_partial, _chirpy_bits_per_tone(ces), 1);
+}
+
+void chirpy_init_encoder_with_profile(chirpy_encoder_state_t *ces, chirpy_get_next_byte_t get_next_byte, chirpy_profile_t profile) {
+    memset(ces, 0, sizeof(chirpy_encoder_state_t));
+    ces->profile = profile;
+    ces->block_size = profile == CHIRPY_PROFILE_FAST ? chirpy_fast_block_size : chirpy_default_block_size;
+    ces->get_next_byte = get_next_byte;
+    ces->tone_ticks = chirpy_default_tone_ticks;
+
+    uint8_t control_tone = _chirpy_control_tone(ces);
+    _chirpy_append_tone(ces, control_tone);
+    _chirpy_append_tone(ces, 0);
+    _chirpy_append_tone(ces, control_tone);
+    _chirpy_append_tone(ces, 0);
+
+    if (profile == CHIRPY_PROFILE_FAST) {
+        // Header byte between two control tones, encoded like legacy data
+        _chirpy_append_tone(ces, control_tone);
+        ces->bits = (chirpy_fast_bits_per_tone << 4) | chirpy_fast_tone_ticks;
+        ces->bits <<= 8;
+        ces->bit_count = 8;
+        _chirpy_encode_bits_with(ces, 1, chirpy_default_bits_per_tone, 2);
+        _chirpy_append_tone(ces, control_tone);
+    }
+    ces->header_tones = ces->tone_count;
+}
+
 static void _chirpy_finish_block(chirpy_encoder_state_t *ces) {
-    _chirpy_append_tone(ces, chirpy_control_tone);
+    _chirpy_append_tone(ces, _chirpy_control_tone(ces));
     ces->bits = ces->crc;
     ces->bits <<= 8;
     ces->bit_count = 8;
@@ -117,14 +173,13 @@ static void _chirpy_finish_block(chirpy_encoder_state_t *ces) {
     ces->bit_count = 0;
     ces->crc = 0;
     ces->block_len = 0;
-    _chirpy_append_tone(ces, chirpy_control_tone);
+    _chirpy_append_tone(ces, _chirpy_control_tone(ces));
 }
 
 static void _chirpy_finish_transmission(chirpy_encoder_state_t *ces) {
-    _chirpy_append_tone(ces, chirpy_control_tone);
-    _chirpy_append_tone(ces, chirpy_control_tone);
+    _chirpy_append_tone(ces, _chirpy_control_tone(ces));
+    _chirpy_append_tone(ces, _chirpy_control_tone(ces));
 }
-
 uint8_t chirpy_get_next_tone(chirpy_encoder_state_t *ces) {
     // If there are tones left in the buffer, keep sending those
     if (ces->tone_pos < ces->tone_count)
@@ -162,18 +217,47 @@ uint8_t chirpy_get_next_tone(chirpy_encoder_state_t *ces) {
     return _chirpy_retrieve_next_tone(ces);
 }
 
-uint16_t chirpy_get_tone_period(uint8_t tone) {
+static uint16_t _chirpy_get_fast_tone_period(uint8_t tone) {
     // Create pre-computed tone periods array on first use
-    if (chirpy_tone_periods == NULL) {
-      chirpy_tone_periods = malloc((chirpy_control_tone + 1) * sizeof(uint32_t));
-      for (uint8_t i = 0; i < chirpy_control_tone + 1; ++i) {
+    if (!chirpy_tone_periods_ready) {
+      for (uint8_t i = 0; i < chirpy_fast_control_tone + 1; ++i) {
         uint32_t freq = chirpy_min_freq + i * chirpy_freq_step;
-        uint16_t period = 1000000 / freq;
-        chirpy_tone_periods[i] = period;
+        chirpy_tone_periods[i] = 1000000 / freq;
       }
+      chirpy_tone_periods_ready = true;
     }
     // Return pre-computed value, but be paranoid about indexing into array
+    if (tone > chirpy_fast_control_tone)
+      tone = chirpy_fast_control_tone;
+    return chirpy_tone_periods[tone];
+}
+
+uint16_t chirpy_get_tone_period(uint8_t tone) {
     if (tone > chirpy_control_tone)
       tone = chirpy_control_tone;
-    return chirpy_tone_periods[tone];
+    return _chirpy_get_fast_tone_period(tone * 2);
+}
+
+uint16_t chirpy_get_encoder_tone_period(const chirpy_encoder_state_t *ces, uint8_t tone) {
+    if (ces->profile == CHIRPY_PROFILE_FAST)
+      return _chirpy_get_fast_tone_period(tone);
+    return chirpy_get_tone_period(tone);
+}
+
+uint8_t chirpy_get_encoder_tone_ticks(const chirpy_encoder_state_t *ces) {
+    return ces->tone_ticks;
+}
+
+bool chirpy_raw_source(uint16_t position, void *userdata, uint16_t *period, uint16_t *duration) {
+    (void)position;
+    chirpy_encoder_state_t *ces = (chirpy_encoder_state_t *)userdata;
+
+    uint8_t tone = chirpy_get_next_tone(ces);
+    // Transmission over?
+    if (tone == 255)
+        return true;
+
+    *period = chirpy_get_encoder_tone_period(ces, tone);
+    *duration = chirpy_get_encoder_tone_ticks(ces);
+    return false;
 }
@@ -25,6 +25,9 @@
 #ifndef CHIRPY_TX_H
 #define CHIRPY_TX_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 /** @brief Calculates the CRC of a byte sequence.
  */
 uint8_t chirpy_crc8(const uint8_t *addr, uint16_t len);
@@ -41,6 +44,21 @@ typedef uint8_t (*chirpy_get_next_byte_t)(uint8_t *next_byte);
 
 #define CHIRPY_TONE_BUF_SIZE 16
 
+/** @brief Transmission profiles.
+ * @details The legacy profile is what every Chirpy receiver understands: 9 tones from 2500 to 4500 Hz,
+ *          3 bits per tone, 3 ticks of 64 Hz per tone. About 7 bytes per second after framing.
+ *
+ *          The fast profile uses 17 tones over the same band (125 Hz apart, so every legacy tone is
+ *          also a fast tone), 4 bits per tone and 2 ticks per tone. About 14 bytes per second.
+ *          After the usual preamble it sends a control tone, a header byte and another control tone,
+ *          all at legacy speed and using only legacy tones, so a receiver can tell the profiles apart.
+ *          The header byte is (bits per tone << 4) | ticks per tone, i.e. 0x42.
+ */
+typedef enum {
+    CHIRPY_PROFILE_LEGACY = 0,
+    CHIRPY_PROFILE_FAST,
+} chirpy_profile_t;
+
 // Holds state used by the encoder. Do not manipulate directly.
 typedef struct {
     uint8_t tone_buf[CHIRPY_TONE_BUF_SIZE];
@@ -52,6 +70,9 @@ typedef struct {
     uint16_t bits;
     uint8_t bit_count;
     chirpy_get_next_byte_t get_next_byte;
+    chirpy_profile_t profile;
+    uint8_t header_tones;
+    uint8_t tone_ticks;
 } chirpy_encoder_state_t;
 
 /** @brief Iniitializes the encoder state to be used during the transmission.
@@ -60,6 +81,13 @@ typedef struct {
  */
 void chirpy_init_encoder(chirpy_encoder_state_t *ces, chirpy_get_next_byte_t get_next_byte);
 
+/** @brief Iniitializes the encoder state for a transmission with the given profile.
+ * @param ces Pointer to encoder state object to be initialized.
+ * @param get_next_byte Pointer to function that the encoder will call to fetch data byte by byte.
+ * @param profile CHIRPY_PROFILE_LEGACY (same as chirpy_init_encoder) or CHIRPY_PROFILE_FAST.
+ */
+void chirpy_init_encoder_with_profile(chirpy_encoder_state_t *ces, chirpy_get_next_byte_t get_next_byte, chirpy_profile_t profile);
+
 /** @brief Returns the next tone to be transmitted.
  * @details This function will call the get_next_byte function stored in the encoder state to
  *          retrieve the next byte to be transmitted as needed. As a single byte is encoded as several tones,
@@ -76,6 +104,27 @@ uint8_t chirpy_get_next_tone(chirpy_encoder_state_t *ces);
  */
 uint16_t chirpy_get_tone_period(uint8_t tone);
 
+/** @brief Returns the period value for buzzing out a tone returned by this encoder.
+ * @param ces Pointer to the encoder state object.
+ * @param tone The tone index, 0 thru 8 for the legacy profile or 0 thru 16 for the fast one.
+ * @return The period for the tone's frequency, i.e., 1_000_000 / freq.
+ */
+uint16_t chirpy_get_encoder_tone_period(const chirpy_encoder_state_t *ces, uint8_t tone);
+
+/** @brief Returns how long to play the tone most recently returned by chirpy_get_next_tone.
+ * @param ces Pointer to the encoder state object.
+ * @return The tone's duration in ticks of 64 Hz.
+ */
+uint8_t chirpy_get_encoder_tone_ticks(const chirpy_encoder_state_t *ces);
+
+/** @brief Raw buzzer source that plays a whole transmission.
+ * @details Matches watch_buzzer_raw_source_t, so you can pass it straight to watch_buzzer_play_raw_source
+ *          with a pointer to an initialized encoder as the userdata. Every tone is then generated from the
+ *          buzzer's own timer interrupt, with no need for a tick handler in your watch face.
+ *          Keep in mind that this means get_next_byte will be called from an interrupt too.
+ */
+bool chirpy_raw_source(uint16_t position, void *userdata, uint16_t *period, uint16_t *duration);
+
 /** @brief Typedef for a tick handler function.
  */
 typedef void (*chirpy_tick_fun_t)(void *context);
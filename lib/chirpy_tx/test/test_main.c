@@ -22,10 +22,12 @@
  * SOFTWARE.
  */
 
+#include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
-#include "../src/lib/chirpy_tx.h"
+#include <stdio.h>
+#include "../chirpy_tx.h"
 #include "unity.h"
 
 
@@ -94,8 +96,8 @@ const uint8_t tones_05[] = {
     8, 0, 8, 0, 3, 2, 0, 6, 2, 5, 5, 6, 8, 2, 7, 6, 8,
     2, 3, 6, 8, 0, 1, 6, 8, 8, 8};
 
-uint8_t curr_data_pos;
-uint8_t curr_data_len;
+uint16_t curr_data_pos;
+uint16_t curr_data_len;
 const uint8_t *curr_data;
 
 uint8_t get_next_byte(uint8_t *next_byte) {
@@ -152,9 +154,176 @@ void test_encoder() {
   test_encoder_one(data_05, data_len_05, tones_05, tones_len_05);
 }
 
+// What a receiver hears: a frequency (as a buzzer period) and a duration in 64 Hz ticks for each tone.
+#define MAX_HEARD_TONES 8192
+uint16_t heard_periods[MAX_HEARD_TONES];
+uint16_t heard_ticks[MAX_HEARD_TONES];
+uint16_t heard_count;
+
+// Plays a transmission through chirpy_raw_source, the same way the buzzer does.
+void play_transmission(const uint8_t *data, uint16_t data_len, chirpy_profile_t profile) {
+  curr_data = data;
+  curr_data_len = data_len;
+  curr_data_pos = 0;
+  chirpy_encoder_state_t ces;
+  chirpy_init_encoder_with_profile(&ces, get_next_byte, profile);
+
+  heard_count = 0;
+  uint16_t period, duration;
+  while (heard_count < MAX_HEARD_TONES) {
+    if (chirpy_raw_source(heard_count, &ces, &period, &duration)) break;
+    heard_periods[heard_count] = period;
+    heard_ticks[heard_count] = duration;
+    ++heard_count;
+  }
+}
+
+// Maps a period back to an index in the 125 Hz spaced alphabet that spans both profiles.
+uint8_t heard_tone(uint16_t i) {
+  uint32_t freq = 1000000 / heard_periods[i];
+  return (uint8_t)((freq - 2500 + 62) / 125);
+}
+
+// A minimal receiver. Returns the number of bytes decoded, or -1 if the transmission is malformed.
+int32_t decode_transmission(uint8_t *out, uint16_t out_size, uint32_t *total_ticks) {
+  const uint8_t control = 16;
+  uint16_t pos = 0;
+  uint8_t bits_per_tone = 3;
+  uint8_t tone_step = 2;
+
+  *total_ticks = 0;
+  for (uint16_t i = 0; i < heard_count; ++i) *total_ticks += heard_ticks[i];
+
+  // Preamble
+  if (heard_count < 6) return -1;
+  if (heard_tone(0) != control || heard_tone(1) != 0 || heard_tone(2) != control || heard_tone(3) != 0) return -1;
+  pos = 4;
+
+  // Control tone followed by something other than a control tone: header
+  if (heard_tone(pos) == control && heard_tone(pos + 1) != control) {
+    uint16_t bits = 0;
+    for (uint8_t i = 0; i < 3; ++i) {
+      if (heard_ticks[pos + 1 + i] != 3) return -1;
+      bits = (bits << 3) | (heard_tone(pos + 1 + i) / 2);
+    }
+    if (heard_tone(pos + 4) != control) return -1;
+    uint8_t header = bits >> 1;
+    bits_per_tone = header >> 4;
+    tone_step = 1;
+    for (uint16_t i = pos + 5; i < heard_count; ++i) {
+      if (heard_ticks[i] != (header & 0x0F)) return -1;
+    }
+    pos += 5;
+  }
+
+  int32_t out_len = 0;
+  while (pos < heard_count) {
+    // End of transmission
+    if (heard_tone(pos) == control) {
+      return heard_tone(pos + 1) == control ? out_len : -1;
+    }
+
+    // Block data, then CRC between two control tones
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
+    int32_t block_start = out_len;
+    while (pos < heard_count && heard_tone(pos) != control) {
+      bits = (bits << bits_per_tone) | (heard_tone(pos) / tone_step);
+      bit_count += bits_per_tone;
+      if (bit_count >= 8) {
+        if (out_len == out_size) return -1;
+        out[out_len++] = (uint8_t)(bits >> (bit_count - 8));
+        bit_count -= 8;
+      }
+      ++pos;
+    }
+    ++pos;
+    bits = 0;
+    bit_count = 0;
+    while (pos < heard_count && heard_tone(pos) != control) {
+      bits = (bits << bits_per_tone) | (heard_tone(pos) / tone_step);
+      bit_count += bits_per_tone;
+      ++pos;
+    }
+    ++pos;
+    if (bit_count < 8) return -1;
+    uint8_t crc = (uint8_t)(bits >> (bit_count - 8));
+    if (crc != chirpy_crc8(out + block_start, out_len - block_start)) return -1;
+  }
+  return -1;
+}
+
+uint8_t round_trip_data[1024];
+uint8_t round_trip_out[1024];
+
+void test_profile_periods() {
+  chirpy_encoder_state_t ces;
+  chirpy_init_encoder_with_profile(&ces, get_next_byte, CHIRPY_PROFILE_FAST);
+  // Every legacy tone is a tone of the fast alphabet
+  for (uint8_t i = 0; i <= 8; ++i) {
+    TEST_ASSERT_EQUAL_UINT16(chirpy_get_tone_period(i), chirpy_get_encoder_tone_period(&ces, i * 2));
+  }
+  TEST_ASSERT_EQUAL_UINT16(400, chirpy_get_tone_period(0));
+  TEST_ASSERT_EQUAL_UINT16(222, chirpy_get_tone_period(8));
+  TEST_ASSERT_EQUAL_UINT16(380, chirpy_get_encoder_tone_period(&ces, 1));
+}
+
+void test_legacy_unchanged_by_raw_source() {
+  play_transmission(data_05, data_len_05, CHIRPY_PROFILE_LEGACY);
+  // Same tones as chirpy_get_next_tone with the default block size, all at legacy speed
+  TEST_ASSERT_EQUAL(22, heard_count);
+  for (uint16_t i = 0; i < heard_count; ++i) {
+    TEST_ASSERT_EQUAL_UINT16(3, heard_ticks[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT16(chirpy_get_tone_period(8), heard_periods[0]);
+  TEST_ASSERT_EQUAL_UINT16(chirpy_get_tone_period(3), heard_periods[4]);
+}
+
+void test_round_trip_one(uint16_t data_len, chirpy_profile_t profile, uint32_t *ticks) {
+  play_transmission(round_trip_data, data_len, profile);
+  int32_t got = decode_transmission(round_trip_out, sizeof(round_trip_out), ticks);
+  TEST_ASSERT_EQUAL_INT32(data_len, got);
+  if (data_len > 0) TEST_ASSERT_EQUAL_UINT8_ARRAY(round_trip_data, round_trip_out, data_len);
+}
+
+void test_round_trip() {
+  srand(1234);
+  for (uint16_t i = 0; i < sizeof(round_trip_data); ++i) round_trip_data[i] = (uint8_t)rand();
+
+  // Lengths around the block sizes of both profiles
+  const uint16_t lengths[] = {0, 1, 2, 14, 15, 16, 17, 31, 32, 33, 100, 1024};
+  for (uint8_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+    uint32_t ticks;
+    test_round_trip_one(lengths[i], CHIRPY_PROFILE_LEGACY, &ticks);
+    test_round_trip_one(lengths[i], CHIRPY_PROFILE_FAST, &ticks);
+  }
+}
+
+void test_throughput() {
+  uint32_t legacy_ticks, fast_ticks;
+  char buf[128];
+
+  test_round_trip_one(1024, CHIRPY_PROFILE_LEGACY, &legacy_ticks);
+  test_round_trip_one(1024, CHIRPY_PROFILE_FAST, &fast_ticks);
+
+  sprintf(buf, "1024 bytes: legacy %u ticks (%u B/s), fast %u ticks (%u B/s)",
+    legacy_ticks, 1024 * 64 / legacy_ticks, fast_ticks, 1024 * 64 / fast_ticks);
+  TEST_MESSAGE(buf);
+
+  // Legacy: 45 tones of 3 ticks per 15-byte block, plus preamble, a short last block and the end signal.
+  TEST_ASSERT_EQUAL_UINT32(12 + 68 * 135 + 16 * 3 + 6, legacy_ticks);
+  // Fast: 36 tones of 2 ticks per 16-byte block, plus preamble and header at legacy speed, and the end signal.
+  TEST_ASSERT_EQUAL_UINT32(9 * 3 + 64 * 72 + 4, fast_ticks);
+  TEST_ASSERT_TRUE(fast_ticks * 100 < legacy_ticks * 55);
+}
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_crc8);
   RUN_TEST(test_encoder);
+  RUN_TEST(test_profile_periods);
+  RUN_TEST(test_legacy_unchanged_by_raw_source);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_throughput);
   return UNITY_END();
 }
@@ -31,12 +31,14 @@
 #include <string.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <math.h>
 #include "app.h"
 #include "watch.h"
 #include "watch_utility.h"
 #include "usb.h"
 #include "watch_private.h"
 #include "movement.h"
+#include "movement_private.h"
 #include "filesystem.h"
 #include "shell.h"
 #include "utz.h"
@@ -45,6 +47,7 @@
 #include "evsys.h"
 #include "delay.h"
 #include "thermistor_driver.h"
+#include "opt3001.h"
 
 #include "movement_config.h"
 
@@ -68,49 +71,18 @@ const uint32_t _movement_light_button_events_mask = 0b11111 << EVENT_LIGHT_BUTTO
 const uint32_t _movement_alarm_button_events_mask = 0b11111 << EVENT_ALARM_BUTTON_DOWN;
 const uint32_t _movement_button_events_mask = _movement_mode_button_events_mask | _movement_light_button_events_mask | _movement_alarm_button_events_mask;
 
-typedef struct {
-    movement_event_type_t down_event;
-    watch_cb_t cb_longpress;
-    movement_timeout_index_t timeout_index;
-    volatile bool is_down;
-    volatile rtc_counter_t down_timestamp;
-#if MOVEMENT_DEBOUNCE_TICKS
-    volatile rtc_counter_t up_timestamp;
-#endif
-} movement_button_t;
-
-/* Pieces of state that can be modified by the various interrupt callbacks.
-   The interrupt writes state changes here, and it will be acted upon on the next app_loop invokation.
-*/
-typedef struct {
-    volatile uint32_t pending_events;
-    volatile bool turn_led_off;
-    volatile bool has_pending_sequence;
-    volatile bool enter_sleep_mode;
-    volatile bool exit_sleep_mode;
-    volatile bool is_sleeping;
-    volatile uint8_t subsecond;
-    volatile rtc_counter_t minute_counter;
-    volatile bool minute_alarm_fired;
-    volatile bool is_buzzing;
-    volatile uint8_t pending_sequence_priority;
-    volatile bool schedule_next_comp;
-    volatile bool has_pending_accelerometer;
-
-    // button tracking for long press
-    movement_button_t mode_button;
-    movement_button_t light_button;
-    movement_button_t alarm_button;
-
-    // button events that will not be passed to the current face loop, but will instead passed directly to the default loop handler.
-    volatile uint32_t passthrough_events;
-} movement_volatile_state_t;
-
 movement_volatile_state_t movement_volatile_state;
 
 // The last sequence that we have been asked to play while the watch was in deep sleep
 static int8_t *_pending_sequence;
 
+// Boot timing, for the boot shell command. Counters are RTC ticks measured from the start of app_init.
+static rtc_counter_t _boot_counter;
+static rtc_counter_t _first_pixel_ticks;
+static rtc_counter_t _boot_complete_ticks;
+static bool _boot_complete = false;
+movement_settings_source_t _movement_settings_source;
+
 // The note sequence of the default alarm
 int8_t alarm_tune[] = {
     BUZZER_NOTE_C8, 3,
@@ -144,7 +116,10 @@ void cb_buzzer_start(void);
 void cb_buzzer_stop(void);
 
 void cb_accelerometer_event(void);
+void cb_accelerometer_sleep_change(void);
 void cb_accelerometer_wake(void);
+void cb_light_sensor_event(void);
+
 
 #if __EMSCRIPTEN__
 void yield(void) {
@@ -154,6 +129,41 @@ void yield(void) {
     tud_task();
     cdc_task();
 }
+
+// Everything app_loop picks up from interrupt handlers. A flag left out of here can be slept on until some unrelated
+// interrupt comes along.
+static bool _movement_has_pending_work(void) {
+    return movement_volatile_state.pending_events ||
+           movement_volatile_state.minute_alarm_fired ||
+           movement_volatile_state.has_pending_accelerometer ||
+           movement_volatile_state.has_pending_light_reading ||
+           movement_volatile_state.has_pending_sequence ||
+           movement_volatile_state.battery_under_load ||
+           movement_volatile_state.turn_led_off ||
+           movement_volatile_state.enter_sleep_mode ||
+           movement_volatile_state.schedule_next_comp;
+}
+
+// While USB is enabled, we can't go into STANDBY: the USB peripheral needs its clocks. IDLE keeps them running,
+// but still halts the CPU until the next interrupt, be it USB traffic, a tick or a button press.
+// The same goes for the UART shell while it's awake, with the next received character waking us.
+static void _movement_idle_while_shell_attached(void) {
+    __disable_irq();
+
+    // with interrupts off, check that nothing came in since we last looked; if it did, don't sleep on it.
+    bool has_pending_work = _movement_has_pending_work() ||
+                            (usb_is_enabled() ? cdc_has_pending_work() : watch_uart_shell_has_pending_input());
+
+    if (!has_pending_work) {
+        uint8_t previous_sleep_mode = PM->SLEEPCFG.bit.SLEEPMODE;
+        // a pending interrupt still ends the WFI with interrupts disabled; its handler runs once we re-enable them.
+        sleep(PM_SLEEPCFG_SLEEPMODE_IDLE_Val);
+        PM->SLEEPCFG.bit.SLEEPMODE = previous_sleep_mode;
+        while (PM->SLEEPCFG.bit.SLEEPMODE != previous_sleep_mode);
+    }
+
+    __enable_irq();
+}
 #endif
 
 static udatetime_t _movement_convert_date_time_to_udate(watch_date_time_t date_time) {
@@ -283,19 +293,42 @@ static void _movement_renew_top_of_minute_alarm(void) {
     movement_volatile_state.schedule_next_comp = true;
 }
 
-static uint32_t _movement_get_accelerometer_events() {
+static movement_accelerometer_activity_t _accelerometer_activity;
+// RTC counter at the latest tap.
+static rtc_counter_t _tap_counter;
+
+// Reads the accelerometer's latched interrupt sources, which also clears them, and updates the activity and
+// orientation counts. Returns the events to pass along to the current face.
+static uint32_t _movement_handle_accelerometer_interrupts(void) {
     uint32_t accelerometer_events = 0;
 
     uint8_t int_src = lis2dw_get_interrupt_source();
 
-    if (int_src & LIS2DW_REG_ALL_INT_SRC_DOUBLE_TAP) {
-        accelerometer_events |= 1 << EVENT_DOUBLE_TAP;
-        printf("Double tap!\r\n");
+    if (int_src & LIS2DW_REG_ALL_INT_SRC_SLEEP_CHANGE_IA) {
+        // by the time we get here it may have changed back, so only count it if it's actually different.
+        bool is_active = !lis2dw_get_sleep_state();
+        if (is_active != _accelerometer_activity.is_active) {
+            _accelerometer_activity.is_active = is_active;
+            _accelerometer_activity.last_state_change = movement_volatile_state.accelerometer_sleep_change_counter;
+            if (is_active) {
+                _accelerometer_activity.activity_count++;
+                accelerometer_events |= 1 << EVENT_ACCELEROMETER_WAKE;
+            } else {
+                _accelerometer_activity.inactivity_count++;
+            }
+        }
+    }
+
+    if (int_src & LIS2DW_REG_ALL_INT_SRC_6D_IA) {
+        _accelerometer_activity.orientation = lis2dw_get_6d_source() & 0b00111111;
+        _accelerometer_activity.orientation_changes++;
+        _accelerometer_activity.last_orientation_change = movement_volatile_state.accelerometer_event_counter;
     }
 
-    if (int_src & LIS2DW_REG_ALL_INT_SRC_SINGLE_TAP) {
-        accelerometer_events |= 1 << EVENT_SINGLE_TAP;
-        printf("Single tap!\r\n");
+    if (int_src & (LIS2DW_REG_ALL_INT_SRC_SINGLE_TAP | LIS2DW_REG_ALL_INT_SRC_DOUBLE_TAP)) {
+        _tap_counter = movement_volatile_state.accelerometer_event_counter;
+        if (int_src & LIS2DW_REG_ALL_INT_SRC_SINGLE_TAP) accelerometer_events |= 1 << EVENT_SINGLE_TAP;
+        if (int_src & LIS2DW_REG_ALL_INT_SRC_DOUBLE_TAP) accelerometer_events |= 1 << EVENT_DOUBLE_TAP;
     }
 
     return accelerometer_events;
@@ -372,6 +405,14 @@ static void _movement_handle_button_presses(uint32_t pending_events) {
 static void _movement_handle_top_of_minute(void) {
     watch_date_time_t date_time = watch_rtc_get_date_time();
 
+    // sample the temperature first, so any face that wants it for its background task gets a fresh reading.
+    _movement_handle_temperature_schedule();
+    // same with the battery, which also gets its reading in before a background task can sound the buzzer.
+    _movement_handle_battery_schedule();
+    _movement_handle_light_schedule();
+    // after the temperature and the battery, since the correction depends on both.
+    _movement_handle_tempco_schedule();
+
     // update the DST offset cache every 30 minutes, since someplace in the world could change.
     if (date_time.unit.minute % 30 == 0) {
         _movement_update_dst_offset_cache();
@@ -444,10 +485,13 @@ void movement_request_tick_frequency(uint8_t freq) {
 
 void movement_illuminate_led(void) {
     if (movement_state.settings.bit.led_duration != 0b111) {
+        // the LED is the biggest draw on the battery, and it doesn't need to be anywhere near as bright in the dark.
+        uint8_t brightness = _movement_led_brightness_percent();
+        _movement_battery_led_on();
         movement_state.light_on = true;
-        watch_set_led_color_rgb(movement_state.settings.bit.led_red_color | movement_state.settings.bit.led_red_color << 4,
-                                movement_state.settings.bit.led_green_color | movement_state.settings.bit.led_green_color << 4,
-                                movement_state.settings.bit.led_blue_color | movement_state.settings.bit.led_blue_color << 4);
+        watch_set_led_color_rgb((movement_state.settings.bit.led_red_color | movement_state.settings.bit.led_red_color << 4) * brightness / 100,
+                                (movement_state.settings.bit.led_green_color | movement_state.settings.bit.led_green_color << 4) * brightness / 100,
+                                (movement_state.settings.bit.led_blue_color | movement_state.settings.bit.led_blue_color << 4) * brightness / 100);
         if (movement_state.settings.bit.led_duration == 0) {
             // Do nothing it'll be turned off on button release
         } else {
@@ -466,6 +510,7 @@ void movement_illuminate_led(void) {
 
 void movement_force_led_on(uint8_t red, uint8_t green, uint8_t blue) {
     // this is hacky, we need a way for watch faces to set an arbitrary color and prevent Movement from turning it right back off.
+    _movement_battery_led_on();
     movement_state.light_on = true;
     watch_set_led_color_rgb(red, green, blue);
     // The led will stay on until movement_force_led_off is called, so disable the led timeout in case we were in the middle of it.
@@ -474,6 +519,11 @@ void movement_force_led_on(uint8_t red, uint8_t green, uint8_t blue) {
 }
 
 void movement_force_led_off(void) {
+    // the LED is still drawing current, so this is a good time to see how the battery holds up.
+    if (movement_state.light_on) {
+        _movement_sample_battery_under_load();
+        _movement_battery_led_off();
+    }
     movement_state.light_on = false;
     // The led timeout probably already triggered, but still disable just in case we are switching off the light by other means
     watch_rtc_disable_comp_callback_no_schedule(LED_TIMEOUT);
@@ -563,11 +613,15 @@ void movement_request_wake() {
 
 void cb_buzzer_start(void) {
     movement_volatile_state.is_buzzing = true;
+    movement_volatile_state.buzzer_start_counter = watch_rtc_get_counter();
 }
 
 void cb_buzzer_stop(void) {
     movement_volatile_state.is_buzzing = false;
     movement_volatile_state.pending_sequence_priority = 0;
+    movement_volatile_state.buzzer_ticks += watch_rtc_get_counter() - movement_volatile_state.buzzer_start_counter;
+    // the battery hasn't recovered from the buzzer yet; the main loop will take a reading.
+    movement_volatile_state.battery_under_load = true;
 }
 
 void movement_play_note(watch_buzzer_note_t note, uint16_t duration_ms) {
@@ -743,6 +797,12 @@ void movement_set_utc_timestamp(uint32_t timestamp) {
     _movement_update_dst_offset_cache();
 }
 
+void _movement_set_utc_time_ms(unix_timestamp_t timestamp, uint16_t ms) {
+    watch_rtc_set_unix_time_ms(timestamp, ms);
+    _movement_set_top_of_minute_alarm();
+    _movement_update_dst_offset_cache();
+}
+
 
 bool movement_button_should_sound(void) {
     return movement_state.settings.bit.button_should_sound;
@@ -830,6 +890,9 @@ void movement_set_backlight_dwell(uint8_t value) {
 }
 
 void movement_store_settings(void) {
+    // keep the backup register copy current too; it's what we restore from after a reset.
+    watch_store_backup_data(movement_state.settings.reg, 0);
+
     movement_settings_t old_settings;
     filesystem_read_file("settings.u32", (char *)&old_settings, sizeof(movement_settings_t));
     if (movement_state.settings.reg != old_settings.reg) {
@@ -845,44 +908,188 @@ void movement_set_alarm_enabled(bool value) {
     movement_state.alarm_enabled = value;
 }
 
-bool movement_enable_tap_detection_if_available(void) {
-    if (movement_state.has_lis2dw) {
-        // configure tap duration threshold and enable Z axis
-        lis2dw_configure_tap_threshold(0, 0, 12, LIS2DW_REG_TAP_THS_Z_Z_AXIS_ENABLE);
-        lis2dw_configure_tap_duration(2, 2, 2);
+typedef struct {
+    movement_accelerometer_batch_cb_t callback;
+    void *context;
+    lis2dw_data_rate_t rate;
+} movement_accelerometer_subscriber_t;
+
+static movement_accelerometer_subscriber_t _accelerometer_subscribers[MOVEMENT_ACCELEROMETER_MAX_SUBSCRIBERS];
+// the rate the accelerometer service is running at, or LIS2DW_DATA_RATE_POWERDOWN if it isn't.
+static lis2dw_data_rate_t _accelerometer_service_rate = LIS2DW_DATA_RATE_POWERDOWN;
+// the tap profile the accelerometer is set up for right now, and the one each face asked for.
+static movement_tap_profile_t _tap_profile = MOVEMENT_TAP_PROFILE_OFF;
+static movement_tap_profile_t _tap_profiles[MOVEMENT_NUM_FACES];
+
+// INT1 always carries orientation changes, plus taps while tap detection is on, or the FIFO watermark while the
+// sampling service is running.
+static uint8_t _movement_accelerometer_int1_sources(void) {
+    uint8_t sources = LIS2DW_CTRL4_INT1_6D;
+
+    if (_tap_profile != MOVEMENT_TAP_PROFILE_OFF) sources |= LIS2DW_CTRL4_INT1_SINGLE_TAP | LIS2DW_CTRL4_INT1_DOUBLE_TAP;
+    else if (_accelerometer_service_rate != LIS2DW_DATA_RATE_POWERDOWN) sources |= LIS2DW_CTRL4_INT1_FTH;
+
+    return sources;
+}
+
+// The accelerometer counts its sleep duration in samples, so it takes a different setting at each rate to keep the
+// wearer still for at least ten seconds before calling them inactive. At 1.6 Hz, the shortest setting is already 10.
+static const uint8_t _movement_accelerometer_sleep_durations[] = {
+    0,  // LIS2DW_DATA_RATE_POWERDOWN
+    0,  // LIS2DW_DATA_RATE_LOWEST: 16 samples, 10 seconds
+    1,  // LIS2DW_DATA_RATE_12_5_HZ: 512 samples, 41 seconds
+    1,  // LIS2DW_DATA_RATE_25_HZ: 20 seconds
+    1,  // LIS2DW_DATA_RATE_50_HZ: 10 seconds
+    2,  // LIS2DW_DATA_RATE_100_HZ
+    4,  // LIS2DW_DATA_RATE_200_HZ
+    8,  // LIS2DW_DATA_RATE_HP_400_HZ
+    15, // LIS2DW_DATA_RATE_HP_800_HZ, as long as it goes
+    15, // LIS2DW_DATA_RATE_HP_1600_HZ
+};
 
-        // ramp data rate up to 400 Hz and high performance mode
-        lis2dw_set_low_noise_mode(true);
-        lis2dw_set_data_rate(LIS2DW_DATA_RATE_HP_400_HZ);
-        lis2dw_set_mode(LIS2DW_MODE_LOW_POWER);
-        lis2dw_enable_double_tap();
+static void _movement_configure_accelerometer_sleep_duration(void) {
+    lis2dw_data_rate_t rate = movement_state.accelerometer_background_rate;
+    if (rate > LIS2DW_DATA_RATE_HP_1600_HZ) rate = LIS2DW_DATA_RATE_HP_1600_HZ;
+    // above 1.6 Hz, a single jolt isn't enough to wake up; the motion has to last two samples.
+    lis2dw_configure_wakeup_duration(rate > LIS2DW_DATA_RATE_LOWEST ? 1 : 0, _movement_accelerometer_sleep_durations[rate]);
+}
 
-        // Settling time (1 sample duration, i.e. 1/400Hz)
-        delay_ms(3);
+// Brings the accelerometer in line with the subscribers: FIFO, watermark interrupt and data rate. Also called after
+// anything else has reconfigured the accelerometer (app_setup, tap detection, the accel shell command).
+void _movement_update_accelerometer_service(void) {
+    if (!movement_state.has_lis2dw) return;
 
-        // enable tap detection on INT1/A3.
-        lis2dw_configure_int1(LIS2DW_CTRL4_INT1_SINGLE_TAP | LIS2DW_CTRL4_INT1_DOUBLE_TAP);
+    lis2dw_data_rate_t rate = LIS2DW_DATA_RATE_POWERDOWN;
+    if (_tap_profile == MOVEMENT_TAP_PROFILE_OFF) {
+        for (uint8_t i = 0; i < MOVEMENT_ACCELEROMETER_MAX_SUBSCRIBERS; i++) {
+            if (_accelerometer_subscribers[i].callback != NULL && _accelerometer_subscribers[i].rate > rate) {
+                rate = _accelerometer_subscribers[i].rate;
+            }
+        }
+    }
 
-        return true;
+    if (rate != LIS2DW_DATA_RATE_POWERDOWN) {
+        // stationary detection would drop us to 1.6 Hz whenever the wearer holds still, so no sleeping while we sample.
+        // Stream mode keeps the newest samples if we ever fall behind, and the overrun flag tells subscribers.
+        lis2dw_disable_sleep();
+        lis2dw_configure_fifo(LIS2DW_FIFO_MODE_OFF, 0);
+        lis2dw_configure_fifo(LIS2DW_FIFO_MODE_COLLECT_CONTINUOUS, MOVEMENT_ACCELEROMETER_FIFO_WATERMARK);
+        lis2dw_set_data_rate(rate > movement_state.accelerometer_background_rate ? rate : movement_state.accelerometer_background_rate);
+    } else if (_accelerometer_service_rate != LIS2DW_DATA_RATE_POWERDOWN) {
+        lis2dw_configure_fifo(LIS2DW_FIFO_MODE_OFF, 0);
+        lis2dw_enable_sleep();
+        lis2dw_set_data_rate(movement_state.accelerometer_background_rate);
     }
 
-    return false;
+    _accelerometer_service_rate = rate;
+    lis2dw_configure_int1(_movement_accelerometer_int1_sources());
 }
 
-bool movement_disable_tap_detection_if_available(void) {
-    if (movement_state.has_lis2dw) {
-        // Ramp data rate back down to the usual lowest rate to save power.
+static void _movement_drain_accelerometer_fifo(void) {
+    static lis2dw_reading_t readings[32];
+    bool overrun;
+
+    uint8_t count = lis2dw_read_fifo_burst(readings, 32, &overrun);
+    if (count == 0) return;
+
+    // readings are left-justified at ±2 g, so 1 g is 16384.
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_ACCELEROMETER, readings[count - 1].x / 16384.0f, readings[count - 1].y / 16384.0f,
+                                   readings[count - 1].z / 16384.0f, movement_volatile_state.accelerometer_event_counter);
+
+    for (uint8_t i = 0; i < MOVEMENT_ACCELEROMETER_MAX_SUBSCRIBERS; i++) {
+        if (_accelerometer_subscribers[i].callback != NULL) {
+            _accelerometer_subscribers[i].callback(readings, count, movement_volatile_state.accelerometer_event_counter, overrun, _accelerometer_subscribers[i].context);
+        }
+    }
+}
+
+typedef struct {
+    lis2dw_data_rate_t rate;
+    bool high_performance;
+    uint8_t threshold;  // in 62.5 mg steps, at ±2 g
+    uint8_t latency;    // longest gap between the taps of a double tap, in 32-sample steps
+    uint8_t quiet;      // how long it has to be quiet after a tap, in 4-sample steps
+    uint8_t shock;      // longest a tap can last, in 8-sample steps
+    uint8_t settle_ms;  // one sample
+} movement_tap_config_t;
+
+// In low power mode the LIS2DW tops out at 200 Hz, so anything faster means high performance mode. The windows come
+// out at about 80 ms for the tap, 40 ms of quiet after it and 320 ms between the taps of a double tap, whatever the
+// rate; at 400 Hz, the 2-bit shock and quiet fields only reach 60 and 30 ms.
+static const movement_tap_config_t _movement_tap_configs[] = {
+    { LIS2DW_DATA_RATE_POWERDOWN, false, 0, 0, 0, 0, 0 },   // MOVEMENT_TAP_PROFILE_OFF
+    { LIS2DW_DATA_RATE_100_HZ, false, 15, 1, 1, 1, 10 },    // MOVEMENT_TAP_PROFILE_FIRM
+    { LIS2DW_DATA_RATE_200_HZ, false, 12, 2, 2, 2, 5 },     // MOVEMENT_TAP_PROFILE_NORMAL
+    { LIS2DW_DATA_RATE_HP_400_HZ, true, 9, 4, 3, 3, 3 },    // MOVEMENT_TAP_PROFILE_LIGHT
+};
+
+// Sets the accelerometer up for the current face's tap profile, or turns tap detection off in low energy mode. Also
+// called after anything else has reconfigured the accelerometer (app_setup, face changes).
+static void _movement_update_tap_detection(void) {
+    if (!movement_state.has_lis2dw) return;
+
+    movement_tap_profile_t profile = MOVEMENT_TAP_PROFILE_OFF;
+    if (!movement_volatile_state.is_sleeping) profile = _tap_profiles[movement_state.current_face_idx];
+    if (profile == _tap_profile) return;
+
+    if (profile != MOVEMENT_TAP_PROFILE_OFF) {
+        const movement_tap_config_t *config = &_movement_tap_configs[profile];
+        // taps share INT1 with the FIFO watermark, so the sampling service steps aside until they're done.
+        _tap_profile = profile;
+        _movement_update_accelerometer_service();
+        // at these rates, the sleep duration we set for the background rate is a fraction of a second; don't let the
+        // activity state flap around while we're looking for taps.
+        lis2dw_disable_sleep();
+
+        // taps on the crystal show up on the Z axis.
+        lis2dw_configure_tap_threshold(0, 0, config->threshold, LIS2DW_REG_TAP_THS_Z_Z_AXIS_ENABLE);
+        lis2dw_configure_tap_duration(config->latency, config->quiet, config->shock);
+
+        lis2dw_set_low_noise_mode(config->high_performance);
+        lis2dw_set_data_rate(config->rate);
+        lis2dw_set_mode(config->high_performance ? LIS2DW_MODE_HIGH_PERFORMANCE : LIS2DW_MODE_LOW_POWER);
+        lis2dw_enable_double_tap();
+
+        // settling time, then enable tap detection on INT1/A3.
+        delay_ms(config->settle_ms);
+        lis2dw_configure_int1(_movement_accelerometer_int1_sources());
+    } else {
+        // ramp back down to the background rate in low power mode.
         lis2dw_set_low_noise_mode(false);
         lis2dw_set_data_rate(movement_state.accelerometer_background_rate);
         lis2dw_set_mode(LIS2DW_MODE_LOW_POWER);
         lis2dw_disable_double_tap();
-        // ...disable Z axis (not sure if this is needed, does this save power?)...
         lis2dw_configure_tap_threshold(0, 0, 0, 0);
+        lis2dw_enable_sleep();
 
-        return true;
+        _tap_profile = MOVEMENT_TAP_PROFILE_OFF;
+        _movement_update_accelerometer_service();
     }
+}
 
-    return false;
+bool movement_set_tap_detection(movement_tap_profile_t profile) {
+    if (!movement_state.has_lis2dw) return false;
+
+    _tap_profiles[movement_state.current_face_idx] = profile;
+    _movement_update_tap_detection();
+
+    return true;
+}
+
+movement_tap_profile_t movement_get_tap_detection(void) {
+    return _tap_profiles[movement_state.current_face_idx];
+}
+
+rtc_counter_t movement_get_tap_counter(void) {
+    return _tap_counter;
+}
+
+bool movement_enable_tap_detection_if_available(void) {
+    return movement_set_tap_detection(MOVEMENT_TAP_PROFILE_NORMAL);
+}
+
+bool movement_disable_tap_detection_if_available(void) {
+    return movement_set_tap_detection(MOVEMENT_TAP_PROFILE_OFF);
 }
 
 lis2dw_data_rate_t movement_get_accelerometer_background_rate(void) {
@@ -893,8 +1100,12 @@ lis2dw_data_rate_t movement_get_accelerometer_background_rate(void) {
 bool movement_set_accelerometer_background_rate(lis2dw_data_rate_t new_rate) {
     if (movement_state.has_lis2dw) {
         if (movement_state.accelerometer_background_rate != new_rate) {
-            lis2dw_set_data_rate(new_rate);
             movement_state.accelerometer_background_rate = new_rate;
+            _movement_configure_accelerometer_sleep_duration();
+            // if the sampling service is running, it picks whichever rate is higher. Taps keep their own rate, and we
+            // come back to this one when they're done.
+            if (_accelerometer_service_rate != LIS2DW_DATA_RATE_POWERDOWN) _movement_update_accelerometer_service();
+            else if (_tap_profile == MOVEMENT_TAP_PROFILE_OFF) lis2dw_set_data_rate(new_rate);
 
             return true;
         }
@@ -921,32 +1132,87 @@ bool movement_set_accelerometer_motion_threshold(uint8_t new_threshold) {
     return false;
 }
 
-float movement_get_temperature(void) {
-    float temperature_c = (float)0xFFFFFFFF;
-#if __EMSCRIPTEN__
-    temperature_c = EM_ASM_DOUBLE({
-        return temp_c || 25.0;
-    });
-#else
+bool movement_accelerometer_subscribe(lis2dw_data_rate_t rate, movement_accelerometer_batch_cb_t callback, void *context) {
+    if (!movement_state.has_lis2dw || callback == NULL || rate == LIS2DW_DATA_RATE_POWERDOWN) return false;
 
-    if (movement_state.has_thermistor) {
-        thermistor_driver_enable();
-        temperature_c = thermistor_driver_get_temperature();
-        thermistor_driver_disable();
-    } else if (movement_state.has_lis2dw) {
-            int16_t val = lis2dw_get_temperature();
-            val = val >> 4;
-            temperature_c = 25 + (float)val / 16.0;
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < MOVEMENT_ACCELEROMETER_MAX_SUBSCRIBERS; i++) {
+        if (_accelerometer_subscribers[i].callback == callback && _accelerometer_subscribers[i].context == context) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 && _accelerometer_subscribers[i].callback == NULL) slot = i;
     }
-#endif
+    if (slot < 0) return false;
+
+    _accelerometer_subscribers[slot].callback = callback;
+    _accelerometer_subscribers[slot].context = context;
+    _accelerometer_subscribers[slot].rate = rate;
+    _movement_update_accelerometer_service();
+
+    return true;
+}
+
+void movement_accelerometer_unsubscribe(movement_accelerometer_batch_cb_t callback, void *context) {
+    for (uint8_t i = 0; i < MOVEMENT_ACCELEROMETER_MAX_SUBSCRIBERS; i++) {
+        if (_accelerometer_subscribers[i].callback == callback && _accelerometer_subscribers[i].context == context) {
+            _accelerometer_subscribers[i].callback = NULL;
+        }
+    }
+    _movement_update_accelerometer_service();
+}
+
+movement_accelerometer_activity_t movement_get_accelerometer_activity(void) {
+    return _accelerometer_activity;
+}
+
+lis2dw_data_rate_t _movement_accelerometer_service_rate(void) {
+    return _accelerometer_service_rate;
+}
 
-    return temperature_c;
+movement_tap_profile_t _movement_active_tap_profile(void) {
+    return _tap_profile;
 }
 
+#ifndef MOVEMENT_BATTERY_CAPACITY_MAH
+// a CR2016.
+#define MOVEMENT_BATTERY_CAPACITY_MAH (90)
+#endif
+// Average current in each state, in microamps. These are ballpark figures for a classic board running the stock faces;
+// measure your own and set them in movement_config.h for a better runtime estimate.
+#ifndef MOVEMENT_BATTERY_AWAKE_UA
+#define MOVEMENT_BATTERY_AWAKE_UA (12)
+#endif
+#ifndef MOVEMENT_BATTERY_SLEEP_UA
+#define MOVEMENT_BATTERY_SLEEP_UA (5)
+#endif
+#ifndef MOVEMENT_BATTERY_LED_UA
+#define MOVEMENT_BATTERY_LED_UA (5000)
+#endif
+#ifndef MOVEMENT_BATTERY_BUZZER_UA
+#define MOVEMENT_BATTERY_BUZZER_UA (3000)
+#endif
+
+// movement_config.h defines the face list, so no other file can include it; the battery service gets the figures from
+// here.
+const movement_battery_profile_t _movement_battery_profile = {
+    .capacity_mah = MOVEMENT_BATTERY_CAPACITY_MAH,
+    .awake_ua = MOVEMENT_BATTERY_AWAKE_UA,
+    .sleep_ua = MOVEMENT_BATTERY_SLEEP_UA,
+    .led_ua = MOVEMENT_BATTERY_LED_UA,
+    .buzzer_ua = MOVEMENT_BATTERY_BUZZER_UA,
+};
+
 void app_init(void) {
     _watch_init();
 
-    filesystem_init();
+    _boot_counter = watch_rtc_get_counter();
+    _movement_battery_init(_boot_counter);
+    _movement_tempco_init();
+
+    // note that we don't mount the filesystem here: it gets mounted on first access, or once the first
+    // face has been drawn, whichever comes first. That way a reset doesn't leave the display blank while we
+    // wait on littlefs.
 
     // check if we are plugged into USB power.
     HAL_GPIO_VBUS_DET_in();
@@ -995,16 +1261,26 @@ void app_init(void) {
 
     movement_state.has_thermistor = thermistor_driver_init();
 
-    bool settings_file_exists = filesystem_file_exists("settings.u32");
+    // app_setup and movement_store_settings mirror the settings into backup register 0, which survives a reset.
+    // If it holds valid settings, restore them from there without touching the filesystem.
     movement_settings_t maybe_settings;
-    if (settings_file_exists && maybe_settings.bit.version == 0) {
-        filesystem_read_file("settings.u32", (char *) &maybe_settings, sizeof(movement_settings_t));
+    maybe_settings.reg = watch_get_backup_data(0);
+    _movement_settings_source = MOVEMENT_SETTINGS_SOURCE_BACKUP_REGISTER;
+
+    if (maybe_settings.reg == 0 || maybe_settings.bit.version != 0) {
+        // The backup register is cleared on power loss (i.e. a battery swap), so fall back to the settings file.
+        maybe_settings.reg = 0xFFFFFFFF;
+        _movement_settings_source = MOVEMENT_SETTINGS_SOURCE_FILE;
+        if (filesystem_file_exists("settings.u32")) {
+            filesystem_read_file("settings.u32", (char *) &maybe_settings, sizeof(movement_settings_t));
+        }
     }
 
-    if (settings_file_exists && maybe_settings.bit.version == 0) {
-        // If settings file exists and has a valid version, restore it!
+    if (maybe_settings.bit.version == 0) {
+        // If settings exist and have a valid version, restore them!
         movement_state.settings.reg = maybe_settings.reg;
     } else {
+        _movement_settings_source = MOVEMENT_SETTINGS_SOURCE_DEFAULTS;
         // Otherwise set default values.
         movement_state.settings.bit.version = 0;
         movement_state.settings.bit.clock_mode_24h = MOVEMENT_DEFAULT_24H_MODE;
@@ -1110,7 +1386,17 @@ void app_setup(void) {
         watch_register_interrupt_callback(HAL_GPIO_BTN_LIGHT_pin(), cb_light_btn_interrupt, INTERRUPT_TRIGGER_BOTH);
         watch_register_interrupt_callback(HAL_GPIO_BTN_ALARM_pin(), cb_alarm_btn_interrupt, INTERRUPT_TRIGGER_BOTH);
 
+#if defined(MOVEMENT_UART_SHELL) && !__EMSCRIPTEN__
+        // for a wired jig: with no USB to run the shell over, attach it to the UART on A2 (TX) and A1 (RX).
+        if (!usb_is_enabled()) {
+            watch_uart_shell_enable(HAL_GPIO_A2_pin(), HAL_GPIO_A1_pin(), 19200);
+        }
+#endif
+
 #ifdef I2C_SERCOM
+#ifndef MOVEMENT_NO_ACCELEROMETER
+        // some sensor boards wire A3 and A4 to something else, like the SPI flash's chip select. There, has_lis2dw
+        // stays false, and nothing in Movement touches the accelerometer or its interrupt pins.
         static bool lis2dw_checked = false;
         if (!lis2dw_checked) {
             watch_enable_i2c();
@@ -1134,38 +1420,75 @@ void app_setup(void) {
             lis2dw_set_range(LIS2DW_RANGE_2_G);             // Application note AN5038 recommends 2g range
             lis2dw_enable_sleep();                          // allow acceleromter to sleep and wake on activity
             lis2dw_configure_wakeup_threshold(movement_state.accelerometer_motion_threshold); // g threshold to wake up: (THS * FS / 64) where FS is "full scale" of ±2g.
+            _movement_configure_accelerometer_sleep_duration(); // how long motion or stillness has to last to change state
             lis2dw_configure_6d_threshold(3);               // 0-3 is 80, 70, 60, or 50 degrees. 50 is least precise, hopefully most sensitive?
 
-            // set up interrupts:
-            // INT1 is wired to pin A3. We'll configure the accelerometer to output an interrupt on INT1 when it detects an orientation change.
-            /// TODO: We had routed this interrupt to TC2 to count orientation changes, but TC2 consumed too much power.
-            /// Orientation changes helped with sleep tracking; would love to bring this back if we can find a low power solution.
-            /// For now, commenting these lines out; check commit 27f0c629d865f4bc56bc6e678da1eb8f4b919093 for power-hungry but working code.
-            // lis2dw_configure_int1(LIS2DW_CTRL4_INT1_6D);
-            // HAL_GPIO_A3_in();
+            // set up interrupts. The accelerometer does the counting: it only raises a pin when the wearer starts
+            // or stops moving or turns their wrist, and latches it there until we read the source, so we only wake
+            // for real changes and can't miss one between the edge and the read.
+            // (We used to count orientation changes by routing INT1 to TC2, but TC2 consumed too much power.)
+            lis2dw12_int_notification_set(LIS2DW12_INT_LATCHED);
+
+            // INT1 is wired to pin A3: orientation changes, plus taps or the sampling service's FIFO watermark.
+            // _movement_update_accelerometer_service below routes them.
+            watch_register_interrupt_callback(HAL_GPIO_A3_pin(), cb_accelerometer_event, INTERRUPT_TRIGGER_RISING);
 
-            // next: INT2 is wired to pin A4. We'll configure the accelerometer to output the sleep state on INT2.
-            // a falling edge on INT2 indicates the accelerometer has woken up.
-            lis2dw_configure_int2(LIS2DW_CTRL5_INT2_SLEEP_STATE | LIS2DW_CTRL5_INT2_SLEEP_CHG);
-            HAL_GPIO_A4_in();
+            // INT2 is wired to pin A4: the accelerometer going to sleep or waking up.
+            lis2dw_configure_int2(LIS2DW_CTRL5_INT2_SLEEP_CHG);
+            watch_register_interrupt_callback(HAL_GPIO_A4_pin(), cb_accelerometer_sleep_change, INTERRUPT_TRIGGER_RISING);
 
             // Wake on motion seemed like a good idea when the threshold was lower, but the UX makes less sense now.
-            // Still if you want to wake on motion, you can do it by uncommenting this line:
-            // watch_register_extwake_callback(HAL_GPIO_A4_pin(), cb_accelerometer_wake, false);
-
-            // later on, we are going to use INT1 for tap detection. We'll set up that interrupt here,
-            // but it will only fire once tap recognition is enabled.
-            watch_register_interrupt_callback(HAL_GPIO_A3_pin(), cb_accelerometer_event, INTERRUPT_TRIGGER_RISING);
+            // Still if you want to wake on motion, you can do it by registering cb_accelerometer_wake on A4 as an
+            // extwake callback instead.
 
             // Enable the interrupts...
             lis2dw_enable_interrupts();
 
             // At first boot, this next line sets the accelerometer's sampling rate to 0, which is LIS2DW_DATA_RATE_POWERDOWN.
             // This means the interrupts we just configured won't fire.
-            // Tap detection will ramp up sesing and make use of the A3 interrupt.
-            // If a watch face wants to check in on the A4 interrupt pin for motion status, it can call
+            // Tap detection will ramp up sensing and make use of the A3 interrupt.
+            // If a watch face wants activity and orientation tracking (movement_get_accelerometer_activity), it can call
             // movement_set_accelerometer_background_rate with another rate like LIS2DW_DATA_RATE_LOWEST or LIS2DW_DATA_RATE_25_HZ.
             lis2dw_set_data_rate(movement_state.accelerometer_background_rate);
+            // ...which also leaves tap detection off, whatever it was before we slept.
+            _tap_profile = MOVEMENT_TAP_PROFILE_OFF;
+
+            // if any faces are sampling or listening for taps, pick up where they left off before we slept.
+            _movement_update_accelerometer_service();
+            _movement_update_tap_detection();
+
+            // anything that latched while the EIC was off won't give us another edge, so go read it now.
+            if (HAL_GPIO_A3_read() || HAL_GPIO_A4_read()) movement_volatile_state.has_pending_accelerometer = true;
+        }
+#endif
+
+        static bool opt3001_checked = false;
+        if (!opt3001_checked) {
+            watch_enable_i2c();
+            movement_state.has_opt3001 = opt3001_readDeviceID(OPT3001_ADDRESS_GND) == OPT3001_DEVICE_ID_VALUE;
+            if (!movement_state.has_opt3001 && !movement_state.has_lis2dw) watch_disable_i2c();
+            opt3001_checked = true;
+        } else if (movement_state.has_opt3001 && !movement_state.has_lis2dw) {
+            watch_enable_i2c();
+        }
+
+        if (movement_state.has_opt3001) {
+#ifdef MOVEMENT_OPT3001_INT_PIN
+            // INT is open drain, active low. Boards that don't wire it fall back to a reading every minute.
+            static bool opt3001_int_checked = false;
+            if (!opt3001_int_checked || _movement_light_interrupt_wired()) {
+                watch_register_interrupt_callback(MOVEMENT_OPT3001_INT_PIN, cb_light_sensor_event, INTERRUPT_TRIGGER_FALLING);
+                watch_enable_pull_up(MOVEMENT_OPT3001_INT_PIN);
+            }
+            if (!opt3001_int_checked) {
+                if (!_movement_probe_light_interrupt()) {
+                    watch_register_interrupt_callback(MOVEMENT_OPT3001_INT_PIN, NULL, INTERRUPT_TRIGGER_NONE);
+                }
+                opt3001_int_checked = true;
+            }
+#endif
+            // the light may have changed completely while we slept, so have a reading ready for the LIGHT button.
+            _movement_start_light_conversion();
         }
 #endif
 
@@ -1182,6 +1505,24 @@ void app_setup(void) {
 
 #ifndef MOVEMENT_LOW_ENERGY_MODE_FORBIDDEN
 
+// The EIC is off in low energy mode, but the accelerometer holds its interrupts until we read them, so we can still
+// count what happened once a minute. Anything we find gets the minute's timestamp instead of its own.
+static void _movement_catch_up_accelerometer_interrupts(void) {
+#ifdef I2C_SERCOM
+    if (!movement_state.has_lis2dw) return;
+    if (!HAL_GPIO_A3_read() && !HAL_GPIO_A4_read()) return;
+
+    rtc_counter_t counter = watch_rtc_get_counter();
+    movement_volatile_state.accelerometer_event_counter = counter;
+    movement_volatile_state.accelerometer_sleep_change_counter = counter;
+
+    // low energy mode turned the I2C pins off along with everything else.
+    watch_enable_i2c();
+    // no face is listening for taps or wake events in here.
+    _movement_handle_accelerometer_interrupts();
+#endif
+}
+
 static void _sleep_mode_app_loop(void) {
     // as long as we are in low energy mode, we wake up here, update the screen, and go right back to sleep.
     while (movement_volatile_state.is_sleeping) {
@@ -1197,6 +1538,7 @@ static void _sleep_mode_app_loop(void) {
         if (movement_volatile_state.minute_alarm_fired) {
             movement_volatile_state.minute_alarm_fired = false;
             _movement_renew_top_of_minute_alarm();
+            _movement_catch_up_accelerometer_interrupts();
             _movement_handle_top_of_minute();
         }
 
@@ -1233,6 +1575,8 @@ static bool _switch_face(void) {
     movement_state.current_face_idx = movement_state.next_face_idx;
     // we have just updated the face idx, so we must recache the watch face pointer.
     wf = &watch_faces[movement_state.current_face_idx];
+    // the old face's taps go away with it, and the new face gets back whatever it asked for last time.
+    _movement_update_tap_detection();
     watch_clear_display();
     movement_request_tick_frequency(1);
 
@@ -1283,7 +1627,24 @@ bool app_loop(void) {
 
     if (movement_volatile_state.has_pending_accelerometer) {
         movement_volatile_state.has_pending_accelerometer = false;
-        pending_events |= _movement_get_accelerometer_events();
+        pending_events |= _movement_handle_accelerometer_interrupts();
+        if (_accelerometer_service_rate != LIS2DW_DATA_RATE_POWERDOWN) _movement_drain_accelerometer_fifo();
+        // INT1 is shared, so if something new latched while the line was still high, there was no edge to tell us.
+        // Go around again instead of sleeping on it.
+        if (HAL_GPIO_A3_read() || HAL_GPIO_A4_read()) {
+            movement_volatile_state.has_pending_accelerometer = true;
+            can_sleep = false;
+        }
+    }
+
+    if (movement_volatile_state.has_pending_light_reading) {
+        movement_volatile_state.has_pending_light_reading = false;
+        _movement_check_light_sensor();
+    }
+
+    if (movement_volatile_state.battery_under_load) {
+        movement_volatile_state.battery_under_load = false;
+        _movement_sample_battery_under_load();
     }
 
     // handle any button up/down events that occurred, e.g. schedule longpress timeouts, reset inactivity, etc.
@@ -1344,6 +1705,17 @@ bool app_loop(void) {
         can_sleep = _switch_face() && can_sleep;
     }
 
+    // The first pass through here means the first face has drawn itself; now do the work we put off to get there.
+    if (!_boot_complete) {
+        _first_pixel_ticks = watch_rtc_get_counter() - _boot_counter;
+        filesystem_init();
+        _movement_restore_time_sync_correction();
+        _movement_restore_tempco();
+        _movement_restore_battery_log();
+        _boot_complete_ticks = watch_rtc_get_counter() - _boot_counter;
+        _boot_complete = true;
+    }
+
 #ifndef MOVEMENT_LOW_ENERGY_MODE_FORBIDDEN
     // if we have timed out of our low energy mode countdown, enter low energy mode.
     if (movement_volatile_state.enter_sleep_mode && !movement_volatile_state.is_buzzing) {
@@ -1352,12 +1724,18 @@ bool app_loop(void) {
 
         // No need to fire resign and sleep interrupts while in sleep mode
         _movement_disable_inactivity_countdown();
+        // nor to look for taps that no face can hear.
+        _movement_update_tap_detection();
+        // nor to keep the light sensor converting when there's no I2C to read it.
+        _movement_light_enter_low_energy();
 
         watch_register_extwake_callback(HAL_GPIO_BTN_ALARM_pin(), cb_alarm_btn_extwake, true);
 
         // _sleep_mode_app_loop takes over at this point and loops until exit_sleep_mode is set by the extwake handler,
         // or wake is requested using the movement_request_wake function.
+        _movement_battery_sleep_started();
         _sleep_mode_app_loop();
+        _movement_battery_sleep_ended();
         // as soon as _sleep_mode_app_loop returns, we prepare to reactivate
 
         // // this is a hack tho: waking from sleep mode, app_setup does get called, but it happens before we have reset our ticks.
@@ -1392,17 +1770,58 @@ bool app_loop(void) {
     if (usb_is_enabled()) {
         shell_task();
     }
+#ifdef MOVEMENT_UART_SHELL
+    // otherwise, the shell may be attached to the UART instead; it only needs attention while it's awake.
+    bool uart_shell_awake = !usb_is_enabled() && watch_uart_shell_is_awake();
+    if (uart_shell_awake) {
+        shell_task();
+        if (can_sleep) _movement_idle_while_shell_attached();
+        can_sleep = false;
+    }
+#endif
 #endif
 
-    // if we are plugged into USB, we can't sleep because we need to keep the serial shell running.
+    // if we are plugged into USB, we can't enter STANDBY because we need to keep the serial shell running.
+    // We can still idle until an interrupt if the face doesn't need to be called again right away.
     if (usb_is_enabled()) {
         yield();
+#if !__EMSCRIPTEN__
+        if (can_sleep) _movement_idle_while_shell_attached();
+#endif
         can_sleep = false;
     }
 
     return can_sleep;
 }
 
+bool _movement_get_boot_timing(rtc_counter_t *first_pixel_ticks, rtc_counter_t *boot_complete_ticks) {
+    if (!_boot_complete) return false;
+
+    *first_pixel_ticks = _first_pixel_ticks;
+    *boot_complete_ticks = _boot_complete_ticks;
+
+    return true;
+}
+
+// Crystal compensation. The default profile is nanosec_face's: the datasheet's quadratic, plus a conservative cubic
+// term. Set both to 0 in movement_config.h to leave the temperature out of it.
+#ifndef MOVEMENT_TEMPCO_CENTER_TEMPERATURE
+#define MOVEMENT_TEMPCO_CENTER_TEMPERATURE (2500)
+#endif
+#ifndef MOVEMENT_TEMPCO_QUADRATIC
+#define MOVEMENT_TEMPCO_QUADRATIC (3400)
+#endif
+#ifndef MOVEMENT_TEMPCO_CUBIC
+#define MOVEMENT_TEMPCO_CUBIC (1360)
+#endif
+
+// crystal compensation starts from this until tempco.dat says otherwise.
+const movement_tempco_profile_t _movement_default_tempco_profile = {
+    .center_temperature = MOVEMENT_TEMPCO_CENTER_TEMPERATURE,
+    .quadratic_tempco = MOVEMENT_TEMPCO_QUADRATIC,
+    .cubic_tempco = MOVEMENT_TEMPCO_CUBIC,
+};
+
 static movement_event_type_t _process_button_event(bool pin_level, movement_button_t* button) {
     movement_event_type_t event_type = EVENT_NONE;
 
@@ -1553,9 +1972,19 @@ void cb_tick(void) {
 }
 
 void cb_accelerometer_event(void) {
+    movement_volatile_state.accelerometer_event_counter = watch_rtc_get_counter();
     movement_volatile_state.has_pending_accelerometer = true;
 }
 
+void cb_accelerometer_sleep_change(void) {
+    movement_volatile_state.accelerometer_sleep_change_counter = watch_rtc_get_counter();
+    movement_volatile_state.has_pending_accelerometer = true;
+}
+
+void cb_light_sensor_event(void) {
+    movement_volatile_state.has_pending_light_reading = true;
+}
+
 void cb_accelerometer_wake(void) {
     movement_volatile_state.pending_events |= 1 << EVENT_ACCELEROMETER_WAKE;
     // also: wake up!
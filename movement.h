@@ -137,8 +137,8 @@ typedef enum {
     // EVENT_ALARM_REALLY_LONG_UP, // The alarm button was held for more than 1.5 second, and released.
 
     EVENT_ACCELEROMETER_WAKE,   // The accelerometer has detected motion and woken up.
-    EVENT_SINGLE_TAP,           // Accelerometer detected a single tap. This event is not yet implemented.
-    EVENT_DOUBLE_TAP,           // Accelerometer detected a double tap. This event is not yet implemented.
+    EVENT_SINGLE_TAP,           // Accelerometer detected a single tap. Only sent while the face has tap detection on; see movement_set_tap_detection.
+    EVENT_DOUBLE_TAP,           // Accelerometer detected a double tap. Only sent while the face has tap detection on; see movement_set_tap_detection.
 } movement_event_type_t;
 
 // Each different timeout type will use a different index when invoking watch_rtc_register_comp_callback
@@ -300,6 +300,9 @@ typedef struct {
     // threshold for considering the wearer is in motion
     uint8_t accelerometer_motion_threshold;
 
+    // boolean set if an OPT3001 ambient light sensor is detected
+    bool has_opt3001;
+
     // signal and alarm volumes
     watch_buzzer_volume_t signal_volume;
     watch_buzzer_volume_t alarm_volume;
@@ -394,7 +397,30 @@ void movement_store_settings(void);
 bool movement_alarm_enabled(void);
 void movement_set_alarm_enabled(bool value);
 
-// if the board has an accelerometer, these functions will enable or disable tap detection.
+// Tap detection. The accelerometer's own tap engine watches for taps on the crystal (the Z axis), and Movement passes
+// them to the face as EVENT_SINGLE_TAP and EVENT_DOUBLE_TAP through its loop, like button presses. A face asks for
+// taps with a profile, and each profile runs the accelerometer at the lowest data rate that can still see its taps.
+// The shock, quiet and double tap windows are the same length at every rate. Lighter taps cost more power.
+// * The request belongs to the face that made it. Movement turns tap detection off when that face resigns, and back on
+//   with the same profile when it's activated again.
+// * Taps pause in low energy mode, since there's no loop to deliver them to.
+// * While tap detection is on, the sampling service and the active/inactive tracking pause, since taps need INT1.
+typedef enum {
+    MOVEMENT_TAP_PROFILE_OFF = 0,   // no tap detection.
+    MOVEMENT_TAP_PROFILE_FIRM,      // 100 Hz, low power: only a firm, deliberate tap. The cheapest, and the hardest to set off by accident.
+    MOVEMENT_TAP_PROFILE_NORMAL,    // 200 Hz, low power: an ordinary tap with a fingertip.
+    MOVEMENT_TAP_PROFILE_LIGHT,     // 400 Hz, high performance: a light tap. Several times the current of the others; use it sparingly.
+} movement_tap_profile_t;
+
+// sets the current face's tap profile. Returns false if there's no accelerometer.
+bool movement_set_tap_detection(movement_tap_profile_t profile);
+// returns the current face's tap profile.
+movement_tap_profile_t movement_get_tap_detection(void);
+// returns the RTC counter when the accelerometer raised the latest tap, for timing an EVENT_SINGLE_TAP or EVENT_DOUBLE_TAP.
+rtc_counter_t movement_get_tap_counter(void);
+
+// if the board has an accelerometer, these functions will enable or disable tap detection for the current face, with
+// MOVEMENT_TAP_PROFILE_NORMAL.
 bool movement_enable_tap_detection_if_available(void);
 bool movement_disable_tap_detection_if_available(void);
 
@@ -406,7 +432,209 @@ bool movement_set_accelerometer_background_rate(lis2dw_data_rate_t new_rate);
 uint8_t movement_get_accelerometer_motion_threshold(void);
 bool movement_set_accelerometer_motion_threshold(uint8_t new_threshold);
 
-// If the board has a temperature sensor, this function will give you the temperature in degrees celsius.
+// Accelerometer sampling service. Subscribers get the accelerometer's samples in batches: Movement keeps the FIFO
+// running at the highest rate anyone asked for, sleeps until it fills to MOVEMENT_ACCELEROMETER_FIFO_WATERMARK
+// samples and raises INT1, then drains it in one I2C burst and hands the batch to every subscriber. At 12.5 Hz,
+// that's one wake every two seconds instead of one per sample.
+// * counter is the RTC counter when the watermark interrupt fired, i.e. roughly when the last sample was taken.
+// * overrun is true if samples were lost since the previous batch.
+// * Callbacks run from the main loop, whether or not the subscriber is the active face.
+// The service pauses while tap detection is enabled (taps need INT1), and in low energy mode.
+#define MOVEMENT_ACCELEROMETER_MAX_SUBSCRIBERS (4)
+#define MOVEMENT_ACCELEROMETER_FIFO_WATERMARK (24)
+
+typedef void (*movement_accelerometer_batch_cb_t)(const lis2dw_reading_t *readings, uint8_t count, rtc_counter_t counter, bool overrun, void *context);
+
+// returns false if there's no accelerometer or no room for another subscriber. Subscribing again with the same
+// callback and context just changes the rate.
+bool movement_accelerometer_subscribe(lis2dw_data_rate_t rate, movement_accelerometer_batch_cb_t callback, void *context);
+void movement_accelerometer_unsubscribe(movement_accelerometer_batch_cb_t callback, void *context);
+
+// Activity tracking. While the accelerometer runs in the background (see movement_set_accelerometer_background_rate),
+// its own interrupt engines watch for the wearer starting and stopping moving, and for the watch changing orientation.
+// Movement only wakes when one of those happens, timestamps it in the interrupt, and counts it here. Faces can
+// compare the counts from one minute to the next. Tap detection pauses the active/inactive tracking, and the sampling
+// service pauses it and reports the wearer as active. In low energy mode, events are picked up once a minute and get
+// the minute's timestamp.
+typedef struct {
+    bool is_active;                         // whether the wearer is moving, as of the last change
+    uint8_t orientation;                    // which way the watch faces: the LIS2DW_WAKE_UP_SRC_VAL_[XYZ][HL] bits
+    uint32_t activity_count;                // times the wearer has gone from still to moving
+    uint32_t inactivity_count;              // times the wearer has gone from moving to still
+    uint32_t orientation_changes;           // times the watch has turned to face a different way
+    rtc_counter_t last_state_change;        // RTC counter when is_active last changed
+    rtc_counter_t last_orientation_change;  // RTC counter at the last orientation change
+} movement_accelerometer_activity_t;
+
+movement_accelerometer_activity_t movement_get_accelerometer_activity(void);
+
+// Temperature service. Movement samples the temperature sensor on its own schedule, at the top of the minute: every
+// fastest minutes while the temperature is changing, then backing off (doubling the interval each time) to every
+// slowest minutes once it holds within MOVEMENT_TEMPERATURE_CHANGE_THRESHOLD degrees. The ADC and the thermistor
+// divider are only powered for those samples; faces get the cached value, which costs nothing to read.
+#define MOVEMENT_TEMPERATURE_CHANGE_THRESHOLD (0.25)
+#define MOVEMENT_TEMPERATURE_FASTEST_INTERVAL (1)
+#define MOVEMENT_TEMPERATURE_SLOWEST_INTERVAL (16)
+
+typedef struct {
+    float temperature_c;    // in degrees celsius, or 0xFFFFFFFF if the board has no temperature sensor
+    uint32_t age;           // seconds since the sample was taken
+} movement_temperature_reading_t;
+
+// If the board has a temperature sensor, this function will give you the latest temperature in degrees celsius.
 // If the board has multiple temperature sensors, it will use the most accurate one available.
 // If the board has no temperature sensors, it will return 0xFFFFFFFF.
 float movement_get_temperature(void);
+
+// the same, along with how old the sample is.
+movement_temperature_reading_t movement_get_temperature_reading(void);
+
+// for faces that need something fresher than the schedule provides, e.g. to show it live: takes a new sample if the
+// cached one is more than max_age seconds old. Use sparingly.
+float movement_get_recent_temperature(uint16_t max_age);
+
+// sets the sampling cadence, in minutes. Defaults to MOVEMENT_TEMPERATURE_FASTEST_INTERVAL and
+// MOVEMENT_TEMPERATURE_SLOWEST_INTERVAL.
+void movement_set_temperature_sampling_interval(uint8_t fastest, uint8_t slowest);
+
+// Battery service. Movement samples VCC once every MOVEMENT_BATTERY_SAMPLE_INTERVAL minutes at rest, and right after
+// the LED or the buzzer has been running (at most once every MOVEMENT_BATTERY_LOADED_SAMPLE_INTERVAL minutes), when
+// the cell is under load and shows its age the most. Each UTC day's lowest and highest reading goes into a history
+// in battery.dat, along with counters of the time spent awake, in low energy mode, and running the LED and buzzer
+// since the battery went in. Those counters, the cell's capacity and the current each state draws (see the
+// MOVEMENT_BATTERY_* defaults in movement.c, which movement_config.h can override) give the runtime estimate.
+// Samples taken on USB power are the regulator's voltage, not the battery's, so they don't go into the history.
+#define MOVEMENT_BATTERY_SAMPLE_INTERVAL (60)
+#define MOVEMENT_BATTERY_LOADED_SAMPLE_INTERVAL (10)
+#define MOVEMENT_BATTERY_HISTORY_DAYS (32)
+#define MOVEMENT_BATTERY_RUNTIME_UNKNOWN (0xFFFF)
+
+typedef struct {
+    uint16_t voltage;           // latest reading at rest, in millivolts
+    uint32_t age;               // seconds since that reading
+    uint16_t loaded_voltage;    // latest reading right after the LED or buzzer, in millivolts; 0 if there isn't one yet
+    uint16_t min_today;         // lowest and highest readings today (UTC), loaded or not; 0 if there aren't any yet
+    uint16_t max_today;
+    uint32_t awake_seconds;     // time spent out of low energy mode since the battery went in
+    uint32_t sleep_seconds;     // time spent in low energy mode since the battery went in
+    uint16_t runtime_days;      // estimated days left, or MOVEMENT_BATTERY_RUNTIME_UNKNOWN for the first day
+} movement_battery_status_t;
+
+typedef struct {
+    uint16_t day;               // days since 1970-01-01, UTC
+    uint16_t min_voltage;       // in millivolts
+    uint16_t max_voltage;       // in millivolts
+    uint16_t awake_minutes;     // time spent out of low energy mode that day
+} movement_battery_day_t;
+
+// returns the latest battery voltage at rest, in millivolts.
+uint16_t movement_get_battery_voltage(void);
+
+movement_battery_status_t movement_get_battery_status(void);
+
+// copies up to max_days of the daily history into days, newest first, and returns how many it copied.
+// The day in progress isn't included; see min_today and max_today in movement_battery_status_t.
+uint8_t movement_get_battery_history(movement_battery_day_t *days, uint8_t max_days);
+
+// Ambient light. If there's an OPT3001 on the I2C bus, it converts on its own while the watch is awake and pulls its
+// INT pin (MOVEMENT_OPT3001_INT_PIN) low when the light leaves a band around the last reading, so Movement only talks
+// to it when the light changes. On boards that don't wire INT, Movement has it take a single low-power reading at the
+// top of each minute instead (never while the LED is on). movement_illuminate_led uses the last reading to dim the LED.
+// Returns the last reading in lux, or 0xFFFFFFFF if there's no light sensor or no reading yet.
+float movement_get_light_level(void);
+
+// Sensor registry. Every sensor Movement knows about sits behind a driver with the same small API, so faces can ask
+// what the board has instead of probing for it, and Movement can power a sensor down when nobody's subscribed to it.
+// Drivers front the services above where there is one: a temperature sample is the temperature service's sample,
+// and so on, so the last-value cache is the same one the services keep. In the simulator, scripted stand-ins take
+// the place of sensors it doesn't have, so faces have something plausible to show; they report
+// MOVEMENT_SENSOR_CAP_SIMULATED.
+typedef enum {
+    MOVEMENT_SENSOR_ACCELEROMETER = 0,  // LIS2DW: x, y and z, in g
+    MOVEMENT_SENSOR_TEMPERATURE,        // thermistor, or failing that the LIS2DW: degrees celsius
+    MOVEMENT_SENSOR_LIGHT,              // OPT3001: lux
+    MOVEMENT_SENSOR_IR,                 // IR phototransistor on the ADC: raw counts, 0 to 65535
+    MOVEMENT_SENSOR_VCC,                // supply voltage: volts
+    MOVEMENT_NUM_SENSORS
+} movement_sensor_t;
+
+#define MOVEMENT_SENSOR_CAP_PRESENT     (1 << 0)    // the board has one (or the simulator stands one in)
+#define MOVEMENT_SENSOR_CAP_SAMPLE      (1 << 1)    // movement_sensor_sample takes a reading on demand
+#define MOVEMENT_SENSOR_CAP_BATCH       (1 << 2)    // movement_sensor_read_batch returns every reading since the last call
+#define MOVEMENT_SENSOR_CAP_INTERRUPT   (1 << 3)    // the sensor can wake the watch by itself
+#define MOVEMENT_SENSOR_CAP_SIMULATED   (1 << 4)    // a scripted stand-in, not real hardware
+
+typedef enum {
+    MOVEMENT_SENSOR_POWER_ABSENT = 0,
+    MOVEMENT_SENSOR_POWER_OFF,          // shut down; a sample powers it up just long enough to take the reading
+    MOVEMENT_SENSOR_POWER_STANDBY,      // powered only while it samples, on a schedule of Movement's
+    MOVEMENT_SENSOR_POWER_ON,           // running continuously
+} movement_sensor_power_t;
+
+typedef struct {
+    float values[3];                    // one value, or three for the accelerometer; see movement_sensor_t for units
+    rtc_counter_t counter;              // RTC counter when it was taken
+} movement_sensor_reading_t;
+
+// readings kept for movement_sensor_read_batch, for sensors that have MOVEMENT_SENSOR_CAP_BATCH.
+#define MOVEMENT_SENSOR_BATCH_SIZE (32)
+
+uint8_t movement_sensor_get_capabilities(movement_sensor_t sensor);
+bool movement_sensor_is_available(movement_sensor_t sensor);
+movement_sensor_power_t movement_sensor_get_power_state(movement_sensor_t sensor);
+const char *movement_sensor_get_name(movement_sensor_t sensor);
+
+// takes a reading now, and returns false if the sensor isn't there. While the accelerometer streams batches, its
+// samples come out of the FIFO, so this returns the newest one from the last batch.
+bool movement_sensor_sample(movement_sensor_t sensor, movement_sensor_reading_t *reading);
+
+// returns the last reading from whatever took it, without touching the hardware; false if there isn't one yet.
+bool movement_sensor_get_last_reading(movement_sensor_t sensor, movement_sensor_reading_t *reading);
+
+// copies up to max_readings of the readings since the last call into readings, oldest first, and returns how many.
+// Only subscribers get batches; sensors without MOVEMENT_SENSOR_CAP_BATCH give a single fresh sample instead.
+uint8_t movement_sensor_read_batch(movement_sensor_t sensor, movement_sensor_reading_t *readings, uint8_t max_readings);
+
+// Subscribing keeps a sensor running (the light sensor converts continuously, the accelerometer batches at 12.5 Hz,
+// the IR sensor stays powered); once the last subscriber leaves, Movement shuts it back down. Unsubscribe in resign.
+// Returns false if the sensor isn't there.
+bool movement_sensor_subscribe(movement_sensor_t sensor);
+void movement_sensor_unsubscribe(movement_sensor_t sensor);
+
+// Crystal compensation. The RTC's 32.768 kHz crystal runs slow away from its turnover point, by about 0.034 ppm per
+// degree squared: a few seconds a week on a cold wrist. At the top of each minute, Movement works out the correction
+// for the cached temperature (it never samples just for this), adds it to whatever time sync measured, and dithers
+// FREQCORR between whole steps so that the correction averages out to a fraction of a ppm. FREQCORR is only written
+// when the step actually changes. The profile lives in tempco.dat; nanosec_face and the tempco shell command edit it.
+typedef struct {
+    int16_t center_temperature; // turnover point, in hundredths of a degree celsius
+    int16_t quadratic_tempco;   // in 1/100000 ppm per degree squared, stored positive; the crystal runs slow either side
+    int16_t cubic_tempco;       // in 1/10000000 ppm per degree cubed
+    int16_t aging;              // in hundredths of a ppm per year, counted from the last calibration or time sync
+    int16_t offset;             // static correction in hundredths of a ppm, on top of time sync's; positive slows the watch
+    uint16_t reserved;
+    uint32_t calibration_time;  // UTC timestamp of the last manual calibration
+} movement_tempco_profile_t;
+
+// An hour of the correction log, which keeps the last MOVEMENT_TEMPCO_LOG_HOURS.
+typedef struct {
+    uint32_t timestamp;         // UTC, the start of the hour
+    int16_t temperature;        // average, in hundredths of a degree celsius; INT16_MAX if there's no sensor
+    int16_t correction;         // average correction written, in hundredths of a ppm
+} movement_tempco_hour_t;
+
+#define MOVEMENT_TEMPCO_LOG_HOURS (48)
+
+movement_tempco_profile_t movement_get_tempco_profile(void);
+
+// false until something has stored a profile; until then, movement_get_tempco_profile returns the default.
+bool movement_has_stored_tempco_profile(void);
+
+// stores the profile and applies it right away.
+void movement_set_tempco_profile(movement_tempco_profile_t profile);
+
+// returns the correction the dithering is working towards right now, in hundredths of a ppm, time sync's included.
+int16_t movement_get_frequency_correction(void);
+
+// copies up to max_hours of the correction log into hours, newest first, and returns how many it copied.
+uint8_t movement_get_tempco_log(movement_tempco_hour_t *hours, uint8_t max_hours);
@@ -0,0 +1,285 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "movement.h"
+#include "movement_private.h"
+#include "filesystem.h"
+#include "usb.h"
+
+// the battery service keeps its counters and the daily history in BATTERY_LOG_FILE, and writes it once a day.
+#define BATTERY_LOG_FILE "battery.dat"
+
+typedef struct {
+    uint32_t awake_seconds;
+    uint32_t sleep_seconds;
+    uint32_t led_seconds;
+    uint32_t buzzer_seconds;
+    uint8_t next_day;       // where the next day goes in days
+    uint8_t num_days;
+    uint16_t reserved;
+    movement_battery_day_t days[MOVEMENT_BATTERY_HISTORY_DAYS];
+} movement_battery_log_t;
+
+static movement_battery_log_t _battery_log;
+static bool _battery_log_loaded = false;
+static movement_battery_day_t _battery_today;
+static uint32_t _battery_today_awake_ticks;
+
+static bool _battery_sampled = false;
+static uint16_t _battery_voltage;
+static rtc_counter_t _battery_counter;
+static uint16_t _battery_loaded_voltage;
+static rtc_counter_t _battery_loaded_counter;
+static uint8_t _battery_countdown = 0;
+
+// RTC ticks that haven't made it into the log's counters yet.
+static rtc_counter_t _battery_flushed_counter;
+static uint32_t _battery_awake_ticks;
+static uint32_t _battery_sleep_ticks;
+static uint32_t _battery_led_ticks;
+static uint32_t _battery_buzzer_ticks_seen;
+static rtc_counter_t _battery_sleep_start;
+static rtc_counter_t _battery_led_start;
+
+void _movement_battery_init(rtc_counter_t boot_counter) {
+    _battery_flushed_counter = boot_counter;
+}
+
+static void _movement_record_battery_voltage(uint16_t voltage) {
+#if !__EMSCRIPTEN__
+    // on USB power, VCC is the regulator's output; it says nothing about the battery.
+    if (usb_is_enabled()) return;
+#endif
+    if (_battery_today.min_voltage == 0 || voltage < _battery_today.min_voltage) _battery_today.min_voltage = voltage;
+    if (voltage > _battery_today.max_voltage) _battery_today.max_voltage = voltage;
+}
+
+void _movement_sample_battery(void) {
+    _battery_voltage = watch_get_vcc_voltage();
+    _battery_counter = watch_rtc_get_counter();
+    _battery_sampled = true;
+    _battery_countdown = MOVEMENT_BATTERY_SAMPLE_INTERVAL;
+    _movement_record_battery_voltage(_battery_voltage);
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_VCC, _battery_voltage / 1000.0f, 0, 0, _battery_counter);
+}
+
+void _movement_sample_battery_under_load(void) {
+    rtc_counter_t counter = watch_rtc_get_counter();
+
+    if (_battery_loaded_voltage != 0 &&
+        counter - _battery_loaded_counter < MOVEMENT_BATTERY_LOADED_SAMPLE_INTERVAL * watch_rtc_get_ticks_per_minute()) return;
+
+    _battery_loaded_voltage = watch_get_vcc_voltage();
+    _battery_loaded_counter = counter;
+    _movement_record_battery_voltage(_battery_loaded_voltage);
+}
+
+void _movement_battery_led_on(void) {
+    if (!movement_state.light_on) _battery_led_start = watch_rtc_get_counter();
+}
+
+void _movement_battery_led_off(void) {
+    _battery_led_ticks += watch_rtc_get_counter() - _battery_led_start;
+}
+
+void _movement_battery_sleep_started(void) {
+    _battery_sleep_start = watch_rtc_get_counter();
+}
+
+void _movement_battery_sleep_ended(void) {
+    _battery_sleep_ticks += watch_rtc_get_counter() - _battery_sleep_start;
+}
+
+static uint32_t _movement_battery_take_seconds(uint32_t *ticks) {
+    uint32_t frequency = watch_rtc_get_frequency();
+    uint32_t seconds = *ticks / frequency;
+
+    *ticks %= frequency;
+
+    return seconds;
+}
+
+// Brings the log's counters up to date, including a low energy stretch or an LED that's still going.
+static void _movement_update_battery_counters(void) {
+    rtc_counter_t counter = watch_rtc_get_counter();
+
+    if (movement_volatile_state.is_sleeping) {
+        _movement_battery_sleep_ended();
+        _battery_sleep_start = counter;
+    }
+    if (movement_state.light_on) {
+        _movement_battery_led_off();
+        _battery_led_start = counter;
+    }
+
+    // everything that wasn't low energy mode was awake.
+    uint32_t elapsed = counter - _battery_flushed_counter;
+    uint32_t awake = elapsed > _battery_sleep_ticks ? elapsed - _battery_sleep_ticks : 0;
+    _battery_flushed_counter = counter;
+    _battery_awake_ticks += awake;
+    _battery_today_awake_ticks += awake;
+    _battery_log.awake_seconds += _movement_battery_take_seconds(&_battery_awake_ticks);
+    _battery_log.sleep_seconds += _movement_battery_take_seconds(&_battery_sleep_ticks);
+    _battery_log.led_seconds += _movement_battery_take_seconds(&_battery_led_ticks);
+
+    // the buzzer's count only ever goes up, so that the interrupt is the only one writing to it.
+    uint32_t buzzer_ticks = movement_volatile_state.buzzer_ticks - _battery_buzzer_ticks_seen;
+    uint32_t buzzer_seconds = _movement_battery_take_seconds(&buzzer_ticks);
+    _battery_log.buzzer_seconds += buzzer_seconds;
+    _battery_buzzer_ticks_seen += buzzer_seconds * watch_rtc_get_frequency();
+}
+
+void _movement_restore_battery_log(void) {
+    movement_battery_log_t log;
+
+    if (_battery_log_loaded) return;
+    _battery_log_loaded = true;
+
+    if (!filesystem_file_exists(BATTERY_LOG_FILE) ||
+        !filesystem_read_file(BATTERY_LOG_FILE, (char *)&log, sizeof(log)) ||
+        log.next_day >= MOVEMENT_BATTERY_HISTORY_DAYS || log.num_days > MOVEMENT_BATTERY_HISTORY_DAYS) return;
+
+    // the backup register only loses our settings when the power goes out, which usually means a new battery. Keep
+    // the history, but start the counters over.
+    if (_movement_settings_source != MOVEMENT_SETTINGS_SOURCE_BACKUP_REGISTER) {
+        log.awake_seconds = 0;
+        log.sleep_seconds = 0;
+        log.led_seconds = 0;
+        log.buzzer_seconds = 0;
+    }
+
+    // anything counted since boot goes on top.
+    log.awake_seconds += _battery_log.awake_seconds;
+    log.sleep_seconds += _battery_log.sleep_seconds;
+    log.led_seconds += _battery_log.led_seconds;
+    log.buzzer_seconds += _battery_log.buzzer_seconds;
+    _battery_log = log;
+}
+
+static void _movement_close_battery_day(uint16_t day) {
+    // the first time through after a boot, the day so far is all we have; keep it going.
+    if (_battery_today.day != 0) {
+        _movement_update_battery_counters();
+        _movement_restore_battery_log();
+
+        // a day spent on USB power has nothing to say about the battery.
+        if (_battery_today.max_voltage != 0) {
+            _battery_today.awake_minutes = _battery_today_awake_ticks / watch_rtc_get_ticks_per_minute();
+            _battery_log.days[_battery_log.next_day] = _battery_today;
+            _battery_log.next_day = (_battery_log.next_day + 1) % MOVEMENT_BATTERY_HISTORY_DAYS;
+            if (_battery_log.num_days < MOVEMENT_BATTERY_HISTORY_DAYS) _battery_log.num_days++;
+        }
+        filesystem_write_file(BATTERY_LOG_FILE, (char *)&_battery_log, sizeof(_battery_log));
+
+        _battery_today.min_voltage = 0;
+        _battery_today.max_voltage = 0;
+        _battery_today_awake_ticks = 0;
+    }
+
+    _battery_today.day = day;
+}
+
+// Called at the top of every minute.
+void _movement_handle_battery_schedule(void) {
+    uint16_t day = movement_get_utc_timestamp() / 86400;
+    if (day != _battery_today.day) _movement_close_battery_day(day);
+
+    if (_battery_countdown > 0) _battery_countdown--;
+    if (_battery_countdown == 0) _movement_sample_battery();
+}
+
+// Assumes the rest of the battery's life will go like it has so far: same mix of awake, asleep, LED and buzzer.
+static uint16_t _movement_estimate_battery_runtime(void) {
+    uint32_t elapsed = _battery_log.awake_seconds + _battery_log.sleep_seconds;
+    if (elapsed < 86400) return MOVEMENT_BATTERY_RUNTIME_UNKNOWN;
+
+    // in microamp-seconds
+    uint64_t used = (uint64_t)_battery_log.awake_seconds * _movement_battery_profile.awake_ua +
+                    (uint64_t)_battery_log.sleep_seconds * _movement_battery_profile.sleep_ua +
+                    (uint64_t)_battery_log.led_seconds * _movement_battery_profile.led_ua +
+                    (uint64_t)_battery_log.buzzer_seconds * _movement_battery_profile.buzzer_ua;
+    uint64_t capacity = (uint64_t)_movement_battery_profile.capacity_mah * 1000 * 3600;
+    if (used >= capacity) return 0;
+
+    uint64_t used_per_day = used * 86400 / elapsed;
+    if (used_per_day == 0) return MOVEMENT_BATTERY_RUNTIME_UNKNOWN;
+
+    uint64_t days = (capacity - used) / used_per_day;
+    return days >= MOVEMENT_BATTERY_RUNTIME_UNKNOWN ? MOVEMENT_BATTERY_RUNTIME_UNKNOWN - 1 : days;
+}
+
+uint16_t movement_get_battery_voltage(void) {
+    if (!_battery_sampled) _movement_sample_battery();
+
+    return _battery_voltage;
+}
+
+movement_battery_status_t movement_get_battery_status(void) {
+    movement_battery_status_t status;
+
+    status.voltage = movement_get_battery_voltage();
+    status.age = (watch_rtc_get_counter() - _battery_counter) / watch_rtc_get_frequency();
+    status.loaded_voltage = _battery_loaded_voltage;
+    status.min_today = _battery_today.min_voltage;
+    status.max_today = _battery_today.max_voltage;
+
+    _movement_update_battery_counters();
+    status.awake_seconds = _battery_log.awake_seconds;
+    status.sleep_seconds = _battery_log.sleep_seconds;
+    status.runtime_days = _movement_estimate_battery_runtime();
+
+    return status;
+}
+
+uint8_t movement_get_battery_history(movement_battery_day_t *days, uint8_t max_days) {
+    uint8_t count = max_days < _battery_log.num_days ? max_days : _battery_log.num_days;
+
+    for (uint8_t i = 0; i < count; i++) {
+        days[i] = _battery_log.days[(_battery_log.next_day + MOVEMENT_BATTERY_HISTORY_DAYS - 1 - i) % MOVEMENT_BATTERY_HISTORY_DAYS];
+    }
+
+    return count;
+}
+
+// The sensor registry's driver for the battery voltage.
+#if __EMSCRIPTEN__
+
+uint8_t _movement_vcc_capabilities(void) {
+    // the simulator's watch_get_vcc_voltage always says 3 V.
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_SIMULATED;
+}
+
+#else
+
+uint8_t _movement_vcc_capabilities(void) {
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE;
+}
+
+#endif
+
+bool _movement_vcc_sample(void) {
+    _movement_sample_battery();
+
+    return true;
+}
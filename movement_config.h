@@ -108,4 +108,12 @@ const watch_face_t watch_faces[] = {
 */
 #define MOVEMENT_DEBOUNCE_TICKS 0
 
+/* The pin the OPT3001 light sensor's INT line reaches on the sensor board.
+ * Movement checks at boot that INT really is wired there, and if so picks up a
+ * change in the ambient light as soon as the sensor sees it; if not, it falls
+ * back to a reading at the top of each minute. Comment this out if that pin is
+ * needed for something else.
+ */
+#define MOVEMENT_OPT3001_INT_PIN HAL_GPIO_A0_pin()
+
 #endif // MOVEMENT_CONFIG_H_
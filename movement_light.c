@@ -0,0 +1,206 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "movement.h"
+#include "movement_private.h"
+#include "opt3001.h"
+#include "delay.h"
+
+// the light service's last reading, in lux.
+static float _light_lux = (float)0xFFFFFFFF;
+static bool _light_lux_valid = false;
+// the sensor's INT pin reaches MOVEMENT_OPT3001_INT_PIN, so it can convert on its own and tell us when the light changes.
+static bool _light_int_wired = false;
+
+// LED brightness by ambient light; anything brighter than the last level gets full brightness.
+static const struct {
+    uint16_t lux;
+    uint8_t percent;
+} _movement_led_brightness_levels[] = {
+    { 10, 25 },     // night, or a dark room
+    { 100, 50 },    // dim indoor light
+    { 1000, 75 },   // bright indoor light, or an overcast day
+};
+
+static void _movement_read_light_sensor(void) {
+#ifdef I2C_SERCOM
+    _light_lux = opt3001_readResult(OPT3001_ADDRESS_GND).lux;
+    _light_lux_valid = true;
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_LIGHT, _light_lux, 0, 0, watch_rtc_get_counter());
+    // half to double the reading is about as finely as the LED cares.
+    opt3001_setWindow(OPT3001_ADDRESS_GND, _light_lux / 2, _light_lux < 1 ? 2 : _light_lux * 2);
+#endif
+}
+
+// Reads back the last conversion if it landed outside the band around the previous reading (or if we don't have a
+// reading yet), and moves the band to go with it. Reading the config also clears the latched flags and the INT pin.
+void _movement_check_light_sensor(void) {
+#ifdef I2C_SERCOM
+    opt3001_Config_t config = opt3001_readConfig(OPT3001_ADDRESS_GND);
+    if (!config.ConversionReady) return;
+    if (_light_lux_valid && !config.FlagHigh && !config.FlagLow) return;
+    // a sensor that converts on its own sees the LED too; that says nothing about the room, so keep the old band.
+    if (_light_lux_valid && movement_state.light_on) return;
+
+    _movement_read_light_sensor();
+#endif
+}
+
+void _movement_start_light_conversion(void) {
+#ifdef I2C_SERCOM
+    if (_movement_sensor_subscriber_count(MOVEMENT_SENSOR_LIGHT) || _light_int_wired) opt3001_startContinuous(OPT3001_ADDRESS_GND, false);
+    else opt3001_startSingleShot(OPT3001_ADDRESS_GND);
+#endif
+}
+
+// Finds out whether the sensor's INT pin reaches MOVEMENT_OPT3001_INT_PIN. No reading can land inside a window whose
+// low limit is above its high limit, so the first conversion is bound to pull INT low; if cb_light_sensor_event
+// hears about it, the pin is wired. Call with the callback already registered. Returns whether it is.
+bool _movement_probe_light_interrupt(void) {
+#ifdef I2C_SERCOM
+    movement_volatile_state.has_pending_light_reading = false;
+    opt3001_setWindow(OPT3001_ADDRESS_GND, 80000, 0);
+    opt3001_startSingleShot(OPT3001_ADDRESS_GND);
+    // a short conversion takes 100 ms. Don't poll the config to see when it's done; reading it releases INT.
+    delay_ms(100);
+    for (uint8_t i = 0; i < 10 && !movement_volatile_state.has_pending_light_reading; i++) delay_ms(2);
+    _light_int_wired = movement_volatile_state.has_pending_light_reading;
+    movement_volatile_state.has_pending_light_reading = false;
+
+    // that conversion is as good as any, so keep it, and put a real window back around it.
+    _light_lux_valid = false;
+    _movement_check_light_sensor();
+
+    return _light_int_wired;
+#else
+    return false;
+#endif
+}
+
+// The sensor would keep converting (and pulling INT low) all through low energy mode; app_setup starts it again.
+void _movement_light_enter_low_energy(void) {
+#ifdef I2C_SERCOM
+    if (movement_state.has_opt3001 && _light_int_wired) opt3001_shutdown(OPT3001_ADDRESS_GND);
+#endif
+}
+
+// Called at the top of every minute.
+void _movement_handle_light_schedule(void) {
+    // there's no I2C in low energy mode, and no LED to dim either; app_setup starts a conversion when we wake.
+    if (!movement_state.has_opt3001 || movement_volatile_state.is_sleeping) return;
+    // with INT wired, the sensor converts on its own and cb_light_sensor_event tells us when the light changes.
+    if (_light_int_wired) return;
+
+    _movement_check_light_sensor();
+    // the LED would light up the sensor too. Subscribers keep it converting on its own.
+    if (!movement_state.light_on && !_movement_sensor_subscriber_count(MOVEMENT_SENSOR_LIGHT)) _movement_start_light_conversion();
+}
+
+uint8_t _movement_led_brightness_percent(void) {
+    if (!movement_state.has_opt3001) return 100;
+    if (!_light_lux_valid) _movement_check_light_sensor();
+    if (!_light_lux_valid) return 100;
+
+    for (uint8_t i = 0; i < sizeof(_movement_led_brightness_levels) / sizeof(_movement_led_brightness_levels[0]); i++) {
+        if (_light_lux < _movement_led_brightness_levels[i].lux) return _movement_led_brightness_levels[i].percent;
+    }
+
+    return 100;
+}
+
+bool _movement_light_interrupt_wired(void) {
+    return _light_int_wired;
+}
+
+float movement_get_light_level(void) {
+    return _light_lux;
+}
+
+// The sensor registry's driver for the light service.
+#if __EMSCRIPTEN__
+
+uint8_t _movement_light_capabilities(void) {
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_SIMULATED;
+}
+
+movement_sensor_power_t _movement_light_power_state(void) {
+    return (_movement_sensor_subscriber_count(MOVEMENT_SENSOR_LIGHT) || _light_int_wired) ? MOVEMENT_SENSOR_POWER_ON : MOVEMENT_SENSOR_POWER_STANDBY;
+}
+
+bool _movement_light_sample(void) {
+    // there's no LED to dim in the simulator, but faces asking for the light level should get this too.
+    _light_lux = _movement_simulate_lux();
+    _light_lux_valid = true;
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_LIGHT, _light_lux, 0, 0, watch_rtc_get_counter());
+
+    return true;
+}
+
+void _movement_light_set_power(bool on) {
+    (void) on;
+}
+
+#else
+
+uint8_t _movement_light_capabilities(void) {
+    if (!movement_state.has_opt3001) return 0;
+    if (_light_int_wired) return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_INTERRUPT;
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE;
+}
+
+movement_sensor_power_t _movement_light_power_state(void) {
+    if (!movement_state.has_opt3001) return MOVEMENT_SENSOR_POWER_ABSENT;
+    // in single-shot mode, the sensor shuts itself down after each conversion.
+    return (_movement_sensor_subscriber_count(MOVEMENT_SENSOR_LIGHT) || _light_int_wired) ? MOVEMENT_SENSOR_POWER_ON : MOVEMENT_SENSOR_POWER_STANDBY;
+}
+
+bool _movement_light_sample(void) {
+#ifdef I2C_SERCOM
+    if (!movement_state.has_opt3001) return false;
+    // running continuously, the result register is never more than one conversion old.
+    if (!_movement_sensor_subscriber_count(MOVEMENT_SENSOR_LIGHT) && !_light_int_wired) {
+        opt3001_startSingleShot(OPT3001_ADDRESS_GND);
+        // a short conversion takes 100 ms. Reading the config clears ConversionReady, so stop as soon as it's set.
+        delay_ms(100);
+        for (uint8_t i = 0; i < 10 && !opt3001_readConfig(OPT3001_ADDRESS_GND).ConversionReady; i++) delay_ms(2);
+    }
+    _movement_read_light_sensor();
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void _movement_light_set_power(bool on) {
+#ifdef I2C_SERCOM
+    // with INT wired, the sensor keeps converting for the light service anyway.
+    if (on || _light_int_wired) opt3001_startContinuous(OPT3001_ADDRESS_GND, false);
+    else opt3001_shutdown(OPT3001_ADDRESS_GND);
+#else
+    (void) on;
+#endif
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// Movement's internals, for movement.c and the services that live beside it. Watch faces should stick to movement.h.
+
+#include "movement.h"
+
+typedef struct {
+    movement_event_type_t down_event;
+    watch_cb_t cb_longpress;
+    movement_timeout_index_t timeout_index;
+    volatile bool is_down;
+    volatile rtc_counter_t down_timestamp;
+    // only used with MOVEMENT_DEBOUNCE_TICKS, but always here, so the struct doesn't depend on movement_config.h.
+    volatile rtc_counter_t up_timestamp;
+} movement_button_t;
+
+/* Pieces of state that can be modified by the various interrupt callbacks.
+   The interrupt writes state changes here, and it will be acted upon on the next app_loop invokation.
+*/
+typedef struct {
+    volatile uint32_t pending_events;
+    volatile bool turn_led_off;
+    volatile bool has_pending_sequence;
+    volatile bool enter_sleep_mode;
+    volatile bool exit_sleep_mode;
+    volatile bool is_sleeping;
+    volatile uint8_t subsecond;
+    volatile rtc_counter_t minute_counter;
+    volatile bool minute_alarm_fired;
+    volatile bool is_buzzing;
+    volatile uint8_t pending_sequence_priority;
+    volatile bool schedule_next_comp;
+    volatile bool has_pending_accelerometer;
+    volatile rtc_counter_t accelerometer_event_counter;
+    volatile rtc_counter_t accelerometer_sleep_change_counter;
+    volatile rtc_counter_t buzzer_start_counter;
+    volatile uint32_t buzzer_ticks;
+    volatile bool battery_under_load;
+    volatile bool has_pending_light_reading;
+
+    // button tracking for long press
+    movement_button_t mode_button;
+    movement_button_t light_button;
+    movement_button_t alarm_button;
+
+    // button events that will not be passed to the current face loop, but will instead passed directly to the default loop handler.
+    volatile uint32_t passthrough_events;
+} movement_volatile_state_t;
+
+// where the settings came from at boot, for the boot shell command and the battery service.
+typedef enum {
+    MOVEMENT_SETTINGS_SOURCE_DEFAULTS = 0,
+    MOVEMENT_SETTINGS_SOURCE_BACKUP_REGISTER,
+    MOVEMENT_SETTINGS_SOURCE_FILE,
+} movement_settings_source_t;
+
+extern volatile movement_state_t movement_state;
+extern movement_volatile_state_t movement_volatile_state;
+extern movement_settings_source_t _movement_settings_source;
+// RTC ticks from the start of app_init to the first pixel and to the end of boot. False while still booting.
+bool _movement_get_boot_timing(rtc_counter_t *first_pixel_ticks, rtc_counter_t *boot_complete_ticks);
+
+// movement_set_utc_timestamp, to the millisecond.
+void _movement_set_utc_time_ms(unix_timestamp_t timestamp, uint16_t ms);
+
+// Temperature service (movement_temperature.c)
+void _movement_sample_temperature(void);
+// Called at the top of every minute.
+void _movement_handle_temperature_schedule(void);
+uint8_t _movement_temperature_capabilities(void);
+movement_sensor_power_t _movement_temperature_power_state(void);
+bool _movement_temperature_sample(void);
+
+// Battery service (movement_battery.c)
+// Average current in each state, in microamps, and the battery's capacity; see the MOVEMENT_BATTERY_* defaults in
+// movement.c.
+typedef struct {
+    uint16_t capacity_mah;
+    uint16_t awake_ua;
+    uint16_t sleep_ua;
+    uint16_t led_ua;
+    uint16_t buzzer_ua;
+} movement_battery_profile_t;
+
+extern const movement_battery_profile_t _movement_battery_profile;
+
+void _movement_battery_init(rtc_counter_t boot_counter);
+void _movement_sample_battery(void);
+void _movement_sample_battery_under_load(void);
+void _movement_battery_led_on(void);
+void _movement_battery_led_off(void);
+void _movement_battery_sleep_started(void);
+void _movement_battery_sleep_ended(void);
+// Reads the log back from the filesystem, once it's mounted.
+void _movement_restore_battery_log(void);
+// Called at the top of every minute.
+void _movement_handle_battery_schedule(void);
+uint8_t _movement_vcc_capabilities(void);
+bool _movement_vcc_sample(void);
+
+// Light service (movement_light.c)
+// Reads back the last conversion if the light has changed since the reading before.
+void _movement_check_light_sensor(void);
+void _movement_start_light_conversion(void);
+bool _movement_probe_light_interrupt(void);
+bool _movement_light_interrupt_wired(void);
+void _movement_light_enter_low_energy(void);
+// Called at the top of every minute.
+void _movement_handle_light_schedule(void);
+// how bright to make the LED for the ambient light.
+uint8_t _movement_led_brightness_percent(void);
+uint8_t _movement_light_capabilities(void);
+movement_sensor_power_t _movement_light_power_state(void);
+bool _movement_light_sample(void);
+void _movement_light_set_power(bool on);
+
+// Time sync (movement_timesync.c)
+// one FREQCORR step is 2^-20, or 0.95367 ppm; this is that in thousandths of a hundredth of a ppm.
+#define TIME_SYNC_FREQCORR_STEP (95367)
+// time sync's correction, in FREQCORR steps, and when it last ran. Crystal compensation works on top of these.
+int16_t _movement_time_sync_freqcorr(void);
+uint32_t _movement_time_sync_time(void);
+// Reads the correction back from the filesystem, once it's mounted.
+void _movement_restore_time_sync_correction(void);
+// sets the clock to the host's time, and works out the drift since the last sync. Prints what it found.
+int _movement_time_sync(unix_timestamp_t host_time, uint16_t host_ms);
+
+// Crystal compensation (movement_tempco.c)
+// the profile to start from, with movement_config.h's MOVEMENT_TEMPCO_* settings; see movement.c.
+extern const movement_tempco_profile_t _movement_default_tempco_profile;
+
+void _movement_tempco_init(void);
+// Reads the profile and the log back from the filesystem, once it's mounted.
+void _movement_restore_tempco(void);
+// For a new profile or time sync: start the dithering over from the step closest to the new target.
+void _movement_update_freqcorr(void);
+// Called at the top of every minute.
+void _movement_handle_tempco_schedule(void);
+// what's in the FREQCORR register, or INT16_MIN before the first write.
+int16_t _movement_freqcorr_written(void);
+
+// Accelerometer service (movement.c)
+void cb_accelerometer_event(void);
+// Brings the accelerometer in line with the subscribers; call it after reconfiguring the accelerometer yourself.
+void _movement_update_accelerometer_service(void);
+lis2dw_data_rate_t _movement_accelerometer_service_rate(void);
+movement_tap_profile_t _movement_active_tap_profile(void);
+
+// Sensor registry (movement_sensors.c)
+void _movement_cache_sensor_reading(movement_sensor_t sensor, float x, float y, float z, rtc_counter_t counter);
+uint8_t _movement_sensor_subscriber_count(movement_sensor_t sensor);
+#if __EMSCRIPTEN__
+// the simulator's scripted ambient light, in lux.
+float _movement_simulate_lux(void);
+#endif
@@ -0,0 +1,407 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include "movement.h"
+#include "movement_private.h"
+#include "delay.h"
+
+// subscribers to each sensor in the registry; the light sensor runs continuously while it has any.
+static uint8_t _sensor_subscribers[MOVEMENT_NUM_SENSORS];
+
+uint8_t _movement_sensor_subscriber_count(movement_sensor_t sensor) {
+    return _sensor_subscribers[sensor];
+}
+
+// The sensor registry's last-value cache, and the readings waiting for movement_sensor_read_batch. Only the
+// accelerometer batches, so there's just the one ring.
+static movement_sensor_reading_t _sensor_last[MOVEMENT_NUM_SENSORS];
+static bool _sensor_has_last[MOVEMENT_NUM_SENSORS];
+static movement_sensor_reading_t _sensor_batch[MOVEMENT_SENSOR_BATCH_SIZE];
+static uint8_t _sensor_batch_start;
+static uint8_t _sensor_batch_count;
+
+typedef struct {
+    const char *name;
+    uint8_t (*capabilities)(void);
+    movement_sensor_power_t (*power_state)(void);
+    bool (*sample)(void);           // takes a reading and caches it
+    void (*set_power)(bool on);     // for the first subscriber coming and the last one going; NULL if there's nothing to switch
+} movement_sensor_driver_t;
+
+void _movement_cache_sensor_reading(movement_sensor_t sensor, float x, float y, float z, rtc_counter_t counter) {
+    _sensor_last[sensor].values[0] = x;
+    _sensor_last[sensor].values[1] = y;
+    _sensor_last[sensor].values[2] = z;
+    _sensor_last[sensor].counter = counter;
+    _sensor_has_last[sensor] = true;
+}
+
+static void _movement_push_sensor_batch(float x, float y, float z, rtc_counter_t counter) {
+    uint8_t index = (_sensor_batch_start + _sensor_batch_count) % MOVEMENT_SENSOR_BATCH_SIZE;
+
+    // a subscriber that falls behind wants the newest readings, so a full ring drops the oldest.
+    if (_sensor_batch_count == MOVEMENT_SENSOR_BATCH_SIZE) _sensor_batch_start = (_sensor_batch_start + 1) % MOVEMENT_SENSOR_BATCH_SIZE;
+    else _sensor_batch_count++;
+
+    _sensor_batch[index].values[0] = x;
+    _sensor_batch[index].values[1] = y;
+    _sensor_batch[index].values[2] = z;
+    _sensor_batch[index].counter = counter;
+}
+
+static movement_sensor_power_t _movement_sensor_standby_power_state(void) {
+    return MOVEMENT_SENSOR_POWER_STANDBY;
+}
+
+#if __EMSCRIPTEN__
+
+// Scripted stand-ins for the simulator. They're functions of the clock, so they play out the same way every time:
+// the accelerometer loops through a minute of lying still, walking and turning the wrist, and the light follows the
+// local time of day.
+#define SIMULATED_TWO_PI (6.2831853f)
+
+static rtc_counter_t _simulated_batch_counter;
+
+static void _movement_simulate_acceleration(rtc_counter_t counter, float *values) {
+    float t = fmodf((float)counter / watch_rtc_get_frequency(), 60);
+
+    if (t < 20) {
+        // face up on a table.
+        values[0] = 0.02f;
+        values[1] = -0.05f;
+        values[2] = 0.99f;
+    } else if (t < 40) {
+        // walking at 110 steps per minute with the arm at the side: a bounce along gravity, and the arm swinging.
+        float step = SIMULATED_TWO_PI * 110 / 60 * t;
+        values[0] = -(1 + 0.3f * sinf(step));
+        values[1] = 0.2f * sinf(step / 2);
+        values[2] = 0.15f;
+    } else {
+        // turning the wrist back and forth.
+        float angle = 0.8f * sinf(SIMULATED_TWO_PI * t / 5);
+        values[0] = sinf(angle);
+        values[1] = 0.1f;
+        values[2] = cosf(angle);
+    }
+}
+
+float _movement_simulate_lux(void) {
+    watch_date_time_t date_time = movement_get_local_date_time();
+    float hour = date_time.unit.hour + date_time.unit.minute / 60.0f;
+    float sun = sinf((hour - 6) / 24 * SIMULATED_TWO_PI);
+
+    // daylight from 6 to 18, peaking at noon; lamps on in the evening, dark overnight.
+    if (sun > 0) return 10 + 10000 * sun * sun;
+    if (hour >= 18 && hour < 23) return 200;
+    return 1;
+}
+
+// the batch is whatever the accelerometer would have collected at 12.5 Hz since the last call.
+static void _movement_simulate_accelerometer_batch(void) {
+    float ticks = watch_rtc_get_frequency() / 12.5f;
+    rtc_counter_t now = watch_rtc_get_counter();
+    uint32_t count = (now - _simulated_batch_counter) / ticks;
+
+    // anything older than the ring holds would only be dropped.
+    if (count > MOVEMENT_SENSOR_BATCH_SIZE) {
+        _simulated_batch_counter += (rtc_counter_t)((count - MOVEMENT_SENSOR_BATCH_SIZE) * ticks);
+        count = MOVEMENT_SENSOR_BATCH_SIZE;
+    }
+    for (uint32_t i = 1; i <= count; i++) {
+        float values[3];
+        rtc_counter_t counter = _simulated_batch_counter + (rtc_counter_t)(i * ticks);
+        _movement_simulate_acceleration(counter, values);
+        _movement_push_sensor_batch(values[0], values[1], values[2], counter);
+    }
+    _simulated_batch_counter += (rtc_counter_t)(count * ticks);
+}
+
+static uint8_t _movement_accelerometer_capabilities(void) {
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_BATCH | MOVEMENT_SENSOR_CAP_SIMULATED;
+}
+
+static movement_sensor_power_t _movement_accelerometer_power_state(void) {
+    return _sensor_subscribers[MOVEMENT_SENSOR_ACCELEROMETER] ? MOVEMENT_SENSOR_POWER_ON : MOVEMENT_SENSOR_POWER_OFF;
+}
+
+static bool _movement_accelerometer_sample(void) {
+    float values[3];
+    rtc_counter_t counter = watch_rtc_get_counter();
+
+    _movement_simulate_acceleration(counter, values);
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_ACCELEROMETER, values[0], values[1], values[2], counter);
+
+    return true;
+}
+
+static void _movement_accelerometer_set_power(bool on) {
+    _simulated_batch_counter = watch_rtc_get_counter();
+    if (!on) _sensor_batch_count = 0;
+}
+
+static uint8_t _movement_ir_capabilities(void) {
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_SIMULATED;
+}
+
+static movement_sensor_power_t _movement_ir_power_state(void) {
+    return _sensor_subscribers[MOVEMENT_SENSOR_IR] ? MOVEMENT_SENSOR_POWER_ON : MOVEMENT_SENSOR_POWER_OFF;
+}
+
+static bool _movement_ir_sample(void) {
+    // the phototransistor saturates in direct sunlight.
+    float counts = _movement_simulate_lux() * 6;
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_IR, counts > 65535 ? 65535 : counts, 0, 0, watch_rtc_get_counter());
+
+    return true;
+}
+
+static void _movement_ir_set_power(bool on) {
+    (void) on;
+}
+
+#else
+
+static uint8_t _movement_accelerometer_capabilities(void) {
+    if (!movement_state.has_lis2dw) return 0;
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_BATCH | MOVEMENT_SENSOR_CAP_INTERRUPT;
+}
+
+static movement_sensor_power_t _movement_accelerometer_power_state(void) {
+    if (!movement_state.has_lis2dw) return MOVEMENT_SENSOR_POWER_ABSENT;
+    if (_movement_active_tap_profile() != MOVEMENT_TAP_PROFILE_OFF ||
+        _movement_accelerometer_service_rate() != LIS2DW_DATA_RATE_POWERDOWN ||
+        movement_state.accelerometer_background_rate != LIS2DW_DATA_RATE_POWERDOWN) return MOVEMENT_SENSOR_POWER_ON;
+    return MOVEMENT_SENSOR_POWER_OFF;
+}
+
+static bool _movement_accelerometer_sample(void) {
+    if (!movement_state.has_lis2dw) return false;
+    // while the sampling service runs, reading the output registers would pull samples out of the FIFO. Its drain
+    // keeps the cache current instead.
+    if (_movement_accelerometer_service_rate() != LIS2DW_DATA_RATE_POWERDOWN) return _sensor_has_last[MOVEMENT_SENSOR_ACCELEROMETER];
+
+    bool powered_down = _movement_accelerometer_power_state() == MOVEMENT_SENSOR_POWER_OFF;
+    if (powered_down) {
+        // 100 Hz has a sample ready soonest, and it's only on for the one.
+        lis2dw_set_data_rate(LIS2DW_DATA_RATE_100_HZ);
+        for (uint8_t i = 0; i < 25 && !lis2dw_have_new_data(); i++) delay_ms(2);
+    }
+    lis2dw_reading_t reading = lis2dw_get_raw_reading();
+    if (powered_down) lis2dw_set_data_rate(LIS2DW_DATA_RATE_POWERDOWN);
+
+    // readings are left-justified at ±2 g, so 1 g is 16384.
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_ACCELEROMETER, reading.x / 16384.0f, reading.y / 16384.0f, reading.z / 16384.0f,
+                                   watch_rtc_get_counter());
+
+    return true;
+}
+
+// samples per second at each data rate, for timestamping a batch. Zero for the rates we can't timestamp.
+static const float _movement_accelerometer_rates_hz[] = {
+    0,      // LIS2DW_DATA_RATE_POWERDOWN
+    0,      // LIS2DW_DATA_RATE_LOWEST: 12.5 Hz in high performance mode, 1.6 Hz in low power
+    12.5f,  // LIS2DW_DATA_RATE_12_5_HZ
+    25,     // LIS2DW_DATA_RATE_25_HZ
+    50,     // LIS2DW_DATA_RATE_50_HZ
+    100,    // LIS2DW_DATA_RATE_100_HZ
+    200,    // LIS2DW_DATA_RATE_200_HZ
+    400,    // LIS2DW_DATA_RATE_HP_400_HZ
+    800,    // LIS2DW_DATA_RATE_HP_800_HZ
+    1600,   // LIS2DW_DATA_RATE_HP_1600_HZ
+};
+
+static void _movement_accelerometer_batch(const lis2dw_reading_t *readings, uint8_t count, rtc_counter_t counter, bool overrun, void *context) {
+    (void) overrun;
+    (void) context;
+
+    // the service runs at the fastest rate anyone asked for, which may be faster than ours.
+    lis2dw_data_rate_t rate = _movement_accelerometer_service_rate();
+    if (movement_state.accelerometer_background_rate > rate) rate = movement_state.accelerometer_background_rate;
+    // LIS2DW_DATA_RATE_LOWEST depends on the power mode, so there's no knowing how far apart those readings were.
+    if (rate > LIS2DW_DATA_RATE_HP_1600_HZ || _movement_accelerometer_rates_hz[rate] == 0) return;
+    float ticks = watch_rtc_get_frequency() / _movement_accelerometer_rates_hz[rate];
+
+    for (uint8_t i = 0; i < count; i++) {
+        _movement_push_sensor_batch(readings[i].x / 16384.0f, readings[i].y / 16384.0f, readings[i].z / 16384.0f,
+                                    counter - (rtc_counter_t)((count - 1 - i) * ticks));
+    }
+}
+
+static void _movement_accelerometer_set_power(bool on) {
+    if (on) {
+        movement_accelerometer_subscribe(LIS2DW_DATA_RATE_12_5_HZ, _movement_accelerometer_batch, NULL);
+    } else {
+        movement_accelerometer_unsubscribe(_movement_accelerometer_batch, NULL);
+        _sensor_batch_count = 0;
+    }
+}
+
+static uint8_t _movement_ir_capabilities(void) {
+#ifdef HAS_IR_SENSOR
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE;
+#else
+    return 0;
+#endif
+}
+
+static movement_sensor_power_t _movement_ir_power_state(void) {
+#ifdef HAS_IR_SENSOR
+    return _sensor_subscribers[MOVEMENT_SENSOR_IR] ? MOVEMENT_SENSOR_POWER_ON : MOVEMENT_SENSOR_POWER_OFF;
+#else
+    return MOVEMENT_SENSOR_POWER_ABSENT;
+#endif
+}
+
+static void _movement_ir_set_power(bool on) {
+#ifdef HAS_IR_SENSOR
+    if (on) {
+        HAL_GPIO_IR_ENABLE_out();
+        HAL_GPIO_IR_ENABLE_clr();
+        HAL_GPIO_IRSENSE_pmuxen(HAL_GPIO_PMUX_ADC);
+        // the thermistor and the battery check share the ADC; it only turns off when the last of us lets go.
+        watch_enable_adc();
+    } else {
+        watch_disable_adc();
+        HAL_GPIO_IRSENSE_pmuxdis();
+        HAL_GPIO_IRSENSE_off();
+        HAL_GPIO_IR_ENABLE_off();
+    }
+#else
+    (void) on;
+#endif
+}
+
+static bool _movement_ir_sample(void) {
+#ifdef HAS_IR_SENSOR
+    bool powered_down = !_sensor_subscribers[MOVEMENT_SENSOR_IR];
+
+    if (powered_down) _movement_ir_set_power(true);
+    uint16_t value = watch_get_analog_pin_level(HAL_GPIO_IRSENSE_pin());
+    if (powered_down) _movement_ir_set_power(false);
+    _movement_cache_sensor_reading(MOVEMENT_SENSOR_IR, value, 0, 0, watch_rtc_get_counter());
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif
+
+static const movement_sensor_driver_t _movement_sensor_drivers[MOVEMENT_NUM_SENSORS] = {
+    [MOVEMENT_SENSOR_ACCELEROMETER] = {
+        "accelerometer", _movement_accelerometer_capabilities, _movement_accelerometer_power_state,
+        _movement_accelerometer_sample, _movement_accelerometer_set_power
+    },
+    [MOVEMENT_SENSOR_TEMPERATURE] = {
+        "temperature", _movement_temperature_capabilities, _movement_temperature_power_state,
+        _movement_temperature_sample, NULL
+    },
+    [MOVEMENT_SENSOR_LIGHT] = {
+        "light", _movement_light_capabilities, _movement_light_power_state,
+        _movement_light_sample, _movement_light_set_power
+    },
+    [MOVEMENT_SENSOR_IR] = {
+        "ir", _movement_ir_capabilities, _movement_ir_power_state,
+        _movement_ir_sample, _movement_ir_set_power
+    },
+    [MOVEMENT_SENSOR_VCC] = {
+        "vcc", _movement_vcc_capabilities, _movement_sensor_standby_power_state,
+        _movement_vcc_sample, NULL
+    },
+};
+
+uint8_t movement_sensor_get_capabilities(movement_sensor_t sensor) {
+    if (sensor >= MOVEMENT_NUM_SENSORS) return 0;
+
+    return _movement_sensor_drivers[sensor].capabilities();
+}
+
+bool movement_sensor_is_available(movement_sensor_t sensor) {
+    return movement_sensor_get_capabilities(sensor) & MOVEMENT_SENSOR_CAP_PRESENT;
+}
+
+movement_sensor_power_t movement_sensor_get_power_state(movement_sensor_t sensor) {
+    if (sensor >= MOVEMENT_NUM_SENSORS) return MOVEMENT_SENSOR_POWER_ABSENT;
+
+    return _movement_sensor_drivers[sensor].power_state();
+}
+
+const char *movement_sensor_get_name(movement_sensor_t sensor) {
+    if (sensor >= MOVEMENT_NUM_SENSORS) return NULL;
+
+    return _movement_sensor_drivers[sensor].name;
+}
+
+bool movement_sensor_sample(movement_sensor_t sensor, movement_sensor_reading_t *reading) {
+    if (!(movement_sensor_get_capabilities(sensor) & MOVEMENT_SENSOR_CAP_SAMPLE)) return false;
+    if (!_movement_sensor_drivers[sensor].sample()) return false;
+
+    return movement_sensor_get_last_reading(sensor, reading);
+}
+
+bool movement_sensor_get_last_reading(movement_sensor_t sensor, movement_sensor_reading_t *reading) {
+    if (sensor >= MOVEMENT_NUM_SENSORS || !_sensor_has_last[sensor]) return false;
+
+    *reading = _sensor_last[sensor];
+
+    return true;
+}
+
+uint8_t movement_sensor_read_batch(movement_sensor_t sensor, movement_sensor_reading_t *readings, uint8_t max_readings) {
+    if (max_readings == 0) return 0;
+    if (!(movement_sensor_get_capabilities(sensor) & MOVEMENT_SENSOR_CAP_BATCH) || !_sensor_subscribers[sensor]) {
+        return movement_sensor_sample(sensor, &readings[0]) ? 1 : 0;
+    }
+
+#if __EMSCRIPTEN__
+    _movement_simulate_accelerometer_batch();
+#endif
+
+    uint8_t count = max_readings < _sensor_batch_count ? max_readings : _sensor_batch_count;
+    for (uint8_t i = 0; i < count; i++) readings[i] = _sensor_batch[(_sensor_batch_start + i) % MOVEMENT_SENSOR_BATCH_SIZE];
+    _sensor_batch_start = (_sensor_batch_start + count) % MOVEMENT_SENSOR_BATCH_SIZE;
+    _sensor_batch_count -= count;
+
+    return count;
+}
+
+bool movement_sensor_subscribe(movement_sensor_t sensor) {
+    if (!movement_sensor_is_available(sensor)) return false;
+
+    if (_sensor_subscribers[sensor]++ == 0 && _movement_sensor_drivers[sensor].set_power != NULL) {
+        _movement_sensor_drivers[sensor].set_power(true);
+    }
+
+    return true;
+}
+
+void movement_sensor_unsubscribe(movement_sensor_t sensor) {
+    if (sensor >= MOVEMENT_NUM_SENSORS || _sensor_subscribers[sensor] == 0) return;
+
+    if (--_sensor_subscribers[sensor] == 0 && _movement_sensor_drivers[sensor].set_power != NULL) {
+        _movement_sensor_drivers[sensor].set_power(false);
+    }
+}
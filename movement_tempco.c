@@ -0,0 +1,250 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "movement.h"
+#include "movement_private.h"
+#include "filesystem.h"
+
+// the crystal also pulls a little with VCC: 0.24 ppm per volt, from 3 V.
+#define TEMPCO_VOLTAGE_CPPM_PER_V (24)
+// how far the dithering lets the time drift before it switches steps, in thousandths of a step-minute. 30 step-minutes
+// is under 2 ms, and it means FREQCORR changes every hour or so rather than most minutes.
+#define TEMPCO_DITHER_HYSTERESIS (30 * 1000)
+
+#define TEMPCO_PROFILE_FILE "tempco.dat"
+// the hourly log is written out every TEMPCO_LOG_WRITE_INTERVAL hours, so a reset loses a few hours at most.
+#define TEMPCO_LOG_FILE "tempco.log"
+#define TEMPCO_LOG_WRITE_INTERVAL (6)
+
+typedef struct {
+    uint8_t next_hour;      // where the next hour goes in hours
+    uint8_t num_hours;
+    uint16_t reserved;
+    movement_tempco_hour_t hours[MOVEMENT_TEMPCO_LOG_HOURS];
+} movement_tempco_log_t;
+
+static movement_tempco_profile_t _tempco_profile;
+// the profile is read on first use, which may come from a face's setup before the filesystem is otherwise touched.
+static bool _tempco_profile_loaded = false;
+static bool _tempco_profile_stored = false;
+// nothing gets written until time sync's correction and the profile are in from the filesystem.
+static bool _tempco_ready = false;
+// where the correction should be, in thousandths of a FREQCORR step, and the time the dithering hasn't made up for
+// yet, in thousandths of a step-minute.
+static int32_t _tempco_target;
+static int32_t _tempco_residual;
+
+static movement_tempco_log_t _tempco_log;
+static uint32_t _tempco_hour;
+static uint8_t _tempco_hour_minutes;
+static uint8_t _tempco_hour_temperature_minutes;
+static int32_t _tempco_hour_temperature_sum;
+static int32_t _tempco_hour_freqcorr_sum;
+
+// what's in the register now; nothing matches this, so the first write always goes through.
+static int16_t _freqcorr_written = INT16_MIN;
+
+static void _movement_write_freqcorr(int16_t freqcorr) {
+    if (freqcorr == _freqcorr_written) return;
+    watch_rtc_freqcorr_write(abs(freqcorr), freqcorr < 0);
+    _freqcorr_written = freqcorr;
+}
+
+void _movement_tempco_init(void) {
+    _tempco_profile = _movement_default_tempco_profile;
+}
+
+static void _movement_load_tempco_profile(void) {
+    movement_tempco_profile_t profile;
+
+    if (_tempco_profile_loaded) return;
+    _tempco_profile_loaded = true;
+
+    if (filesystem_file_exists(TEMPCO_PROFILE_FILE) &&
+        filesystem_read_file(TEMPCO_PROFILE_FILE, (char *)&profile, sizeof(profile))) {
+        _tempco_profile = profile;
+        _tempco_profile_stored = true;
+    }
+}
+
+void _movement_restore_tempco(void) {
+    movement_tempco_log_t log;
+
+    _movement_load_tempco_profile();
+    if (filesystem_file_exists(TEMPCO_LOG_FILE) &&
+        filesystem_read_file(TEMPCO_LOG_FILE, (char *)&log, sizeof(log)) &&
+        log.next_hour < MOVEMENT_TEMPCO_LOG_HOURS && log.num_hours <= MOVEMENT_TEMPCO_LOG_HOURS) {
+        _tempco_log = log;
+    }
+
+    _tempco_ready = true;
+    _movement_update_freqcorr();
+}
+
+// Where the correction should be right now, in thousandths of a FREQCORR step.
+static int32_t _movement_tempco_target(float temperature_c) {
+    float ppm = _tempco_profile.offset / 100.0f;
+
+    if (temperature_c != 0xFFFFFFFF) {
+        // away from the turnover point the crystal runs slow, and a negative correction speeds it back up.
+        float dt = temperature_c - _tempco_profile.center_temperature / 100.0f;
+        ppm += -_tempco_profile.quadratic_tempco / 100000.0f * dt * dt +
+               _tempco_profile.cubic_tempco / 10000000.0f * dt * dt * dt;
+    }
+    ppm += ((int32_t)movement_get_battery_voltage() - 3000) * TEMPCO_VOLTAGE_CPPM_PER_V / 100000.0f;
+
+    // a time sync measures the aging along with everything else, so it starts over from there.
+    uint32_t since = _tempco_profile.calibration_time > _movement_time_sync_time() ? _tempco_profile.calibration_time : _movement_time_sync_time();
+    uint32_t now = movement_get_utc_timestamp();
+    if (since != 0 && now > since) ppm += (now - since) / 31536000.0f * _tempco_profile.aging / 100.0f;
+
+    return (int32_t)_movement_time_sync_freqcorr() * 1000 + lroundf(ppm * 100000000.0f / TIME_SYNC_FREQCORR_STEP);
+}
+
+// Picks the FREQCORR step for the coming minute: one of the two either side of the target. It stays on one step
+// until the error that builds up (the integral of the target minus the step) crosses TEMPCO_DITHER_HYSTERESIS, then
+// switches to the other to work it back off, so over a few hours, the steps average out to the target.
+// Returns the step it picked.
+static int16_t _movement_dither_freqcorr(bool minute_passed) {
+    int32_t low = (_tempco_target >= 0 ? _tempco_target : _tempco_target - 999) / 1000;
+    int32_t freqcorr = _freqcorr_written;
+
+    if (minute_passed && _freqcorr_written != INT16_MIN) _tempco_residual += _tempco_target - _freqcorr_written * 1000;
+    // the target has moved on from the step we were on: start over from whichever is closer.
+    if (freqcorr != low && freqcorr != low + 1) {
+        freqcorr = (_tempco_target - low * 1000 >= 500) ? low + 1 : low;
+        _tempco_residual = 0;
+    }
+    if (_tempco_residual > TEMPCO_DITHER_HYSTERESIS) freqcorr = low + 1;
+    else if (_tempco_residual < -TEMPCO_DITHER_HYSTERESIS) freqcorr = low;
+
+    if (freqcorr > 127 || freqcorr < -127) {
+        freqcorr = freqcorr > 0 ? 127 : -127;
+        // pinned at the end of the range, the error would only pile up.
+        _tempco_residual = 0;
+    }
+
+    _movement_write_freqcorr(freqcorr);
+
+    return freqcorr;
+}
+
+// For a new profile or time sync: start the dithering over from the step closest to the new target.
+void _movement_update_freqcorr(void) {
+    if (!_tempco_ready) return;
+
+    _tempco_target = _movement_tempco_target(movement_get_temperature_reading().temperature_c);
+    _tempco_residual = 0;
+    _movement_dither_freqcorr(false);
+}
+
+static void _movement_close_tempco_hour(void) {
+    movement_tempco_hour_t *hour = &_tempco_log.hours[_tempco_log.next_hour];
+
+    hour->timestamp = _tempco_hour * 3600;
+    if (_tempco_hour_temperature_minutes) hour->temperature = _tempco_hour_temperature_sum / _tempco_hour_temperature_minutes;
+    else hour->temperature = INT16_MAX;
+    hour->correction = (int64_t)_tempco_hour_freqcorr_sum * TIME_SYNC_FREQCORR_STEP / 1000 / _tempco_hour_minutes;
+
+    _tempco_log.next_hour = (_tempco_log.next_hour + 1) % MOVEMENT_TEMPCO_LOG_HOURS;
+    if (_tempco_log.num_hours < MOVEMENT_TEMPCO_LOG_HOURS) _tempco_log.num_hours++;
+    if (_tempco_log.next_hour % TEMPCO_LOG_WRITE_INTERVAL == 0) {
+        filesystem_write_file(TEMPCO_LOG_FILE, (char *)&_tempco_log, sizeof(_tempco_log));
+    }
+}
+
+// Called at the top of every minute.
+void _movement_handle_tempco_schedule(void) {
+    if (!_tempco_ready) return;
+
+    float temperature_c = movement_get_temperature_reading().temperature_c;
+    _tempco_target = _movement_tempco_target(temperature_c);
+    int16_t freqcorr = _movement_dither_freqcorr(true);
+
+    uint32_t hour = movement_get_utc_timestamp() / 3600;
+    if (hour != _tempco_hour) {
+        if (_tempco_hour_minutes) _movement_close_tempco_hour();
+        _tempco_hour = hour;
+        _tempco_hour_minutes = 0;
+        _tempco_hour_temperature_minutes = 0;
+        _tempco_hour_temperature_sum = 0;
+        _tempco_hour_freqcorr_sum = 0;
+    }
+    _tempco_hour_minutes++;
+    _tempco_hour_freqcorr_sum += freqcorr;
+    if (temperature_c != 0xFFFFFFFF) {
+        _tempco_hour_temperature_sum += lroundf(temperature_c * 100);
+        _tempco_hour_temperature_minutes++;
+    }
+}
+
+movement_tempco_profile_t movement_get_tempco_profile(void) {
+    _movement_load_tempco_profile();
+
+    return _tempco_profile;
+}
+
+bool movement_has_stored_tempco_profile(void) {
+    _movement_load_tempco_profile();
+
+    return _tempco_profile_stored;
+}
+
+void movement_set_tempco_profile(movement_tempco_profile_t profile) {
+    movement_tempco_profile_t old_profile;
+
+    _tempco_profile = profile;
+    _tempco_profile_loaded = true;
+    _tempco_profile_stored = true;
+    if (!filesystem_file_exists(TEMPCO_PROFILE_FILE) ||
+        !filesystem_read_file(TEMPCO_PROFILE_FILE, (char *)&old_profile, sizeof(old_profile)) ||
+        memcmp(&old_profile, &profile, sizeof(profile)) != 0) {
+        filesystem_write_file(TEMPCO_PROFILE_FILE, (char *)&profile, sizeof(profile));
+    }
+
+    _movement_update_freqcorr();
+}
+
+int16_t movement_get_frequency_correction(void) {
+    int32_t target = _tempco_ready ? _tempco_target : (int32_t)_movement_time_sync_freqcorr() * 1000;
+
+    return (int64_t)target * TIME_SYNC_FREQCORR_STEP / 1000000;
+}
+
+uint8_t movement_get_tempco_log(movement_tempco_hour_t *hours, uint8_t max_hours) {
+    uint8_t count = max_hours < _tempco_log.num_hours ? max_hours : _tempco_log.num_hours;
+
+    for (uint8_t i = 0; i < count; i++) {
+        hours[i] = _tempco_log.hours[(_tempco_log.next_hour + MOVEMENT_TEMPCO_LOG_HOURS - 1 - i) % MOVEMENT_TEMPCO_LOG_HOURS];
+    }
+
+    return count;
+}
+
+int16_t _movement_freqcorr_written(void) {
+    return _freqcorr_written;
+}
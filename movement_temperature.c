@@ -0,0 +1,148 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "movement.h"
+#include "movement_private.h"
+#include "thermistor_driver.h"
+
+#if __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+// the temperature service's cache, and the schedule it's sampled on.
+static float _temperature_c = (float)0xFFFFFFFF;
+static rtc_counter_t _temperature_counter;
+static bool _temperature_sampled = false;
+// the temperature at the last scheduled sample; on-demand samples in between don't count toward the cadence.
+// Starts out invalid, so the schedule starts out fast.
+static float _temperature_reference_c = (float)0xFFFFFFFF;
+static uint8_t _temperature_fastest_interval = MOVEMENT_TEMPERATURE_FASTEST_INTERVAL;
+static uint8_t _temperature_slowest_interval = MOVEMENT_TEMPERATURE_SLOWEST_INTERVAL;
+static uint8_t _temperature_interval = MOVEMENT_TEMPERATURE_FASTEST_INTERVAL;
+static uint8_t _temperature_countdown = 0;
+
+void _movement_sample_temperature(void) {
+    float temperature_c = (float)0xFFFFFFFF;
+#if __EMSCRIPTEN__
+    temperature_c = EM_ASM_DOUBLE({
+        return temp_c || 25.0;
+    });
+#else
+
+    if (movement_state.has_thermistor) {
+        thermistor_driver_enable();
+        temperature_c = thermistor_driver_get_temperature();
+        thermistor_driver_disable();
+    } else if (movement_state.has_lis2dw) {
+            int16_t val = lis2dw_get_temperature();
+            val = val >> 4;
+            temperature_c = 25 + (float)val / 16.0;
+    }
+#endif
+
+    _temperature_c = temperature_c;
+    _temperature_counter = watch_rtc_get_counter();
+    _temperature_sampled = true;
+    if (temperature_c != 0xFFFFFFFF) _movement_cache_sensor_reading(MOVEMENT_SENSOR_TEMPERATURE, temperature_c, 0, 0, _temperature_counter);
+}
+
+// Called at the top of every minute. If the temperature moved since the last scheduled sample, we come back in
+// fastest minutes; if it held, we wait twice as long as last time, up to slowest.
+void _movement_handle_temperature_schedule(void) {
+    if (_temperature_countdown > 0) _temperature_countdown--;
+    if (_temperature_countdown > 0) return;
+
+    _movement_sample_temperature();
+
+    float change = _temperature_c - _temperature_reference_c;
+    if (change < MOVEMENT_TEMPERATURE_CHANGE_THRESHOLD && change > -MOVEMENT_TEMPERATURE_CHANGE_THRESHOLD) {
+        uint16_t interval = _temperature_interval * 2;
+        _temperature_interval = interval > _temperature_slowest_interval ? _temperature_slowest_interval : interval;
+    } else {
+        _temperature_interval = _temperature_fastest_interval;
+    }
+    _temperature_reference_c = _temperature_c;
+    _temperature_countdown = _temperature_interval;
+}
+
+movement_temperature_reading_t movement_get_temperature_reading(void) {
+    movement_temperature_reading_t reading;
+
+    if (!_temperature_sampled) _movement_sample_temperature();
+    reading.temperature_c = _temperature_c;
+    reading.age = (watch_rtc_get_counter() - _temperature_counter) / watch_rtc_get_frequency();
+
+    return reading;
+}
+
+float movement_get_temperature(void) {
+    return movement_get_temperature_reading().temperature_c;
+}
+
+float movement_get_recent_temperature(uint16_t max_age) {
+    movement_temperature_reading_t reading = movement_get_temperature_reading();
+
+    if (reading.age > max_age) _movement_sample_temperature();
+
+    return _temperature_c;
+}
+
+void movement_set_temperature_sampling_interval(uint8_t fastest, uint8_t slowest) {
+    if (fastest == 0) fastest = 1;
+    if (slowest < fastest) slowest = fastest;
+
+    _temperature_fastest_interval = fastest;
+    _temperature_slowest_interval = slowest;
+    // start over at the fast end, and take the next sample at the top of the minute.
+    _temperature_interval = fastest;
+    _temperature_countdown = 0;
+}
+
+// The sensor registry's driver for the temperature service.
+#if __EMSCRIPTEN__
+
+uint8_t _movement_temperature_capabilities(void) {
+    // the simulator's temperature comes from the page; see _movement_sample_temperature.
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE | MOVEMENT_SENSOR_CAP_SIMULATED;
+}
+
+#else
+
+uint8_t _movement_temperature_capabilities(void) {
+    if (!movement_state.has_thermistor && !movement_state.has_lis2dw) return 0;
+    return MOVEMENT_SENSOR_CAP_PRESENT | MOVEMENT_SENSOR_CAP_SAMPLE;
+}
+
+#endif
+
+movement_sensor_power_t _movement_temperature_power_state(void) {
+    // the thermistor divider is only powered while the temperature service samples it.
+    return _movement_temperature_capabilities() ? MOVEMENT_SENSOR_POWER_STANDBY : MOVEMENT_SENSOR_POWER_ABSENT;
+}
+
+bool _movement_temperature_sample(void) {
+    _movement_sample_temperature();
+
+    return _temperature_c != 0xFFFFFFFF;
+}
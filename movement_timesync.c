@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "movement.h"
+#include "movement_private.h"
+#include "filesystem.h"
+
+// time sync keeps the last sync time and the correction it worked out in TIME_SYNC_STATE_FILE, and appends a line
+// per sync to TIME_SYNC_LOG_FILE: unix time, offset in ms (positive if the watch was fast), seconds since the previous
+// sync, drift in hundredths of a ppm, and the FREQCORR value in effect afterwards.
+#define TIME_SYNC_STATE_FILE "timesync.dat"
+#define TIME_SYNC_LOG_FILE "timesync.csv"
+// over less time than this, USB jitter and the 8 ms counter resolution swamp the drift we're trying to measure.
+#define TIME_SYNC_MIN_DRIFT_INTERVAL (6 * 60 * 60)
+// FREQCORR tops out around 121 ppm; an offset worse than this means the time was set by hand in the meantime.
+#define TIME_SYNC_MAX_DRIFT_CPPM (20000)
+
+typedef struct {
+    uint32_t last_sync;
+    int16_t freqcorr;
+    uint16_t reserved;
+} movement_time_sync_state_t;
+
+// time sync's correction, in FREQCORR steps, and when it last ran. Crystal compensation works on top of these.
+#ifdef STATIC_FREQCORR
+static int16_t _freqcorr_base = STATIC_FREQCORR;
+#else
+static int16_t _freqcorr_base = 0;
+#endif
+static uint32_t _freqcorr_base_time = 0;
+
+int16_t _movement_time_sync_freqcorr(void) {
+    return _freqcorr_base;
+}
+
+uint32_t _movement_time_sync_time(void) {
+    return _freqcorr_base_time;
+}
+
+void _movement_restore_time_sync_correction(void) {
+    movement_time_sync_state_t state;
+    if (filesystem_file_exists(TIME_SYNC_STATE_FILE) &&
+        filesystem_read_file(TIME_SYNC_STATE_FILE, (char *)&state, sizeof(state))) {
+        _freqcorr_base = state.freqcorr;
+        _freqcorr_base_time = state.last_sync;
+    }
+}
+
+int _movement_time_sync(unix_timestamp_t host_time, uint16_t host_ms) {
+    movement_time_sync_state_t state = {0};
+#ifdef STATIC_FREQCORR
+    state.freqcorr = STATIC_FREQCORR;
+#endif
+    if (filesystem_file_exists(TIME_SYNC_STATE_FILE)) {
+        filesystem_read_file(TIME_SYNC_STATE_FILE, (char *)&state, sizeof(state));
+    }
+
+    uint16_t watch_ms;
+    unix_timestamp_t watch_time = watch_rtc_get_unix_time_ms(&watch_ms);
+    int64_t offset_ms = ((int64_t)watch_time - host_time) * 1000 + watch_ms - host_ms;
+
+    _movement_set_utc_time_ms(host_time, host_ms);
+
+    uint64_t abs_offset_ms = offset_ms < 0 ? -offset_ms : offset_ms;
+    printf("offset: %c%lu.%03u s\r\n", offset_ms < 0 ? '-' : '+',
+           (unsigned long)(abs_offset_ms / 1000), (unsigned int)(abs_offset_ms % 1000));
+
+    char line[64];
+    uint32_t interval = host_time - state.last_sync;
+    if (state.last_sync != 0 && state.last_sync < host_time && interval >= TIME_SYNC_MIN_DRIFT_INTERVAL &&
+        abs_offset_ms * 100000 / interval <= TIME_SYNC_MAX_DRIFT_CPPM) {
+        int32_t drift_cppm = offset_ms * 100000 / interval;
+        // the drift we measured is on top of whatever correction was already running, so add to it.
+        int32_t steps = (drift_cppm * 1000 + (drift_cppm < 0 ? -TIME_SYNC_FREQCORR_STEP : TIME_SYNC_FREQCORR_STEP) / 2) / TIME_SYNC_FREQCORR_STEP;
+        int32_t freqcorr = state.freqcorr + steps;
+        if (freqcorr > 127) freqcorr = 127;
+        if (freqcorr < -127) freqcorr = -127;
+        state.freqcorr = freqcorr;
+        _freqcorr_base = state.freqcorr;
+
+        printf("drift: %c%ld.%02ld ppm over %lu s, freqcorr %d\r\n", drift_cppm < 0 ? '-' : '+',
+               labs(drift_cppm) / 100, labs(drift_cppm) % 100, (unsigned long)interval, state.freqcorr);
+        sprintf(line, "%lu,%ld,%lu,%ld,%d\n", (unsigned long)host_time, (long)offset_ms, (unsigned long)interval,
+                (long)drift_cppm, state.freqcorr);
+    } else {
+        // too soon (or too far off) to say anything about drift, but the offset is still worth a line in the log.
+        printf("drift: not measured, freqcorr %d\r\n", state.freqcorr);
+        sprintf(line, "%lu,%ld,,,%d\n", (unsigned long)host_time,
+                (long)(abs_offset_ms > INT32_MAX ? (offset_ms < 0 ? INT32_MIN : INT32_MAX) : offset_ms), state.freqcorr);
+    }
+
+    state.last_sync = host_time;
+    _freqcorr_base_time = host_time;
+    _movement_update_freqcorr();
+    filesystem_write_file(TIME_SYNC_STATE_FILE, (char *)&state, sizeof(state));
+    if (!filesystem_file_exists(TIME_SYNC_LOG_FILE)) {
+        char *header = "unix_time,offset_ms,interval_s,drift_cppm,freqcorr\n";
+        filesystem_write_file(TIME_SYNC_LOG_FILE, header, strlen(header));
+    }
+    filesystem_append_file(TIME_SYNC_LOG_FILE, line, strlen(line));
+
+    return 0;
+}
@@ -57,11 +57,67 @@ extern const size_t g_num_shell_commands;
 
 static char s_buf[SHELL_BUF_SZ] = {0};
 static size_t s_buf_len = 0;
-// Pointer to the first invalid byte after the end of input.
-static char *const s_buf_end = s_buf + SHELL_BUF_SZ;
 
-static char *prv_skip_whitespace(char *c) {
-    while (c >= s_buf && c < s_buf_end) {
+// All commands, built in and registered, sorted by name (case-insensitively) for binary search.
+static const shell_command_t *s_commands[SHELL_MAX_COMMANDS];
+static size_t s_num_commands = 0;
+static bool s_builtins_registered = false;
+
+static void prv_register_builtins(void) {
+    if (s_builtins_registered) {
+        return;
+    }
+    s_builtins_registered = true;
+    for (size_t i = 0; i < g_num_shell_commands; i++) {
+        shell_register_command(&g_shell_commands[i]);
+    }
+}
+
+// Returns the index of the command with this name, or if there isn't one, the bitwise inverse of the
+// index where it would be inserted.
+static long prv_find_command(const char *name) {
+    size_t low = 0;
+    size_t high = s_num_commands;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int cmp = strcasecmp(s_commands[mid]->name, name);
+        if (cmp == 0) {
+            return mid;
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return ~(long)low;
+}
+
+bool shell_register_command(const shell_command_t *command) {
+    prv_register_builtins();
+
+    long index = prv_find_command(command->name);
+    if (index >= 0) {
+        // Faces register their commands in setup, which runs again after every wake from sleep.
+        return s_commands[index] == command;
+    }
+    if (s_num_commands == SHELL_MAX_COMMANDS) {
+        return false;
+    }
+
+    size_t insert_at = ~index;
+    memmove(&s_commands[insert_at + 1], &s_commands[insert_at], (s_num_commands - insert_at) * sizeof(s_commands[0]));
+    s_commands[insert_at] = command;
+    s_num_commands++;
+    return true;
+}
+
+const shell_command_t *shell_get_command(size_t index) {
+    prv_register_builtins();
+    return index < s_num_commands ? s_commands[index] : NULL;
+}
+
+static char *prv_skip_whitespace(char *c, char *const buf, char *const buf_end) {
+    while (c >= buf && c < buf_end) {
         if (*c == 0) {
             return NULL;
         }
@@ -73,10 +129,10 @@ static char *prv_skip_whitespace(char *c) {
     return NULL;
 }
 
-static char *prv_skip_non_whitespace(char *c) {
+static char *prv_skip_non_whitespace(char *c, char *const buf, char *const buf_end) {
     bool in_quote = false;
     char quote_char;
-    while (c >= s_buf && c < s_buf_end) {
+    while (c >= buf && c < buf_end) {
         if (*c == 0) {
             return NULL;
         }
@@ -99,16 +155,18 @@ static char *prv_skip_non_whitespace(char *c) {
     return NULL;
 }
 
-static int prv_handle_command() {
+static int prv_handle_command(char *const buf, size_t buf_sz) {
     char *argv[SHELL_MAX_ARGS] = {0};
     int argc = 0;
+    // Pointer to the first invalid byte after the end of input.
+    char *const buf_end = buf + buf_sz;
 
-    char *c = &s_buf[0];
-    s_buf[SHELL_BUF_SZ - 1] = '\0';
+    char *c = &buf[0];
+    buf[buf_sz - 1] = '\0';
 
     while (argc < SHELL_MAX_ARGS) {
         // Skip contiguous whitespace
-        c = prv_skip_whitespace(c);
+        c = prv_skip_whitespace(c, buf, buf_end);
         if (c == NULL) {
             // Reached end of buffer
             break;
@@ -118,7 +176,7 @@ static int prv_handle_command() {
         argv[argc++] = c;
 
         // Skip contiguous non-whitespace
-        c = prv_skip_non_whitespace(c);
+        c = prv_skip_non_whitespace(c, buf, buf_end);
         if (c == NULL) {
             // Reached end of buffer
             break;
@@ -133,31 +191,46 @@ static int prv_handle_command() {
     }
 
     // Match against the command list
-    for (size_t i = 0; i < g_num_shell_commands; i++) {
-        if (!strcasecmp(g_shell_commands[i].name, argv[0])) {
-            // If argc isn't valid for this command, display its help instead.
-            if (((argc - 1) < g_shell_commands[i].min_args) ||
-                ((argc - 1) > g_shell_commands[i].max_args)) {
-                if (g_shell_commands[i].help != NULL) {
-                    printf(NEWLINE "%s" NEWLINE, g_shell_commands[i].help);
-                }
-                return -2;
-            }
-            // Call the command's callback
-            if (g_shell_commands[i].cb != NULL) {
-                printf(NEWLINE);
-                int ret = g_shell_commands[i].cb(argc, argv);
-                if (ret == -2) {
-                    printf(NEWLINE "%s" NEWLINE, g_shell_commands[i].help);
-                }
-                return ret;
-            }
+    prv_register_builtins();
+    long index = prv_find_command(argv[0]);
+    if (index < 0) {
+        return -1;
+    }
+    const shell_command_t *command = s_commands[index];
+
+    // If argc isn't valid for this command, display its help instead.
+    if (((argc - 1) < command->min_args) ||
+        ((argc - 1) > command->max_args)) {
+        if (command->help != NULL) {
+            printf(NEWLINE "%s" NEWLINE, command->help);
+        }
+        return -2;
+    }
+    // Call the command's callback
+    if (command->cb != NULL) {
+        printf(NEWLINE);
+        int ret = command->cb(argc, argv);
+        if (ret == -2) {
+            printf(NEWLINE "%s" NEWLINE, command->help);
         }
+        return ret;
     }
 
     return -1;
 }
 
+int shell_execute(const char *line) {
+    // Commands parse their arguments in place, so work on a copy; the caller's line may be in use
+    // (for instance, it may be a line of a script whose file name is in s_buf).
+    char buf[SHELL_BUF_SZ];
+    size_t len = strlen(line);
+    if (len > SHELL_BUF_SZ - 1) {
+        return -3;
+    }
+    memcpy(buf, line, len + 1);
+    return prv_handle_command(buf, SHELL_BUF_SZ);
+}
+
 void shell_task(void) {
 #if __EMSCRIPTEN__
     // This is a terrible hack; ideally this should be handled deeper in the watch library.
@@ -176,7 +249,7 @@ void shell_task(void) {
     free(received_data);
     s_buf[s_buf_len++] = '\n';
     s_buf[s_buf_len++] = '\0';
-    prv_handle_command();
+    prv_handle_command(s_buf, SHELL_BUF_SZ);
     EM_ASM({
         tx = "";
     });
@@ -216,7 +289,7 @@ void shell_task(void) {
         if (c == '\n' || c == '\r') {
             // Newline! Handle the command.
             s_buf[s_buf_len+1] = '\0';
-            (void) prv_handle_command();
+            (void) prv_handle_command(s_buf, SHELL_BUF_SZ);
             s_buf_len = 0;
             printf(NEWLINE SHELL_PROMPT);
             break;
@@ -25,10 +25,40 @@
 #ifndef SHELL_H_
 #define SHELL_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include "shell_cmd_list.h"
+
+// Room for the built in commands plus any that watch faces register.
+#define SHELL_MAX_COMMANDS (48)
+
 /** @brief Called periodically from the app loop to handle shell commands.
  *         When a full command is complete, parses and executes its matching
  *         callback.
  */
 void shell_task(void);
 
+/** @brief Adds a command to the shell.
+ * @details Watch faces can call this from their setup function to add their own commands. Commands are kept
+ *          sorted by name, and looked up with a binary search. Registering the same command again (as happens
+ *          when setup runs after waking from sleep) is harmless.
+ * @param command The command to add. It is not copied, so it must stay valid; make it static.
+ * @return true if the command was added or was already registered; false if another command already has
+ *         this name, or if there is no room for more commands (see SHELL_MAX_COMMANDS).
+ */
+bool shell_register_command(const shell_command_t *command);
+
+/** @brief Gets a command from the shell's command list, in alphabetical order.
+ * @param index The index of the command, from 0.
+ * @return The command, or NULL if index is past the end of the list.
+ */
+const shell_command_t *shell_get_command(size_t index);
+
+/** @brief Parses and runs a single command line, as if it had been typed into the shell.
+ * @param line The command line, without a trailing newline.
+ * @return The command's return value: 0 for success, -1 if there is no such command, -2 if its arguments
+ *         were invalid (in which case its help was printed), or -3 if the line is too long.
+ */
+int shell_execute(const char *line);
+
 #endif
@@ -23,18 +23,28 @@
  */
 
 #include "shell_cmd_list.h"
+#include "shell.h"
 
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "filesystem.h"
+#include "movement.h"
+#include "shell_movement_cmds.h"
 #include "watch.h"
 #include "delay.h"
 
+#if !__EMSCRIPTEN__
+#include "watch_usb_cdc.h"
+#endif
+
 static int help_cmd(int argc, char *argv[]);
 static int flash_cmd(int argc, char *argv[]);
 static int stress_cmd(int argc, char *argv[]);
+static int run_cmd(int argc, char *argv[]);
 
 shell_command_t g_shell_commands[] = {
     {
@@ -95,9 +105,9 @@ shell_command_t g_shell_commands[] = {
     },
     {
         .name = "format",
-        .help = "usage: format YES",
+        .help = "usage: format [/ext] YES",
         .min_args = 1,
-        .max_args = 1,
+        .max_args = 2,
         .cb = filesystem_cmd_format,
     },
     {
@@ -107,11 +117,74 @@ shell_command_t g_shell_commands[] = {
         .max_args = 3,
         .cb = filesystem_cmd_echo,
     },
+    {
+        .name = "rx",
+        .help = "receive a file from utils/file_transfer/file_transfer.py; usage: rx FILE [resume]",
+        .min_args = 1,
+        .max_args = 2,
+        .cb = filesystem_cmd_rx,
+    },
+    {
+        .name = "tx",
+        .help = "send a file to utils/file_transfer/file_transfer.py; usage: tx FILE [OFFSET]",
+        .min_args = 1,
+        .max_args = 2,
+        .cb = filesystem_cmd_tx,
+    },
+    {
+        .name = "accel",
+        .help = "usage: accel stream [100|200|400] [SECONDS] [csv|bin], or accel activity",
+        .min_args = 1,
+        .max_args = 4,
+        .cb = movement_cmd_accel,
+    },
+    {
+        .name = "boot",
+        .help = "print time to first pixel for the last boot",
+        .min_args = 0,
+        .max_args = 0,
+        .cb = movement_cmd_boot,
+    },
+    {
+        .name = "time",
+        .help = "print UTC time in ms, or set it from utils/time_sync/time_sync.py; usage: time [sync UNIX.MMM [LATENCY_MS]]",
+        .min_args = 0,
+        .max_args = 3,
+        .cb = movement_cmd_time,
+    },
+    {
+        .name = "battery",
+        .help = "print battery voltage, runtime estimate and daily min/max history",
+        .min_args = 0,
+        .max_args = 0,
+        .cb = movement_cmd_battery,
+    },
+    {
+        .name = "tempco",
+        .help = "print the crystal compensation profile, or its hourly log as CSV; usage: tempco [log|set FIELD VALUE]",
+        .min_args = 0,
+        .max_args = 3,
+        .cb = movement_cmd_tempco,
+    },
+    {
+        .name = "sensors",
+        .help = "list the sensors, with their capabilities, power state and last reading",
+        .min_args = 0,
+        .max_args = 0,
+        .cb = movement_cmd_sensors,
+    },
+    {
+        .name = "run",
+        .help = "run the commands in a script file, one per line; usage: run FILE",
+        .min_args = 1,
+        .max_args = 1,
+        .cb = run_cmd,
+    },
     {
         .name = "stress",
-        .help = "test CDC write; usage: stress [LEN] [DELAY_MS]",
+        .help = "test CDC write; usage: stress [LEN] [DELAY_MS] [block]",
         .min_args = 0,
-        .max_args = 2,
+        .max_args = 3,
         .cb = stress_cmd,
     },
 };
@@ -123,16 +196,67 @@ static int help_cmd(int argc, char *argv[]) {
     (void) argv;
 
     printf("Command List:\r\n");
-    for (size_t i = 0; i < g_num_shell_commands; i++) {
+    const shell_command_t *command;
+    for (size_t i = 0; (command = shell_get_command(i)) != NULL; i++) {
         printf(" %s\t%s\r\n",
-                g_shell_commands[i].name,
-                (g_shell_commands[i].help) ? g_shell_commands[i].help : ""
+                command->name,
+                (command->help) ? command->help : ""
         );
     }
 
     return 0;
 }
 
+#define RUN_CMD_MAX_LINE  (128)
+static int run_cmd(int argc, char *argv[]) {
+    (void) argc;
+    static bool running = false;
+
+    // A script that runs itself (or another script) would only be a way to run out of stack.
+    if (running) {
+        printf("run: scripts can't run other scripts\r\n");
+        return 1;
+    }
+
+    char *filename = argv[1];
+    int32_t file_size = filesystem_get_file_size(filename);
+    if (file_size < 0) {
+        printf("run: %s: No such file\r\n", filename);
+        return 1;
+    }
+
+    running = true;
+    char line[RUN_CMD_MAX_LINE + 1];
+    int32_t offset = 0;
+    int line_number = 0;
+    int ret = 0;
+    while (offset < file_size) {
+        if (!filesystem_read_line(filename, line, &offset, RUN_CMD_MAX_LINE)) {
+            ret = 1;
+            break;
+        }
+        line_number++;
+
+        // Skip blank lines and comments.
+        char *c = line;
+        while (*c == ' ' || *c == '\t' || *c == '\r') c++;
+        if (*c == '\0' || *c == '#') {
+            continue;
+        }
+
+        printf("+ %s", c);
+        ret = shell_execute(c);
+        if (ret != 0) {
+            // Stop at the first failure, so a half-provisioned watch is obvious.
+            printf("\r\nrun: %s:%d: failed (%d)\r\n", filename, line_number, ret);
+            break;
+        }
+    }
+    running = false;
+
+    return ret == 0 ? 0 : 1;
+}
+
 static int flash_cmd(int argc, char *argv[]) {
     (void) argc;
     (void) argv;
@@ -161,6 +285,15 @@ static int stress_cmd(int argc, char *argv[]) {
         delay = atoi(argv[2]);
     }
 
+#if !__EMSCRIPTEN__
+    // with "block", output waits for the host instead of overwriting whatever hasn't been sent yet.
+    bool blocking = (argc >= 4) && !strcmp(argv[3], "block");
+    cdc_set_blocking_writes(blocking);
+    cdc_wait_for_write_space(SIZE_MAX);
+    cdc_reset_write_stats();
+    rtc_counter_t start = watch_rtc_get_counter();
+#endif
+
     for (int i = 0; i < max_len; i++) {
         snprintf(&test_str[i], 2, "%u", (i+1)%10);
         printf("%u:\t%s\r\n", (i+1), test_str);
@@ -169,5 +302,21 @@ static int stress_cmd(int argc, char *argv[]) {
         }
     }
 
+#if !__EMSCRIPTEN__
+    // let everything drain before taking the measurement, so the report itself doesn't skew it.
+    fflush(stdout);
+    cdc_wait_for_write_space(SIZE_MAX);
+    rtc_counter_t elapsed = watch_rtc_get_counter() - start;
+    cdc_write_stats_t stats = cdc_get_write_stats();
+    cdc_set_blocking_writes(false);
+
+    uint32_t elapsed_ms = elapsed * 1000 / watch_rtc_get_frequency();
+    printf("\r\n%lu bytes in %lu ms", stats.bytes_queued, elapsed_ms);
+    if (elapsed_ms) {
+        printf(" (%lu bytes/s)", stats.bytes_sent * 1000 / elapsed_ms);
+    }
+    printf(", %lu dropped, %s mode\r\n", stats.bytes_dropped, blocking ? "blocking" : "non-blocking");
+#endif
+
     return 0;
 }
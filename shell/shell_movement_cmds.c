@@ -0,0 +1,343 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shell_movement_cmds.h"
+#include "movement.h"
+#include "movement_private.h"
+#if defined(I2C_SERCOM) && !__EMSCRIPTEN__
+#include "watch_usb_cdc.h"
+#endif
+
+int movement_cmd_battery(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    movement_battery_status_t status = movement_get_battery_status();
+
+    printf("voltage: %u mV, %lu s ago\r\n", status.voltage, (unsigned long)status.age);
+    if (status.loaded_voltage) printf("under load: %u mV\r\n", status.loaded_voltage);
+    if (status.max_today) printf("today: %u-%u mV\r\n", status.min_today, status.max_today);
+    printf("awake: %lu s, low energy: %lu s\r\n", (unsigned long)status.awake_seconds, (unsigned long)status.sleep_seconds);
+    if (status.runtime_days == MOVEMENT_BATTERY_RUNTIME_UNKNOWN) printf("runtime: unknown\r\n");
+    else printf("runtime: %u days\r\n", status.runtime_days);
+
+    // oldest first, like any other log.
+    movement_battery_day_t days[MOVEMENT_BATTERY_HISTORY_DAYS];
+    uint8_t count = movement_get_battery_history(days, MOVEMENT_BATTERY_HISTORY_DAYS);
+    printf("unix_time,min_mv,max_mv,awake_min\r\n");
+    while (count--) {
+        printf("%lu,%u,%u,%u\r\n", (unsigned long)days[count].day * 86400, days[count].min_voltage,
+               days[count].max_voltage, days[count].awake_minutes);
+    }
+
+    return 0;
+}
+
+int movement_cmd_tempco(int argc, char *argv[]) {
+    movement_tempco_profile_t profile = movement_get_tempco_profile();
+    struct {
+        const char *name;
+        int16_t *value;
+    } fields[] = {
+        { "center_temperature", &profile.center_temperature },
+        { "quadratic_tempco", &profile.quadratic_tempco },
+        { "cubic_tempco", &profile.cubic_tempco },
+        { "aging", &profile.aging },
+        { "offset", &profile.offset },
+    };
+    const uint8_t num_fields = sizeof(fields) / sizeof(fields[0]);
+
+    if (argc == 1) {
+        for (uint8_t i = 0; i < num_fields; i++) printf("%s: %d\r\n", fields[i].name, *fields[i].value);
+        printf("calibration_time: %lu\r\n", (unsigned long)profile.calibration_time);
+        printf("correction: %d cppm, freqcorr %d (time sync %d)\r\n", movement_get_frequency_correction(),
+               _movement_freqcorr_written() == INT16_MIN ? 0 : _movement_freqcorr_written(), _movement_time_sync_freqcorr());
+        return 0;
+    }
+
+    if (strcmp(argv[1], "log") == 0) {
+        // oldest first, like any other log.
+        movement_tempco_hour_t hours[MOVEMENT_TEMPCO_LOG_HOURS];
+        uint8_t count = movement_get_tempco_log(hours, MOVEMENT_TEMPCO_LOG_HOURS);
+        printf("unix_time,temperature_cc,correction_cppm\r\n");
+        while (count--) {
+            if (hours[count].temperature == INT16_MAX) {
+                printf("%lu,,%d\r\n", (unsigned long)hours[count].timestamp, hours[count].correction);
+            } else {
+                printf("%lu,%d,%d\r\n", (unsigned long)hours[count].timestamp, hours[count].temperature, hours[count].correction);
+            }
+        }
+        return 0;
+    }
+
+    if (strcmp(argv[1], "set") == 0 && argc == 4) {
+        for (uint8_t i = 0; i < num_fields; i++) {
+            if (strcmp(argv[2], fields[i].name) == 0) {
+                *fields[i].value = atoi(argv[3]);
+                movement_set_tempco_profile(profile);
+                return 0;
+            }
+        }
+    }
+
+    return -2;
+}
+
+static bool _movement_parse_time_ms(char *arg, unix_timestamp_t *timestamp, uint16_t *ms) {
+    char *end;
+    *timestamp = strtoul(arg, &end, 10);
+    *ms = 0;
+    if (end == arg) return false;
+    if (*end == '.') {
+        // take up to three digits of fraction; "5.1" is 100 ms, not 1.
+        uint16_t scale = 100;
+        for (end++; *end >= '0' && *end <= '9'; end++) {
+            *ms += (*end - '0') * scale;
+            scale /= 10;
+        }
+    }
+    return *end == '\0';
+}
+
+int movement_cmd_time(int argc, char *argv[]) {
+    if (argc == 1) {
+        // this doubles as the ping that utils/time_sync/time_sync.py times to work out the USB latency.
+        uint16_t ms;
+        unix_timestamp_t timestamp = watch_rtc_get_unix_time_ms(&ms);
+        printf("%lu.%03u\r\n", (unsigned long)timestamp, ms);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "sync") != 0 || argc < 3) return -2;
+
+    unix_timestamp_t host_time;
+    uint16_t host_ms;
+    if (!_movement_parse_time_ms(argv[2], &host_time, &host_ms)) return -2;
+
+    // the host stamps the command when it sends it; the one-way latency it measured is how stale that is by now.
+    if (argc >= 4) {
+        int latency_ms = atoi(argv[3]);
+        if (latency_ms < 0) return -2;
+        uint32_t total_ms = host_ms + latency_ms;
+        host_time += total_ms / 1000;
+        host_ms = total_ms % 1000;
+    }
+
+    return _movement_time_sync(host_time, host_ms);
+}
+
+int movement_cmd_sensors(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    static const char *power_states[] = { "absent", "off", "standby", "on" };
+
+    for (movement_sensor_t sensor = 0; sensor < MOVEMENT_NUM_SENSORS; sensor++) {
+        uint8_t capabilities = movement_sensor_get_capabilities(sensor);
+        movement_sensor_reading_t reading;
+
+        printf("%s: %s", movement_sensor_get_name(sensor), power_states[movement_sensor_get_power_state(sensor)]);
+        if (capabilities & MOVEMENT_SENSOR_CAP_SAMPLE) printf(", sample");
+        if (capabilities & MOVEMENT_SENSOR_CAP_BATCH) printf(", batch");
+        if (capabilities & MOVEMENT_SENSOR_CAP_INTERRUPT) printf(", interrupt");
+        if (capabilities & MOVEMENT_SENSOR_CAP_SIMULATED) printf(", simulated");
+        if (_movement_sensor_subscriber_count(sensor)) printf(", %u subscribers", _movement_sensor_subscriber_count(sensor));
+        if (movement_sensor_get_last_reading(sensor, &reading)) {
+            // no floats in printf here; thousandths will do.
+            uint8_t num_values = sensor == MOVEMENT_SENSOR_ACCELEROMETER ? 3 : 1;
+            printf(", last");
+            for (uint8_t i = 0; i < num_values; i++) printf(" %ld", lroundf(reading.values[i] * 1000));
+            printf(" (x1000) %lu s ago", (unsigned long)((watch_rtc_get_counter() - reading.counter) / watch_rtc_get_frequency()));
+        }
+        printf("\r\n");
+    }
+
+    return 0;
+}
+
+#if defined(I2C_SERCOM) && !__EMSCRIPTEN__
+
+// accel stream keeps the FIFO between this watermark and full, and drains all of it at once.
+#define ACCEL_STREAM_FIFO_THRESHOLD (24)
+
+static volatile bool _accel_stream_fifo_ready;
+
+static void _cb_accel_stream_fifo_ready(void) {
+    _accel_stream_fifo_ready = true;
+}
+
+static int _movement_accel_stream(uint16_t rate, uint16_t seconds, bool binary) {
+    lis2dw_data_rate_t data_rate;
+    switch (rate) {
+        case 100: data_rate = LIS2DW_DATA_RATE_100_HZ; break;
+        case 200: data_rate = LIS2DW_DATA_RATE_200_HZ; break;
+        case 400: data_rate = LIS2DW_DATA_RATE_HP_400_HZ; break;
+        default: return -2;
+    }
+
+    // stash the background configuration so we can put it back when we're done.
+    lis2dw_mode_t saved_mode = lis2dw_get_mode();
+    lis2dw_low_power_mode_t saved_low_power_mode = lis2dw_get_low_power_mode();
+    lis2dw_data_rate_t saved_data_rate = lis2dw_get_data_rate();
+    uint8_t saved_int1 = lis2dw_get_int1_configuration();
+    bool saved_sleep = lis2dw_get_sleep_enabled();
+    bool saved_stationary = lis2dw_get_stationary_motion_detection();
+
+    // 400 Hz is only available in high performance mode. Stream mode overwrites the oldest samples if we fall
+    // behind, and the overrun flag tells us if that ever happened. With sleep on, holding the watch still would
+    // drop the rate to 1.6 Hz partway through the stream.
+    lis2dw_disable_sleep();
+    lis2dw_disable_stationary_motion_detection();
+    lis2dw_set_mode(LIS2DW_MODE_HIGH_PERFORMANCE);
+    lis2dw_configure_fifo(LIS2DW_FIFO_MODE_OFF, 0);
+    lis2dw_configure_fifo(LIS2DW_FIFO_MODE_COLLECT_CONTINUOUS, ACCEL_STREAM_FIFO_THRESHOLD);
+    lis2dw_configure_int1(LIS2DW_CTRL4_INT1_FTH);
+    _accel_stream_fifo_ready = false;
+    watch_register_interrupt_callback(HAL_GPIO_A3_pin(), _cb_accel_stream_fifo_ready, INTERRUPT_TRIGGER_RISING);
+    lis2dw_set_data_rate(data_rate);
+
+    uint32_t frequency = watch_rtc_get_frequency();
+    rtc_counter_t end = watch_rtc_get_counter() + seconds * frequency;
+    // if an edge ever gets lost, don't wait more than twice as long as a watermark's worth of samples takes.
+    rtc_counter_t max_wait = (2 * ACCEL_STREAM_FIFO_THRESHOLD * frequency) / rate + 1;
+    rtc_counter_t last_read = watch_rtc_get_counter();
+
+    static lis2dw_reading_t readings[32];
+    uint32_t num_samples = 0;
+    uint32_t num_overruns = 0;
+
+    // CSV output follows the motion dump format that utils/motion_express_utilities/process_motion_dump.py expects.
+    if (!binary) printf("TE.STREAM_%uHZ.CSV\n", rate);
+
+    while ((int32_t)(watch_rtc_get_counter() - end) < 0) {
+        if (!_accel_stream_fifo_ready && (watch_rtc_get_counter() - last_read) < max_wait) {
+            if (!cdc_service()) break;
+            continue;
+        }
+        _accel_stream_fifo_ready = false;
+        last_read = watch_rtc_get_counter();
+
+        bool overrun;
+        uint8_t count = lis2dw_read_fifo_burst(readings, 32, &overrun);
+        if (overrun) num_overruns++;
+        if (count == 0) continue;
+
+        if (binary) {
+            // frame: 0xA5, sample count, overrun flag, then count X/Y/Z samples as little-endian int16s.
+            uint8_t header[3] = {0xA5, count, overrun};
+            if (!cdc_wait_for_write_space(sizeof(header) + count * sizeof(lis2dw_reading_t))) break;
+            fwrite(header, 1, sizeof(header), stdout);
+            fwrite(readings, sizeof(lis2dw_reading_t), count, stdout);
+        } else {
+            // each line is at most 32 characters: "4294967295,-32768,-32768,-32768\n"
+            if (!cdc_wait_for_write_space(count * 32)) break;
+            for (uint8_t i = 0; i < count; i++) {
+                printf("%lu,%d,%d,%d\n", num_samples + i, readings[i].x, readings[i].y, readings[i].z);
+            }
+        }
+        fflush(stdout);
+        num_samples += count;
+    }
+
+    lis2dw_set_data_rate(saved_data_rate);
+    lis2dw_configure_fifo(LIS2DW_FIFO_MODE_OFF, 0);
+    lis2dw_configure_int1(saved_int1);
+    lis2dw_set_mode(saved_mode);
+    lis2dw_set_low_power_mode(saved_low_power_mode);
+    if (saved_stationary) lis2dw_enable_stationary_motion_detection();
+    if (saved_sleep) lis2dw_enable_sleep();
+    watch_register_interrupt_callback(HAL_GPIO_A3_pin(), cb_accelerometer_event, INTERRUPT_TRIGGER_RISING);
+    _movement_update_accelerometer_service();
+
+    // process_motion_dump.py closes its file at the end marker, so the CSV stream can't have anything after it.
+    if (binary) printf("\r\n%lu samples, %lu overruns\r\n", num_samples, num_overruns);
+    else printf("=== END ===\n");
+
+    return 0;
+}
+
+#endif
+
+int movement_cmd_accel(int argc, char *argv[]) {
+    if (strcmp(argv[1], "stream") != 0 && strcmp(argv[1], "activity") != 0) return -2;
+
+#if defined(I2C_SERCOM) && !__EMSCRIPTEN__
+    if (!movement_state.has_lis2dw) {
+        printf("No accelerometer found\r\n");
+        return 1;
+    }
+
+    if (strcmp(argv[1], "activity") == 0) {
+        movement_accelerometer_activity_t activity = movement_get_accelerometer_activity();
+        rtc_counter_t now = watch_rtc_get_counter();
+        uint32_t frequency = watch_rtc_get_frequency();
+        printf("%s for %lus\r\n", activity.is_active ? "active" : "inactive",
+               (now - activity.last_state_change) / frequency);
+        printf("%lu wakes, %lu sleeps\r\n", activity.activity_count, activity.inactivity_count);
+        printf("%lu orientation changes, last %lus ago, facing 0x%02x\r\n", activity.orientation_changes,
+               (now - activity.last_orientation_change) / frequency, activity.orientation);
+        return 0;
+    }
+
+    uint16_t rate = (argc >= 3) ? atoi(argv[2]) : 100;
+    uint16_t seconds = (argc >= 4) ? atoi(argv[3]) : 10;
+    bool binary = false;
+    if (argc >= 5) {
+        if (strcmp(argv[4], "bin") == 0) binary = true;
+        else if (strcmp(argv[4], "csv") != 0) return -2;
+    }
+
+    return _movement_accel_stream(rate, seconds, binary);
+#else
+    (void) argc;
+    printf("No accelerometer found\r\n");
+    return 1;
+#endif
+}
+
+int movement_cmd_boot(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    const char *settings_sources[] = {"defaults", "backup register", "settings.u32"};
+    uint32_t frequency = watch_rtc_get_frequency();
+
+    rtc_counter_t first_pixel_ticks, boot_complete_ticks;
+    if (!_movement_get_boot_timing(&first_pixel_ticks, &boot_complete_ticks)) {
+        printf("Boot in progress\r\n");
+        return 1;
+    }
+
+    // resolution is one RTC tick, and the time before app_init (bootloader, clock setup) isn't counted.
+    printf("first pixel: %lu ms\r\n", (unsigned long)(first_pixel_ticks * 1000 / frequency));
+    printf("filesystem ready: %lu ms\r\n", (unsigned long)(boot_complete_ticks * 1000 / frequency));
+    printf("settings from: %s\r\n", settings_sources[_movement_settings_source]);
+
+    return 0;
+}
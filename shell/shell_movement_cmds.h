@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHELL_MOVEMENT_CMDS_H_
+#define SHELL_MOVEMENT_CMDS_H_
+
+// Shell commands for Movement's services. shell_cmd_list.c has the usage for each.
+
+// shell command that prints the UTC time to the millisecond, or sets it with "time sync UNIX.MMM [LATENCY_MS]".
+// Each sync logs the offset to timesync.csv, and after at least six hours, corrects the RTC frequency for the drift.
+int movement_cmd_time(int argc, char *argv[]);
+
+// shell command that prints the battery status and runtime estimate, and the daily history as CSV.
+int movement_cmd_battery(int argc, char *argv[]);
+
+// shell command that prints the crystal compensation profile and status, with "tempco log", the hourly log as CSV,
+// or with "tempco set FIELD VALUE", changes one field of the profile.
+int movement_cmd_tempco(int argc, char *argv[]);
+
+// shell command that lists the sensors, with their capabilities, power state and last reading.
+int movement_cmd_sensors(int argc, char *argv[]);
+
+// shell command that streams raw accelerometer samples at 100, 200 or 400 Hz, as CSV or binary frames,
+// or with "accel activity", prints the activity and orientation counts.
+int movement_cmd_accel(int argc, char *argv[]);
+
+// shell command that reports how long the last boot took to get the first face on screen.
+int movement_cmd_boot(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Copy files to and from a Sensor Watch over its USB serial shell.
+
+This drives the watch's `rx` and `tx` shell commands, which speak a small framed binary protocol:
+
+    0x7E | type | seq | offset (u32) | length (u16) | payload | CRC-16/CCITT (u16)
+
+All multi-byte fields are little-endian, and the CRC covers type through the end of the payload.
+See the comment above filesystem_cmd_rx in filesystem/filesystem.c for the details.
+
+Usage:
+    file_transfer.py PORT put LOCAL_FILE WATCH_FILE [--resume]
+    file_transfer.py PORT get WATCH_FILE LOCAL_FILE [--resume]
+
+--resume picks up an interrupted transfer where it left off instead of starting over.
+
+Requires pyserial (pip install pyserial).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+import serial
+
+SOF = 0x7E
+HEADER = struct.Struct('<BBIH')  # type, seq, offset, length (after SOF)
+MAX_PAYLOAD = 128
+TIMEOUT = 2.0
+MAX_RETRIES = 5
+
+READY, DATA, EOF, ACK, NAK, CANCEL = (ord(c) for c in 'RDEANC')
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def send_frame(port, frame_type, seq, offset, payload=b''):
+    body = HEADER.pack(frame_type, seq & 0xFF, offset, len(payload)) + payload
+    port.write(bytes([SOF]) + body + struct.pack('<H', crc16(body)))
+
+
+def receive_frame(port, timeout=TIMEOUT):
+    """Returns (type, seq, offset, payload), or None on timeout or a corrupt frame."""
+    deadline = time.monotonic() + timeout
+
+    def read(count):
+        data = b''
+        while len(data) < count:
+            if time.monotonic() > deadline:
+                return None
+            data += port.read(count - len(data))
+        return data
+
+    # skip the echoed command line and anything else that isn't a frame.
+    while True:
+        byte = read(1)
+        if byte is None:
+            return None
+        if byte[0] == SOF:
+            break
+
+    header = read(HEADER.size)
+    if header is None:
+        return None
+    frame_type, seq, offset, length = HEADER.unpack(header)
+    if length > MAX_PAYLOAD:
+        return None
+    rest = read(length + 2)
+    if rest is None:
+        return None
+    payload, (crc,) = rest[:length], struct.unpack('<H', rest[length:])
+    if crc != crc16(header + payload):
+        return None
+    return frame_type, seq, offset, payload
+
+
+def start_command(port, command):
+    port.reset_input_buffer()
+    port.write(command.encode('ascii') + b'\n')
+    for _ in range(MAX_RETRIES):
+        frame = receive_frame(port)
+        if frame is None:
+            continue
+        if frame[0] == CANCEL:
+            sys.exit(f'watch refused "{command}"')
+        if frame[0] == READY:
+            return frame
+    sys.exit(f'no response to "{command}"; is the shell running?')
+
+
+def put(port, local_file, watch_file, resume):
+    with open(local_file, 'rb') as f:
+        data = f.read()
+
+    _, _, offset, _ = start_command(port, f'rx {watch_file}' + (' resume' if resume else ''))
+    if offset > len(data):
+        sys.exit(f'{watch_file} on the watch is already larger than {local_file}')
+
+    seq = 0
+    retries = 0
+    started = time.monotonic()
+    while retries <= MAX_RETRIES:
+        if offset < len(data):
+            send_frame(port, DATA, seq, offset, data[offset:offset + MAX_PAYLOAD])
+        else:
+            send_frame(port, EOF, seq, len(data))
+
+        frame = receive_frame(port)
+        if frame is None:
+            retries += 1
+            continue
+        retries = 0
+
+        frame_type, _, acked_offset, _ = frame
+        if frame_type == CANCEL:
+            sys.exit('watch cancelled the transfer (out of space?)')
+        if frame_type == ACK and offset == len(data) and acked_offset == len(data):
+            break
+        if frame_type in (ACK, NAK) and acked_offset <= len(data):
+            if acked_offset != offset:
+                seq += 1
+            offset = acked_offset
+            print(f'\r{offset}/{len(data)} bytes', end='', file=sys.stderr)
+    else:
+        sys.exit('\ntransfer failed; run again with --resume to continue')
+
+    elapsed = time.monotonic() - started
+    print(f'\rsent {len(data)} bytes in {elapsed:.1f} s', file=sys.stderr)
+
+
+def get(port, watch_file, local_file, resume):
+    have = os.path.getsize(local_file) if resume and os.path.exists(local_file) else 0
+    _, _, size, _ = start_command(port, f'tx {watch_file} {have}')
+
+    started = time.monotonic()
+    with open(local_file, 'ab' if resume else 'wb') as f:
+        retries = 0
+        while retries <= MAX_RETRIES:
+            frame = receive_frame(port)
+            if frame is None:
+                # ask for whatever we're missing again.
+                retries += 1
+                send_frame(port, NAK, 0, have)
+                continue
+            retries = 0
+
+            frame_type, seq, offset, payload = frame
+            if frame_type == CANCEL:
+                sys.exit('watch cancelled the transfer')
+            if frame_type == DATA:
+                if offset == have:
+                    f.write(payload)
+                    have += len(payload)
+                    send_frame(port, ACK, seq, have)
+                else:
+                    send_frame(port, ACK if offset < have else NAK, seq, have)
+                print(f'\r{have}/{size} bytes', end='', file=sys.stderr)
+            elif frame_type == EOF:
+                send_frame(port, ACK if offset == have else NAK, seq, have)
+                if offset == have:
+                    break
+        else:
+            sys.exit('\ntransfer failed; run again with --resume to continue')
+
+    elapsed = time.monotonic() - started
+    print(f'\rreceived {have} bytes in {elapsed:.1f} s', file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Copy files to and from a Sensor Watch over USB.')
+    parser.add_argument('port', help='serial port, e.g. /dev/ttyACM0 or COM3')
+    parser.add_argument('direction', choices=['put', 'get'])
+    parser.add_argument('source')
+    parser.add_argument('destination')
+    parser.add_argument('--resume', action='store_true', help='continue an interrupted transfer')
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, 115200, timeout=0.1) as port:
+        if args.direction == 'put':
+            put(port, args.source, args.destination, args.resume)
+        else:
+            get(port, args.source, args.destination, args.resume)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Set a Sensor Watch's clock from this computer's over its USB serial shell.
+
+This times a few round trips of the watch's `time` shell command, which prints the watch's UTC time to the
+millisecond, and takes the fastest one as the best estimate of the USB latency. It then sends
+
+    time sync UNIX.MMM LATENCY_MS
+
+stamped with this computer's clock as the command goes out. The watch adds the one-way latency, sets its clock
+(subsecond phase included), and logs how far off it was to timesync.csv. After the first sync, every sync at least
+six hours after the previous one also corrects the RTC frequency for the drift it measured; see _movement_time_sync in
+movement_timesync.c for the details (the shell command itself is in shell/shell_movement_cmds.c).
+
+Keep this computer's own clock synced over NTP, or you'll be teaching the watch this computer's drift instead.
+
+Usage:
+    time_sync.py PORT [--pings N] [--dry-run]
+
+Requires pyserial (pip install pyserial).
+"""
+
+import argparse
+import re
+import sys
+import time
+
+import serial
+
+TIMEOUT = 2.0
+WATCH_TIME = re.compile(rb'^(\d+)\.(\d{3})\s*$')
+
+
+def ping(port):
+    """Returns (round trip in seconds, watch time minus this computer's time in seconds), or None on timeout."""
+    port.reset_input_buffer()
+    sent = time.time()
+    port.write(b'time\n')
+    deadline = time.monotonic() + TIMEOUT
+    # skip the echoed command line and the prompt.
+    while time.monotonic() < deadline:
+        match = WATCH_TIME.match(port.readline())
+        if match:
+            received = time.time()
+            watch = int(match.group(1)) + int(match.group(2)) / 1000
+            return received - sent, watch - (sent + received) / 2
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Set a Sensor Watch\'s clock over USB.')
+    parser.add_argument('port', help='serial port, e.g. /dev/ttyACM0 or COM3')
+    parser.add_argument('--pings', type=int, default=8, help='round trips to time before syncing')
+    parser.add_argument('--dry-run', action='store_true', help='report the offset without setting the clock')
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, 115200, timeout=0.1) as port:
+        samples = [sample for sample in (ping(port) for _ in range(args.pings)) if sample is not None]
+        if not samples:
+            sys.exit('no response to "time"; is the shell running?')
+
+        # the fastest round trip is the one least delayed by whatever else the watch or USB stack was doing.
+        round_trip, offset = min(samples)
+        print(f'round trip {round_trip * 1000:.1f} ms, watch is {offset * 1000:+.0f} ms off', file=sys.stderr)
+        if args.dry_run:
+            return
+
+        latency_ms = round(round_trip * 1000 / 2)
+        port.reset_input_buffer()
+        port.write(f'time sync {time.time():.3f} {latency_ms}\n'.encode('ascii'))
+
+        # setting the phase can hold the watch for up to a second, so give it a moment to report back.
+        deadline = time.monotonic() + TIMEOUT
+        while time.monotonic() < deadline:
+            line = port.readline().decode('ascii', 'replace').strip()
+            if line.startswith(('offset:', 'drift:')):
+                print(line)
+                if line.startswith('drift:'):
+                    break
+
+
+if __name__ == '__main__':
+    main()
@@ -25,12 +25,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include "light_sensor_face.h"
-#include "tc.h"
-#include "eic.h"
-#include "usb.h"
-#include "adc.h"
-
-#ifdef HAS_IR_SENSOR
 
 void light_sensor_face_setup(uint8_t watch_face_index, void ** context_ptr) {
     (void) watch_face_index;
@@ -39,11 +33,8 @@ void light_sensor_face_setup(uint8_t watch_face_index, void ** context_ptr) {
 
 void light_sensor_face_activate(void *context) {
     (void) context;
-    HAL_GPIO_IR_ENABLE_out();
-    HAL_GPIO_IR_ENABLE_clr();
-    HAL_GPIO_IRSENSE_pmuxen(HAL_GPIO_PMUX_ADC);
-    adc_init();
-    adc_enable();
+    // keeps the sensor powered between ticks.
+    movement_sensor_subscribe(MOVEMENT_SENSOR_IR);
     movement_request_tick_frequency(8);
 }
 
@@ -56,10 +47,14 @@ bool light_sensor_face_loop(movement_event_t event, void *context) {
         case EVENT_TICK:
         {
             char buf[7];
-            uint16_t light_level = adc_get_analog_value(HAL_GPIO_IRSENSE_pin());
-            snprintf(buf, 7, "%-6d", light_level);
+            movement_sensor_reading_t reading;
             watch_display_text_with_fallback(WATCH_POSITION_TOP, "LIGHT", "LL");
-            watch_display_text(WATCH_POSITION_BOTTOM, buf);
+            if (movement_sensor_sample(MOVEMENT_SENSOR_IR, &reading)) {
+                snprintf(buf, 7, "%-6d", (uint16_t)reading.values[0]);
+                watch_display_text(WATCH_POSITION_BOTTOM, buf);
+            } else {
+                watch_display_text(WATCH_POSITION_BOTTOM, "no sen");
+            }
         }
             break;
         case EVENT_LIGHT_BUTTON_UP:
@@ -78,10 +73,5 @@ bool light_sensor_face_loop(movement_event_t event, void *context) {
 void light_sensor_face_resign(void *context) {
     (void) context;
 
-    adc_disable();
-    HAL_GPIO_IRSENSE_pmuxdis();
-    HAL_GPIO_IRSENSE_off();
-    HAL_GPIO_IR_ENABLE_off();
+    movement_sensor_unsubscribe(MOVEMENT_SENSOR_IR);
 }
-
-#endif // HAS_IR_SENSOR
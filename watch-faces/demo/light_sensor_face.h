@@ -26,12 +26,12 @@
 
 #include "movement.h"
 
-#ifdef HAS_IR_SENSOR
-
 /*
  * LIGHT SENSOR PLAYGROUND
  *
  * Temporary watch face for playing with the light sensor.
+ * Shows the IR sensor's raw reading, or "no sen" if the board doesn't have one. In the simulator, it
+ * shows Movement's stand-in, which follows the time of day.
  * WARNING: This watch face may not play nicely with watch faces that use the ADC in the background,
  * such as the temperature logger. More improvement and testing needs to be done before this is can
  * be considered a production-ready watch face.
@@ -50,5 +50,3 @@ void light_sensor_face_resign(void *context);
     light_sensor_face_resign, \
     NULL, \
 })
-
-#endif // HAS_IR_SENSOR
@@ -27,6 +27,7 @@
 #include "chirpy_demo_face.h"
 #include "chirpy_tx.h"
 #include "filesystem.h"
+#include "lfs.h"
 
 typedef enum {
     CDM_CHOOSE = 0,
@@ -38,6 +39,7 @@ typedef enum {
     CDP_INFO_SHORT,
     CDP_INFO_LONG,
     CDP_INFO_NANOSEC,
+    CDP_FILE,
 } chirpy_demo_program_t;
 
 typedef struct {
@@ -47,6 +49,11 @@ typedef struct {
     // Selected program
     chirpy_demo_program_t program;
 
+    // For CDP_FILE: which file in the root directory, and its name. Sized for any name littlefs allows, since a
+    // truncated one couldn't be read back.
+    uint16_t file_index;
+    char file_name[LFS_NAME_MAX + 1];
+
     // Used by chirpy encoder during transmission
     chirpy_encoder_state_t encoder_state;
 
@@ -93,6 +100,17 @@ static uint8_t short_data[] = {
 static uint8_t *activity_buffer = 0;
 static uint16_t activity_buffer_size = 0;
 
+// Files are streamed from the filesystem through the two halves of this buffer: the encoder drains one half
+// from the buzzer's interrupt while the face refills the other one on its 1 Hz tick. At ~14 bytes per second,
+// each half lasts over four seconds.
+#define CDF_FILE_BUF_HALF_SIZE 64
+static uint8_t file_buf[2][CDF_FILE_BUF_HALF_SIZE];
+static volatile uint8_t file_buf_len[2];    // 0 while a half is waiting to be refilled
+static volatile uint8_t file_buf_half;
+static uint8_t file_buf_pos;
+static int32_t file_offset;
+static volatile bool file_eof;
+
 void chirpy_demo_face_setup(uint8_t watch_face_index, void **context_ptr) {
     (void)watch_face_index;
     if (*context_ptr == NULL) {
@@ -142,6 +160,10 @@ static void _cdf_update_lcd(chirpy_demo_state_t *state) {
         watch_display_text(WATCH_POSITION_BOTTOM, " LOng ");
     } else if (state->program == CDP_INFO_NANOSEC) {
         watch_display_text(WATCH_POSITION_BOTTOM, " ACtIV");
+    } else if (state->program == CDP_FILE) {
+        char buf[7];
+        snprintf(buf, 7, "%-6s", state->file_name);
+        watch_display_text(WATCH_POSITION_BOTTOM, buf);
     } else {
         watch_display_text(WATCH_POSITION_BOTTOM, "----  ");
     }
@@ -160,6 +182,36 @@ static uint8_t _cdf_get_next_byte(uint8_t *next_byte) {
     return 1;
 }
 
+static uint8_t _cdf_get_next_file_byte(uint8_t *next_byte) {
+    uint8_t len = file_buf_len[file_buf_half];
+    if (len == 0)
+        return 0;
+    *next_byte = file_buf[file_buf_half][file_buf_pos];
+    ++file_buf_pos;
+    if (file_buf_pos == len) {
+        // Hand this half back to the face for refilling, and move on to the other one
+        file_buf_len[file_buf_half] = 0;
+        file_buf_half ^= 1;
+        file_buf_pos = 0;
+    }
+    return 1;
+}
+
+static void _cdf_refill_file_buffer(chirpy_demo_state_t *state) {
+    for (uint8_t i = 0; i < 2 && !file_eof; ++i) {
+        // Halves are drained in turn, so the one after the half being drained is always the next to fill
+        uint8_t half = file_buf_half ^ i;
+        if (file_buf_len[half] != 0) continue;
+        int32_t len = filesystem_read_file_at(state->file_name, file_offset, (char *)file_buf[half], CDF_FILE_BUF_HALF_SIZE);
+        if (len <= 0) {
+            file_eof = true;
+        } else {
+            file_offset += len;
+            file_buf_len[half] = len;
+        }
+    }
+}
+
 static void _cdf_on_chirping_done(void) {
     if (curr_state) {
         curr_state->mode = CDM_CHOOSE;
@@ -182,16 +234,14 @@ static bool _cdm_raw_source_fn(uint16_t position, void* userdata, uint16_t* peri
 
     chirpy_demo_state_t *state = (chirpy_demo_state_t *)userdata;
 
-    uint8_t tone = chirpy_get_next_tone(&state->encoder_state);
-    // Transmission over?
-    if (tone == 255) {
-        return true;
+    // The face fell behind refilling the file buffer: wait for it rather than ending the transmission
+    if (state->program == CDP_FILE && file_buf_len[file_buf_half] == 0 && !file_eof) {
+        *period = WATCH_BUZZER_PERIOD_REST;
+        *duration = 1;
+        return false;
     }
 
-    *period = chirpy_get_tone_period(tone);
-    *duration = 3;
-
-    return false;
+    return chirpy_raw_source(position - 6, &state->encoder_state, period, duration);
 }
 
 static void _cdm_start_transmission(chirpy_demo_state_t *state) {
@@ -212,8 +262,19 @@ static void _cdm_start_transmission(chirpy_demo_state_t *state) {
         curr_data_len = activity_buffer_size;
     }
 
-    chirpy_init_encoder(&state->encoder_state, _cdf_get_next_byte);
-    watch_buzzer_play_raw_source(_cdm_raw_source_fn, state, _cdf_on_chirping_done);
+    if (state->program == CDP_FILE) {
+        // Any file can be big, so it goes out with the fast profile, straight from the filesystem
+        file_buf_len[0] = file_buf_len[1] = 0;
+        file_buf_half = 0;
+        file_buf_pos = 0;
+        file_offset = 0;
+        file_eof = false;
+        _cdf_refill_file_buffer(state);
+        chirpy_init_encoder_with_profile(&state->encoder_state, _cdf_get_next_file_byte, CHIRPY_PROFILE_FAST);
+    } else {
+        chirpy_init_encoder(&state->encoder_state, _cdf_get_next_byte);
+    }
+    watch_buzzer_play_raw_source_with_volume(_cdm_raw_source_fn, state, _cdf_on_chirping_done, WATCH_BUZZER_VOLUME_LOUD);
 }
 
 bool chirpy_demo_face_loop(movement_event_t event, void *context) {
@@ -223,6 +284,11 @@ bool chirpy_demo_face_loop(movement_event_t event, void *context) {
         case EVENT_ACTIVATE:
             _cdf_update_lcd(state);
             break;
+        case EVENT_TICK:
+            if (state->mode == CDM_CHIRPING && state->program == CDP_FILE) {
+                _cdf_refill_file_buffer(state);
+            }
+            break;
         case EVENT_LIGHT_BUTTON_DOWN:
         case EVENT_LIGHT_BUTTON_UP:
             // We don't do light.
@@ -238,9 +304,19 @@ bool chirpy_demo_face_loop(movement_event_t event, void *context) {
                     if (activity_buffer_size > 0)
                         state->program = CDP_INFO_NANOSEC;
                     else
-                        state->program = CDP_CLEAR;
+                        state->program = CDP_FILE;
                 } else if (state->program == CDP_INFO_NANOSEC)
-                    state->program = CDP_CLEAR;
+                    state->program = CDP_FILE;
+                else if (state->program == CDP_FILE)
+                    ++state->file_index;
+
+                // Walk through every file on the filesystem, then back to the start
+                if (state->program == CDP_FILE) {
+                    if (!filesystem_get_file_name(state->file_index, state->file_name, sizeof(state->file_name))) {
+                        state->file_index = 0;
+                        state->program = CDP_CLEAR;
+                    }
+                }
                 _cdf_update_lcd(state);
             }
             break;
@@ -44,6 +44,11 @@
  * LONG is a longer transmission that contains the first two strophes of a
  * famous sea shanty.
  * 
+ * After those come all the files on the watch, shown by name, so you can
+ * export activity or temperature logs. Files are sent with chirpy-tx's fast
+ * profile, which is about twice as fast as the others but needs a receiver
+ * that understands it.
+ * 
  * Select the transmission you want with ALARM, the press LONG ALARM to chirp.
  * 
  * To record and decode a chirpy transmission on your computer, you can use the web app here:
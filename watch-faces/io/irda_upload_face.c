@@ -22,6 +22,7 @@
  * SOFTWARE.
  */
 
+
 #include <stdlib.h>
 #include <string.h>
 #include "irda_upload_face.h"
@@ -33,6 +34,181 @@
 
 #ifdef HAS_IR_SENSOR
 
+#define IRDA_PACKET_SOF (0x7E)
+#define IRDA_PACKET_HEADER_SZ (6)   // type, seq, total, length
+#define IRDA_PACKET_MAX_PAYLOAD (64)
+
+// Bytes from the SERCOM RX interrupt. Must be a power of two. At 900 baud, this is almost three seconds of data.
+#define IRDA_RX_BUF_SZ (256)
+#define IRDA_RX_BUF_IDX(x) ((x) & (IRDA_RX_BUF_SZ - 1))
+static volatile uint8_t rx_buf[IRDA_RX_BUF_SZ];
+static volatile uint16_t rx_buf_head = 0;
+static volatile uint16_t rx_buf_tail = 0;
+
+// The packet currently being reassembled from the RX buffer.
+static uint8_t packet[IRDA_PACKET_HEADER_SZ + IRDA_PACKET_MAX_PAYLOAD + 2];
+static uint8_t packet_pos = 0;
+
+static uint16_t _irda_crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// keeps a result (success or failure) on screen for three seconds at our 4 Hz tick.
+static void _irda_show_result(irda_demo_state_t *state, bool success) {
+    if (success) movement_force_led_on(0, 48, 0);
+    else movement_force_led_on(48, 0, 0);
+    state->result_ticks = 12;
+}
+
+static void _irda_reset_transfer(irda_demo_state_t *state) {
+    if (state->in_progress) filesystem_stream_close();
+    state->in_progress = false;
+    state->total_packets = 0;
+    state->received_packets = 0;
+    state->missing_packets = 0;
+    memset(state->received, 0, sizeof(state->received));
+}
+
+static void _irda_handle_header(irda_demo_state_t *state, uint16_t total, uint8_t *payload, uint8_t length) {
+    if (length < 5 || length > 4 + 12) return;
+
+    uint32_t file_size = payload[0] | (payload[1] << 8) | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    char filename[13] = {0};
+    memcpy(filename, payload + 4, length - 4);
+
+    // the sender repeats the header on every pass; only the first one of a new file starts a new transfer.
+    bool complete = state->total_packets && state->received_packets == state->total_packets;
+    if (file_size == state->file_size && !strcmp(filename, state->filename) && (state->in_progress || complete || file_size == 0)) return;
+
+    _irda_reset_transfer(state);
+    strcpy(state->filename, filename);
+    state->file_size = file_size;
+
+    if (file_size == 0) {
+        // Success! All we need is a header to delete a file.
+        _irda_show_result(state, true);
+        filesystem_rm(filename);
+        watch_display_text_with_fallback(WATCH_POSITION_TOP, "FILE ", "FI");
+        watch_display_text_with_fallback(WATCH_POSITION_BOTTOM, "dELETE", " deLet");
+        return;
+    }
+
+    if (total > IRDA_UPLOAD_MAX_PACKETS || total != (file_size + IRDA_PACKET_MAX_PAYLOAD - 1) / IRDA_PACKET_MAX_PAYLOAD) {
+        _irda_show_result(state, false);
+        watch_display_text_with_fallback(WATCH_POSITION_TOP, "BAD  ", "BA");
+        watch_display_text(WATCH_POSITION_BOTTOM, "HEAdER");
+        return;
+    }
+
+    if (!filesystem_stream_open(filename)) return;
+    state->total_packets = total;
+    state->in_progress = true;
+}
+
+static void _irda_handle_data(irda_demo_state_t *state, uint16_t seq, uint8_t *payload, uint8_t length) {
+    if (!state->in_progress || seq >= state->total_packets) return;
+    if (state->received[seq / 8] & (1 << (seq % 8))) return;
+
+    if (!filesystem_stream_write(seq * IRDA_PACKET_MAX_PAYLOAD, (char *)payload, length)) {
+        // most likely out of space; give up on this file.
+        _irda_reset_transfer(state);
+        _irda_show_result(state, false);
+        watch_display_text_with_fallback(WATCH_POSITION_TOP, "FULL ", "FU");
+        watch_display_text_with_fallback(WATCH_POSITION_BOTTOM, "no SPC", "no SPC");
+        return;
+    }
+
+    state->received[seq / 8] |= 1 << (seq % 8);
+    state->received_packets++;
+
+    if (state->received_packets == state->total_packets) {
+        // Valid data! Close the file to commit it to the file system.
+        filesystem_stream_close();
+        state->in_progress = false;
+        watch_display_text_with_fallback(WATCH_POSITION_TOP, "RECVd", "RC");
+        _irda_show_result(state, true);
+
+        char buf[8];
+        sprintf(buf, "%4lub ", state->file_size);
+        watch_display_text(WATCH_POSITION_BOTTOM, buf);
+    }
+}
+
+// Pulls bytes out of the RX buffer, and handles any complete packets. Returns true if any packet was handled.
+static bool _irda_process_rx_buffer(irda_demo_state_t *state) {
+    bool handled = false;
+
+    while (rx_buf_tail != rx_buf_head) {
+        uint8_t byte = rx_buf[rx_buf_tail];
+        rx_buf_tail = IRDA_RX_BUF_IDX(rx_buf_tail + 1);
+
+        if (packet_pos == 0) {
+            // the start byte itself isn't stored; packet[0] is the type.
+            if (byte == IRDA_PACKET_SOF) packet_pos = 1;
+            continue;
+        }
+
+        packet[packet_pos - 1] = byte;
+        packet_pos++;
+
+        if (packet_pos - 1 < IRDA_PACKET_HEADER_SZ) continue;
+
+        uint8_t length = packet[5];
+        if (length > IRDA_PACKET_MAX_PAYLOAD) {
+            // can't be a real packet; look for the next start byte.
+            packet_pos = 0;
+            continue;
+        }
+        if (packet_pos - 1 < IRDA_PACKET_HEADER_SZ + length + 2) continue;
+
+        // we have a whole packet.
+        packet_pos = 0;
+        uint16_t crc = packet[IRDA_PACKET_HEADER_SZ + length] | (packet[IRDA_PACKET_HEADER_SZ + length + 1] << 8);
+        if (crc != _irda_crc16(packet, IRDA_PACKET_HEADER_SZ + length)) continue;
+
+        uint16_t seq = packet[1] | (packet[2] << 8);
+        uint16_t total = packet[3] | (packet[4] << 8);
+        uint8_t *payload = packet + IRDA_PACKET_HEADER_SZ;
+
+        switch (packet[0]) {
+            case 'H':
+                _irda_handle_header(state, total, payload, length);
+                break;
+            case 'D':
+                _irda_handle_data(state, seq, payload, length);
+                break;
+            case 'E':
+                // end of one pass; whatever we don't have yet should come around on the next one.
+                if (state->in_progress) state->missing_packets = state->total_packets - state->received_packets;
+                break;
+        }
+        handled = true;
+    }
+
+    return handled;
+}
+
+static void _irda_display_progress(irda_demo_state_t *state) {
+    char buf[8];
+
+    watch_display_text_with_fallback(WATCH_POSITION_TOP, "RX   ", "RX");
+    if (state->missing_packets && watch_rtc_get_date_time().unit.second % 2) {
+        snprintf(buf, 7, "%3d mi", state->missing_packets);
+    } else {
+        uint32_t received = state->received_packets * IRDA_PACKET_MAX_PAYLOAD;
+        if (received > state->file_size) received = state->file_size;
+        snprintf(buf, 7, "%5lub", received);
+    }
+    watch_display_text(WATCH_POSITION_BOTTOM, buf);
+}
+
 void irda_upload_face_setup(uint8_t watch_face_index, void ** context_ptr) {
     (void) watch_face_index;
     if (*context_ptr == NULL) {
@@ -44,7 +220,12 @@ void irda_upload_face_setup(uint8_t watch_face_index, void ** context_ptr) {
 
 void irda_upload_face_activate(void *context) {
     irda_demo_state_t *state = (irda_demo_state_t *)context;
-    (void) state;
+    _irda_reset_transfer(state);
+    state->result_ticks = 0;
+    state->filename[0] = 0;
+    rx_buf_head = rx_buf_tail = 0;
+    packet_pos = 0;
+
     HAL_GPIO_IR_ENABLE_out();
     HAL_GPIO_IR_ENABLE_clr();
     HAL_GPIO_IRSENSE_in();
@@ -52,80 +233,36 @@ void irda_upload_face_activate(void *context) {
     uart_init_instance(0, UART_TXPO_NONE, UART_RXPO_0, 900);
     uart_set_irda_mode_instance(0, true);
     uart_enable_instance(0);
+
+    // every received byte goes straight into rx_buf from our own interrupt handler below.
+    SERCOM0->USART.INTENSET.reg = SERCOM_USART_INTENSET_RXC | SERCOM_USART_INTENSET_ERROR;
+    NVIC_ClearPendingIRQ(SERCOM0_IRQn);
+    NVIC_EnableIRQ(SERCOM0_IRQn);
+
+    // redraw a few times a second, so progress looks smooth.
+    movement_request_tick_frequency(4);
 }
 
 bool irda_upload_face_loop(movement_event_t event, void *context) {
     irda_demo_state_t *state = (irda_demo_state_t *)context;
-    (void) state;
 
     switch (event.event_type) {
         case EVENT_NONE:
         case EVENT_ACTIVATE:
         case EVENT_TICK:
         {
-            // need more work here: we seem to top out at 64 bytes coming in, and even then it takes a lot of tries.
-            char data[256];
-            size_t bytes_read = uart_read_instance(0, data, 256);
-            watch_clear_display();
-            watch_set_indicator(WATCH_INDICATOR_ARROWS);
-            if (watch_rtc_get_date_time().unit.second % 4 < 2) watch_display_text_with_fallback(WATCH_POSITION_TOP, "IrDA", "IR");
-            else watch_display_text_with_fallback(WATCH_POSITION_TOP, "FREE ", "DF");
-
-            if (bytes_read) {
-                // data is in the following format, where S is Size, F is Filename and C is checksum:
-                // SSFFFFFFFFFFFFCC
-                // after that, we get SS bytes of data, followed by a two-byte checksum
-                uint16_t expected_size = ((uint16_t *)data)[0];
-                uint16_t expected_checksum = ((uint16_t *)data)[7];
-
-                uint16_t checksum = 0;
-
-                for (size_t i = 0; i < 14; i++) checksum += data[i];
-
-                if (checksum != expected_checksum) {
-                    // failed
-                    movement_force_led_on(48, 0, 0);
-                    watch_display_text_with_fallback(WATCH_POSITION_TOP, "BAD  ", "BA");
-                    watch_display_text(WATCH_POSITION_BOTTOM, "HEAdER");
-                    break;
-                }
-                // valid header! To make it easier on ourselves, we're going to make byte 14 zero...
-                data[14] = 0;
-                // so that now buf[2] points to our null-terminated filename.
-                char *filename = data + 2;
-
-                if (expected_size == 0) {
-                    // Success! All we need is a header to delete a file.
-                    movement_force_led_on(0, 48, 0);
-                    filesystem_rm(filename);
-                    watch_display_text_with_fallback(WATCH_POSITION_TOP, "FILE ", "FI");
-                    watch_display_text_with_fallback(WATCH_POSITION_TOP, "dELETE", " deLet");
-                    break;
-                }
-
-                // now let's check the data.
-                checksum = 0;
-                memcpy(&expected_checksum, data + 16 + expected_size, 2);
-                for (uint16_t i = 16; i < 16 + expected_size; i++) checksum += data[i];
-
-                if (checksum != expected_checksum) {
-                    // failed
-                    movement_force_led_on(48, 0, 0);
-                    watch_display_text_with_fallback(WATCH_POSITION_TOP, "BAD  ", "BA");
-                    watch_display_text_with_fallback(WATCH_POSITION_BOTTOM, "data  ", " data ");
-                    break;
-                }
-
-                // Valid data! Write it to the file system.
-                filesystem_write_file(filename, data + 16, expected_size);
-                watch_display_text_with_fallback(WATCH_POSITION_TOP, "RECVd", "RC");
-                movement_force_led_on(0, 48, 0);
-
-                char buf[8];
-                sprintf(buf, "%4db ", expected_size);
-                watch_display_text(WATCH_POSITION_BOTTOM, buf);
-            } else {
-                movement_force_led_off();
+            bool handled = _irda_process_rx_buffer(state);
+
+            if (state->in_progress) {
+                _irda_display_progress(state);
+            } else if (state->result_ticks) {
+                // leave the result on screen for a bit before going back to the idle display.
+                if (!handled && --state->result_ticks == 0) movement_force_led_off();
+            } else if (event.subsecond == 0) {
+                watch_clear_display();
+                watch_set_indicator(WATCH_INDICATOR_ARROWS);
+                if (watch_rtc_get_date_time().unit.second % 4 < 2) watch_display_text_with_fallback(WATCH_POSITION_TOP, "IrDA", "IR");
+                else watch_display_text_with_fallback(WATCH_POSITION_TOP, "FREE ", "DF");
                 char buf[7];
                 snprintf(buf, 7, "%4ld b", filesystem_get_free_space());
                 watch_display_text(WATCH_POSITION_BOTTOM, buf);
@@ -135,9 +272,17 @@ bool irda_upload_face_loop(movement_event_t event, void *context) {
         case EVENT_LIGHT_BUTTON_UP:
             break;
         case EVENT_ALARM_BUTTON_UP:
+            if (state->in_progress) {
+                // cancel: throw away the partial file.
+                _irda_reset_transfer(state);
+                filesystem_rm(state->filename);
+                _irda_show_result(state, false);
+                watch_display_text_with_fallback(WATCH_POSITION_TOP, "CAnCL", "CA");
+            }
             break;
         case EVENT_TIMEOUT:
-            movement_move_to_face(0);
+            // don't time out in the middle of a transfer.
+            if (!state->in_progress) movement_move_to_face(0);
             break;
         case EVENT_LOW_ENERGY_UPDATE:
             watch_display_text(WATCH_POSITION_TOP_RIGHT, " <");
@@ -150,7 +295,17 @@ bool irda_upload_face_loop(movement_event_t event, void *context) {
 }
 
 void irda_upload_face_resign(void *context) {
-    (void) context;
+    irda_demo_state_t *state = (irda_demo_state_t *)context;
+
+    // a transfer we leave behind can't be resumed; don't leave half a file lying around.
+    if (state->in_progress) {
+        _irda_reset_transfer(state);
+        filesystem_rm(state->filename);
+    }
+
+    if (state->result_ticks) movement_force_led_off();
+
+    NVIC_DisableIRQ(SERCOM0_IRQn);
     uart_disable_instance(0);
     HAL_GPIO_IRSENSE_pmuxdis();
     HAL_GPIO_IRSENSE_off();
@@ -159,6 +314,22 @@ void irda_upload_face_resign(void *context) {
 
 void irq_handler_sercom0(void);
 void irq_handler_sercom0(void) {
-    uart_irq_handler(0);
+    uint8_t flags = SERCOM0->USART.INTFLAG.reg;
+
+    if (flags & SERCOM_USART_INTFLAG_RXC) {
+        uint16_t status = SERCOM0->USART.STATUS.reg;
+        uint8_t byte = SERCOM0->USART.DATA.reg;
+        if (status & (SERCOM_USART_STATUS_FERR | SERCOM_USART_STATUS_PERR | SERCOM_USART_STATUS_BUFOVF)) {
+            // the byte is garbage; drop it and let the packet CRC sort it out.
+            SERCOM0->USART.STATUS.reg = status;
+        } else if (IRDA_RX_BUF_IDX(rx_buf_head + 1) != rx_buf_tail) {
+            rx_buf[rx_buf_head] = byte;
+            rx_buf_head = IRDA_RX_BUF_IDX(rx_buf_head + 1);
+        }
+    }
+
+    if (flags & SERCOM_USART_INTFLAG_ERROR) {
+        SERCOM0->USART.INTFLAG.reg = SERCOM_USART_INTFLAG_ERROR;
+    }
 }
 #endif // HAS_IR_SENSOR
@@ -29,15 +29,39 @@
 #ifdef HAS_IR_SENSOR
 
 /*
- * LIGHT SENSOR PLAYGROUND
+ * IrDA UPLOAD
  *
- * Temporary watch face for playing with the light sensor.
+ * Receives files over the IR sensor at 900 baud and writes them to the filesystem.
  *
+ * A file is sent as a series of packets. Each one looks like this, with multi-byte fields little-endian:
+ *   0x7E | type | seq (2 bytes) | total (2 bytes) | length | payload (length bytes) | CRC-16/CCITT (2 bytes)
+ * The CRC covers everything from type through the end of the payload.
+ *
+ *  - 'H' (header): payload is the file size (4 bytes) followed by the filename (up to 12 characters).
+ *    total is the number of data packets. A file size of 0 deletes the file.
+ *  - 'D' (data): payload is up to 64 bytes of the file, starting at offset seq * 64.
+ *  - 'E' (end of file): marks the end of one pass through the file.
+ *
+ * The watch can't talk back, so the sender should repeat the whole sequence (header, data, end of file)
+ * until the watch shows it's done. Each data packet is written to the file as soon as it arrives; on later
+ * passes, the watch only fills in whatever packets it missed or received with a bad CRC.
+ *
+ * While a file is coming in, the top shows RX and the bottom shows bytes received so far. After an end of
+ * file packet with packets still missing, the bottom shows how many are missing. Press ALARM to cancel.
  */
 
+// Largest file we can receive: 512 packets of 64 bytes each, or 32 KB.
+#define IRDA_UPLOAD_MAX_PACKETS (512)
+
 typedef struct {
-    // Anything you need to keep track of, put it here!
-    uint8_t unused;
+    char filename[13];
+    uint32_t file_size;
+    uint16_t total_packets;
+    uint16_t received_packets;
+    uint16_t missing_packets;   // as of the last end of file packet
+    uint8_t received[IRDA_UPLOAD_MAX_PACKETS / 8];
+    bool in_progress;
+    uint8_t result_ticks;   // how long to keep a result on screen before going back to the idle display
 } irda_demo_state_t;
 
 void irda_upload_face_setup(uint8_t watch_face_index, void ** context_ptr);
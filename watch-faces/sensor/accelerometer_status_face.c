@@ -39,7 +39,7 @@ static void _accelerometer_status_face_update_display(accel_interrupt_count_stat
     watch_set_indicator(WATCH_INDICATOR_SIGNAL);
 
     // Sleep/active state
-    if (HAL_GPIO_A4_read()) watch_display_text(WATCH_POSITION_BOTTOM, "Still ");
+    if (!movement_get_accelerometer_activity().is_active) watch_display_text(WATCH_POSITION_BOTTOM, "Still ");
     else watch_display_text_with_fallback(WATCH_POSITION_BOTTOM, "Active", " ACtiv");
 }
 
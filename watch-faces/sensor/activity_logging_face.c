@@ -68,14 +68,27 @@ static void _activity_logging_face_update_display(activity_logging_state_t *stat
     }
 }
 
+static void _activity_logging_face_accelerometer_batch(const lis2dw_reading_t *readings, uint8_t count, rtc_counter_t counter, bool overrun, void *context) {
+    (void) counter;
+    (void) overrun;
+    activity_logging_state_t *state = (activity_logging_state_t *)context;
+    motion_engine_process(&state->motion_engine, readings, count);
+}
+
 void activity_logging_face_setup(uint8_t watch_face_index, void ** context_ptr) {
     (void) watch_face_index;
     if (*context_ptr == NULL) {
         *context_ptr = malloc(sizeof(activity_logging_state_t));
         memset(*context_ptr, 0, sizeof(activity_logging_state_t));
+        activity_logging_state_t *state = (activity_logging_state_t *)*context_ptr;
+        motion_engine_init(&state->motion_engine, LIS2DW_DATA_RATE_12_5_HZ);
         // At first run, tell Movement to run the accelerometer in the background. It will now run at this rate forever.
         movement_set_accelerometer_background_rate(LIS2DW_DATA_RATE_LOWEST);
     }
+
+    // setup runs again every time we wake from low energy mode; subscribing again is harmless.
+    activity_logging_state_t *state = (activity_logging_state_t *)*context_ptr;
+    state->counting_steps = movement_accelerometer_subscribe(LIS2DW_DATA_RATE_12_5_HZ, _activity_logging_face_accelerometer_batch, state);
 }
 
 void activity_logging_face_activate(void *context) {
@@ -113,8 +126,10 @@ bool activity_logging_face_loop(movement_event_t event, void *context) {
             {
                 size_t pos = state->data_points % ACTIVITY_LOGGING_NUM_DAYS;
                 state->activity_log[pos] = state->active_minutes_today;
+                state->step_log[pos] = state->steps_today;
                 state->data_points++;
                 state->active_minutes_today = 0;
+                state->steps_today = 0;
             }
             break;
         case EVENT_LOW_ENERGY_UPDATE:
@@ -144,7 +159,20 @@ movement_watch_face_advisory_t activity_logging_face_advise(void *context) {
     activity_logging_state_t *state = (activity_logging_state_t *)context;
     movement_watch_face_advisory_t retval = { 0 };
 
-    if (!HAL_GPIO_A4_read()) {
+    bool active;
+    if (state->counting_steps) {
+        // the motion engine knows better than the accelerometer's sleep state, which we turn off while we sample anyway.
+        motion_minute_t minute = motion_engine_end_minute(&state->motion_engine);
+        active = minute.activity != MOTION_ACTIVITY_STILL;
+        state->steps_today = (state->steps_today + minute.steps > UINT16_MAX) ? UINT16_MAX : state->steps_today + minute.steps;
+    } else {
+        // otherwise, the wearer was active if they were moving at any point this minute.
+        movement_accelerometer_activity_t activity = movement_get_accelerometer_activity();
+        active = activity.is_active || activity.activity_count != state->last_activity_count;
+        state->last_activity_count = activity.activity_count;
+    }
+
+    if (active) {
         // only count this as an active minute if the previous minute was also active.
         // otherwise, set the flag and we'll count the next minute if the wearer is still active.
         if (state->previous_minute_was_active) state->active_minutes_today++;
@@ -43,10 +43,16 @@
  * A short press of the Light button moves forward in the data log, looping around if we're on the most-recent day.
  * Holding the Light button will illuminate the display.
  *
+ * The face samples the accelerometer at 12.5 Hz through Movement's accelerometer service and runs the samples
+ * through the motion engine, which counts steps and tells a still minute from an active one. Like everything
+ * else that uses the accelerometer, it only counts while the watch is awake; low energy mode pauses it.
+ * Daily step counts go into step_log next to the active minutes; the face itself still only shows active minutes.
+ *
  */
 
 #include "movement.h"
 #include "watch.h"
+#include "motion_engine.h"
 
 #define ACTIVITY_LOGGING_NUM_DAYS (14)
 
@@ -56,6 +62,11 @@ typedef struct {
     uint8_t display_index;                              // the index we are displaying on screen
     uint16_t active_minutes_today;                      // the number of active minutes logged today
     bool previous_minute_was_active;                    // we only want to count two or more consecutive active minutes
+    uint16_t step_log[ACTIVITY_LOGGING_NUM_DAYS];       // steps for each day in the log
+    uint16_t steps_today;                               // the number of steps counted today
+    bool counting_steps;                                // the accelerometer service is feeding the motion engine
+    uint32_t last_activity_count;                       // Movement's activity count as of the last minute
+    motion_engine_t motion_engine;
 } activity_logging_state_t;
 
 void activity_logging_face_setup(uint8_t watch_face_index, void ** context_ptr);
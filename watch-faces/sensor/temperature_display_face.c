@@ -29,8 +29,7 @@
 
 static bool skip = false;
 
-static void _temperature_display_face_update_display(bool in_fahrenheit) {
-    float temperature_c = movement_get_temperature();
+static void _temperature_display_face_update_display(float temperature_c, bool in_fahrenheit) {
     if (in_fahrenheit) {
         watch_display_float_with_best_effort(temperature_c * 1.8 + 32.0, "#F");
     } else {
@@ -41,8 +40,8 @@ static void _temperature_display_face_update_display(bool in_fahrenheit) {
 void temperature_display_face_setup(uint8_t watch_face_index, void ** context_ptr) {
     (void) watch_face_index;
     (void) context_ptr;
-    // if temperature is invalid, we don't have a temperature sensor which means we shouldn't be here.
-    if (movement_get_temperature() == 0xFFFFFFFF) skip = true;
+    // without a temperature sensor, we shouldn't be here.
+    if (!movement_sensor_is_available(MOVEMENT_SENSOR_TEMPERATURE)) skip = true;
 }
 
 void temperature_display_face_activate(void *context) {
@@ -55,7 +54,7 @@ bool temperature_display_face_loop(movement_event_t event, void *context) {
     switch (event.event_type) {
         case EVENT_ALARM_LONG_PRESS:
             movement_set_use_imperial_units(!movement_use_imperial_units());
-            _temperature_display_face_update_display(movement_use_imperial_units());
+            _temperature_display_face_update_display(movement_get_temperature(), movement_use_imperial_units());
             break;
         case EVENT_ACTIVATE:
             if (skip) {
@@ -74,7 +73,8 @@ bool temperature_display_face_loop(movement_event_t event, void *context) {
                 // In reality the measurement takes a fraction of a second, but this is just to show something is happening.
                 watch_set_indicator(WATCH_INDICATOR_SIGNAL);
             } else if (date_time.unit.second % 5 == 0) {
-                _temperature_display_face_update_display(movement_use_imperial_units());
+                // while we're on screen, ask for a live reading rather than waiting on Movement's schedule.
+                _temperature_display_face_update_display(movement_get_recent_temperature(4), movement_use_imperial_units());
                 watch_clear_indicator(WATCH_INDICATOR_SIGNAL);
             }
             break;
@@ -86,7 +86,7 @@ bool temperature_display_face_loop(movement_event_t event, void *context) {
             // update every 5 minutes
             if (date_time.unit.minute % 5 == 0) {
                 watch_clear_indicator(WATCH_INDICATOR_SIGNAL);
-                _temperature_display_face_update_display(movement_use_imperial_units());
+                _temperature_display_face_update_display(movement_get_temperature(), movement_use_imperial_units());
             }
             break;
         default:
@@ -84,8 +84,8 @@ static void _temperature_logging_face_update_display(temperature_logging_state_t
 void temperature_logging_face_setup(uint8_t watch_face_index, void ** context_ptr) {
     (void) watch_face_index;
 
-    // if temperature is invalid, we don't have a temperature sensor which means we shouldn't be here.
-    if (movement_get_temperature() == 0xFFFFFFFF) skip = true;
+    // without a temperature sensor, we shouldn't be here.
+    if (!movement_sensor_is_available(MOVEMENT_SENSOR_TEMPERATURE)) skip = true;
 
     if (*context_ptr == NULL) {
         *context_ptr = malloc(sizeof(temperature_logging_state_t));
@@ -28,7 +28,7 @@
 #include "watch.h"
 
 static void _voltage_face_update_display(void) {
-    float voltage = (float)watch_get_vcc_voltage() / 1000.0;
+    float voltage = (float)movement_get_battery_voltage() / 1000.0;
 
     watch_display_text_with_fallback(WATCH_POSITION_TOP_LEFT, "BAT", "BA");
     watch_display_float_with_best_effort(voltage, " V");
@@ -52,12 +52,10 @@ bool voltage_face_loop(movement_event_t event, void *context) {
             _voltage_face_update_display();
             break;
         case EVENT_TICK:
+            // Movement takes the readings on its own schedule; we just show the latest one.
             date_time = movement_get_local_date_time();
-            if (date_time.unit.second % 5 == 4) {
-                watch_set_indicator(WATCH_INDICATOR_SIGNAL);
-            } else if (date_time.unit.second % 5 == 0) {
+            if (date_time.unit.second == 0) {
                 _voltage_face_update_display();
-                watch_clear_indicator(WATCH_INDICATOR_SIGNAL);
             }
             break;
         case EVENT_LOW_ENERGY_UPDATE:
@@ -67,8 +65,8 @@ bool voltage_face_loop(movement_event_t event, void *context) {
                 watch_start_sleep_animation(1000);
             }
             // update once an hour
+            date_time = movement_get_local_date_time();
             if (date_time.unit.minute == 0) {
-                watch_clear_indicator(WATCH_INDICATOR_SIGNAL);
                 _voltage_face_update_display();
                 watch_display_text_with_fallback(WATCH_POSITION_SECONDS, " V", "  ");
             }
@@ -44,6 +44,7 @@ void finetune_face_activate(void *context) {
     (void) context;
 
     // Handle any tasks related to your watch face coming on screen.
+    nanosec_load();
     watch_display_text(WATCH_POSITION_TOP_LEFT, "FT");
     total_adjustment = 0;
     finetune_page = 0;
@@ -28,18 +28,12 @@
 #include "nanosec_face.h"
 #include "filesystem.h"
 
-int16_t freq_correction_residual = 0; // Dithering 0.1ppm correction, does not need to be configured.
-int16_t freq_correction_previous = -30000;
-#define dithering 31
-
 nanosec_state_t nanosec_state;
 
-#define nanosec_max_screen 7
+#define nanosec_max_screen 6
 int8_t nanosec_screen = 0;
 bool nanosec_changed = false; // We try to avoid saving settings when no changes were made, for example when just browsing through face
 
-const float voltage_coefficient = 0.241666667 * dithering; // 10 * ppm/V. Nominal frequency is at 3V.
-
 static void nanosec_init_profile(void) {
     nanosec_changed = true;
     nanosec_state.correction_cadence = 10;
@@ -47,7 +41,7 @@ static void nanosec_init_profile(void) {
 
     // init data after changing profile - do that once per profile selection
     switch (nanosec_state.correction_profile) {
-        case 0: // No tempco, no dithering
+        case 0: // No tempco (Movement dithers the static offset either way, so this is the same as 1 now)
             nanosec_state.freq_correction = 0;
             nanosec_state.center_temperature = 2500;
             nanosec_state.quadratic_tempco = 0;
@@ -85,45 +79,30 @@ static void nanosec_init_profile(void) {
     }
 }
 
-static void nanosec_internal_write_RTC_correction(int16_t value, int16_t sign) {
-    if (sign == 0) {
-        if (value == freq_correction_previous)
-            return; // Do not write same correction value twice
-        freq_correction_previous = value;
-    } else {
-        if (value == -freq_correction_previous)
-            return; // Do not write same correction value twice
-        freq_correction_previous = -value;
-    }
-
-    watch_rtc_freqcorr_write(value, sign);
+// Hands our settings to Movement's crystal compensation service, which does the actual correcting.
+static void nanosec_apply_profile(void) {
+    movement_tempco_profile_t profile = movement_get_tempco_profile();
+
+    profile.offset = nanosec_state.freq_correction;
+    profile.center_temperature = nanosec_state.center_temperature;
+    profile.quadratic_tempco = nanosec_state.quadratic_tempco;
+    profile.cubic_tempco = nanosec_state.cubic_tempco;
+    profile.aging = nanosec_state.aging_ppm_pa;
+    profile.calibration_time = nanosec_state.last_correction_time;
+    movement_set_tempco_profile(profile);
 }
 
-// Receives clock correction, already corrected for temperature and battery voltage, multiplied by "dithering"
-static void apply_RTC_correction(int16_t correction) {
-    correction += freq_correction_residual;
-    int32_t correction_lr = (int32_t)correction * 2 / dithering; // int division
-    if (correction_lr & 1) {
-        if (correction_lr > 0) {
-            correction_lr++;
-        } else {
-            correction_lr--;
-        }
-    }
-    correction_lr >>= 1;
-    freq_correction_residual = correction - correction_lr * dithering;
-
-    // Warning! Freqcorr is not signed int8!!
-    // First we clamp it to 8-bit range
-    if (correction_lr > 127) {
-        nanosec_internal_write_RTC_correction(127, 0);
-    } else if (correction_lr < -127) {
-        nanosec_internal_write_RTC_correction(127, 1);
-    } else if (correction_lr < 0) {
-        nanosec_internal_write_RTC_correction(abs(correction_lr), 1);
-    } else { // correction
-        nanosec_internal_write_RTC_correction(correction_lr, 0);
-    }
+// Reads the profile back from Movement; tempco.dat is the one copy that counts, since the tempco shell command
+// edits it too. nanosec.ini only keeps the profile selection.
+void nanosec_load(void) {
+    movement_tempco_profile_t profile = movement_get_tempco_profile();
+
+    nanosec_state.freq_correction = profile.offset;
+    nanosec_state.center_temperature = profile.center_temperature;
+    nanosec_state.quadratic_tempco = profile.quadratic_tempco;
+    nanosec_state.cubic_tempco = profile.cubic_tempco;
+    nanosec_state.aging_ppm_pa = profile.aging;
+    nanosec_state.last_correction_time = profile.calibration_time;
 }
 
 // User-related saves
@@ -134,10 +113,7 @@ void nanosec_ui_save(void) {
 
 // This is low-level save function, that can be used by other faces
 void nanosec_save(void) {
-    if (nanosec_state.correction_profile == 0) {
-        freq_correction_residual = 0;
-        apply_RTC_correction(nanosec_state.freq_correction * 1.0f * dithering / 100); // Will be divided by dithering inside, final resolution is mere 1ppm
-    }
+    nanosec_apply_profile();
 
     filesystem_write_file("nanosec.ini", (char*)&nanosec_state, sizeof(nanosec_state));
     nanosec_changed = false;
@@ -148,15 +124,20 @@ void nanosec_face_setup(uint8_t watch_face_index, void ** context_ptr) {
 
     if (*context_ptr == NULL) {
         if (filesystem_get_file_size("nanosec.ini") != sizeof(nanosec_state)) {
-            // No previous ini or old version of ini file - create new config file
+            // No previous ini or old version of ini file - create new config file from Movement's profile
             nanosec_state.correction_profile = 3;
-            nanosec_init_profile();
-            nanosec_ui_save();
+            nanosec_state.correction_cadence = 10;
+            nanosec_load();
+            filesystem_write_file("nanosec.ini", (char*)&nanosec_state, sizeof(nanosec_state));
+        } else if (!movement_has_stored_tempco_profile()) {
+            // This watch was calibrated before Movement took over the correction; hand the profile over, once.
+            filesystem_read_file("nanosec.ini", (char*)&nanosec_state, sizeof(nanosec_state));
+            nanosec_apply_profile();
         } else {
             filesystem_read_file("nanosec.ini", (char*)&nanosec_state, sizeof(nanosec_state));
+            nanosec_load();
         }
 
-        freq_correction_residual = 0;
         nanosec_screen = 0;
 
         *context_ptr = (void *)1; // No need to re-read from filesystem when exiting low power mode
@@ -167,6 +148,8 @@ void nanosec_face_activate(void *context) {
     (void) context;
 
     // Handle any tasks related to your watch face coming on screen.
+    // the profile may have been changed from the shell since we last looked.
+    nanosec_load();
     nanosec_changed = false;
 }
 
@@ -194,11 +177,7 @@ static void nanosec_update_display() {
             watch_display_text_with_fallback(WATCH_POSITION_TOP, "PROFL", "PR");
             sprintf(buf, "    P%1d", nanosec_state.correction_profile);
             break;
-        case 5: // Cadence
-            watch_display_text_with_fallback(WATCH_POSITION_TOP, "Cadnc", "CD");
-            sprintf(buf, "    %2d", nanosec_state.correction_cadence);
-            break;
-        case 6: // Aging
+        case 5: // Aging
             watch_display_text_with_fallback(WATCH_POSITION_TOP, "AgeCo", "CD");
             sprintf(buf, "%6d", nanosec_state.aging_ppm_pa);
             break;
@@ -229,26 +208,7 @@ static void value_increase(int16_t delta) {
                 nanosec_state.correction_profile += nanosec_profile_count;
             }
             break;
-        case 5: // Cadence
-            switch (nanosec_state.correction_cadence) {
-                case 1:
-                    nanosec_state.correction_cadence = (delta > 0) ? 5 : 60;
-                    break;
-                case 5:
-                    nanosec_state.correction_cadence = (delta > 0) ? 10 : 1;
-                    break;
-                case 10:
-                    nanosec_state.correction_cadence = (delta > 0) ? 20 : 5;
-                    break;
-                case 20:
-                    nanosec_state.correction_cadence = (delta > 0) ? 60 : 10;
-                    break;
-                case 60:
-                    nanosec_state.correction_cadence = (delta > 0) ? 1 : 20;
-                    break;
-            }
-            break;
-        case 6: // Aging
+        case 5: // Aging
             nanosec_state.aging_ppm_pa += delta;
             break;
     }
@@ -324,31 +284,6 @@ bool nanosec_face_loop(movement_event_t event, void *context) {
             // You should also consider starting the tick animation, to show the wearer that this is sleep mode:
             // watch_start_sleep_animation(500);
             break;
-        case EVENT_BACKGROUND_TASK:
-        {
-            // Here we measure temperature and do main frequency correction
-            float temperature_c = movement_get_temperature();
-            float voltage = (float)watch_get_vcc_voltage() / 1000.0;
-
-            // If temperature is 0xFFFFFFFF, no temperature sensor is installed.
-            // Should we assume nominal temperature here? Seems better than aborting.
-            if (temperature_c == 0xFFFFFFFF) temperature_c = nanosec_state.center_temperature;
-            // L22 correction scaling is 0.95367ppm per 1 in FREQCORR
-            // At wrong temperature crystall starting to run slow, negative correction will speed up frequency to correct
-            // Default 32kHz correciton factor is -0.034, centered around 25°C
-            float dt = temperature_c - nanosec_state.center_temperature / 100.0;
-
-            int16_t correction = round((
-                        nanosec_state.freq_correction / 100.0f * dithering +
-                        (-nanosec_state.quadratic_tempco / 100000.0 * dithering) * dt * dt +
-                        (nanosec_state.cubic_tempco / 10000000.0 * dithering) * dt * dt * dt +
-                        (voltage - 3.0) * voltage_coefficient +
-                        nanosec_get_aging() * dithering
-                        ) / 0.95367); // 1 correction unit is 0.095367ppm.
-
-            apply_RTC_correction(correction);
-        }
-            break;
         case EVENT_LIGHT_BUTTON_DOWN:
             // don't light up every time light is hit
             break;
@@ -367,17 +302,3 @@ void nanosec_face_resign(void *context) {
 
     nanosec_ui_save();
 }
-
-// Background freq correction
-movement_watch_face_advisory_t nanosec_face_advise(void *context) {
-    (void) context;
-    movement_watch_face_advisory_t retval = { 0 };
-
-    // No need for background correction if we are on profile 0 - static hardware correction.
-    if (nanosec_state.correction_profile != 0) {
-        watch_date_time_t date_time = movement_get_utc_date_time();
-        retval.wants_background_task = date_time.unit.minute % nanosec_state.correction_cadence == 0;
-    }
-
-    return retval;
-}
@@ -34,16 +34,18 @@
  *
  * Best used in conjunction with the FINETUNE face.
  *
- * It implements temperature correction using tempco from datasheet (and
- * allows to adjust these) and allows to introduce offset fix. Therefore
- * requires temperature sensor board.
+ * It edits the profile for Movement's crystal compensation service (see
+ * movement_set_tempco_profile), which does the temperature correction
+ * using tempco from datasheet (and allows to adjust these) and allows to
+ * introduce offset fix. Therefore requires temperature sensor board. The
+ * correction runs whether or not this face is installed.
  *
  * Most users will need to apply profile 3 ("default") or 2 ("conservative
  * datasheet"), and tune first parameter "static offset" (as it's different
  * for every crystal sample).
  *
- * Frequency correction is dithered over 31 correction intervals (31x10
- * minutes or ~5 hours), to allow <0.1ppm correction resolution.
+ * Frequency correction is dithered minute by minute, to allow <0.1ppm
+ * correction resolution.
  *  * 1ppm is 0.0864 sec per day.
  *  * 0.1ppm is 0.00864 sec per day.
  *
@@ -55,9 +57,9 @@
  * Default funing fork tempco: -0.034 ppm/°C², centered around 25°C
  * We add optional cubic coefficient, which was measured in practice on my sample.
  *
- * Cadence (CD) - how many minutes between corrections. Default 10 minutes.
- * Every minute might be too much. Every hour - slightly less power
- * consumption but also less precision.
+ * Movement corrects at the top of every minute from its cached temperature,
+ * which it samples less often while the temperature holds steady, so there
+ * is no cadence to set anymore.
  *
  * Can compensate crystal aging (ppm/year) - but you really should be worrying
  * about it on second/third years of watch calibration.
@@ -81,7 +83,7 @@ typedef struct {
     int16_t center_temperature; // Multiplied by 100, +25.0 -> +2500
     int16_t quadratic_tempco; // 0.034 -> 3400, multiplied by 100000. Stored positive, used as negative.
     int16_t cubic_tempco; // default 0, 0.000136 -> 1360, multiplied by 10000000. Stored positive, used positive.
-    int8_t correction_cadence;
+    int8_t correction_cadence; // No longer used; kept so that existing nanosec.ini files still load.
     uint32_t last_correction_time; // Not used at the moment - but will in the future
     int16_t aging_ppm_pa; // multiplied by 100. Aging per year. 
 } nanosec_state_t;
@@ -90,8 +92,8 @@ void nanosec_face_setup(uint8_t watch_face_index, void ** context_ptr);
 void nanosec_face_activate(void *context);
 bool nanosec_face_loop(movement_event_t event, void *context);
 void nanosec_face_resign(void *context);
-movement_watch_face_advisory_t nanosec_face_advise(void *context);
 void nanosec_ui_save(void);
+void nanosec_load(void);
 void nanosec_save(void);
 float nanosec_get_aging(void);
 
@@ -101,7 +103,7 @@ float nanosec_get_aging(void);
     nanosec_face_activate, \
     nanosec_face_loop, \
     nanosec_face_resign, \
-    nanosec_face_advise, \
+    NULL, \
 })
 
 #endif // NANOSEC_FACE_H_
@@ -23,9 +23,14 @@
  */
 
 #include "watch_adc.h"
+#include "watch_private.h"
 #include "adc.h"
 
+// how many callers have the ADC enabled. It only turns off when the last of them is done with it.
+static uint8_t _adc_users = 0;
+
 void watch_enable_adc(void) {
+    if (_adc_users++) return;
     adc_init();
     adc_enable();
 }
@@ -49,6 +54,20 @@ uint16_t watch_get_analog_pin_level(const uint16_t pin) {
     return adc_get_analog_value(pin);
 }
 
+void watch_set_analog_num_samples(uint16_t samples) {
+    // ignore any input that's not a power of 2 (i.e. only one bit set)
+    if (__builtin_popcount(samples) != 1 || samples > 1024) return;
+    // if only one bit is set, this will be the log2 of the input
+    ADC->AVGCTRL.bit.SAMPLENUM = __builtin_ctz(samples);
+    while (ADC->SYNCBUSY.reg);
+}
+
+void watch_set_analog_sampling_length(uint8_t cycles) {
+    if (cycles < 1 || cycles > 64) return;
+    ADC->SAMPCTRL.bit.SAMPLEN = cycles - 1;
+    while (ADC->SYNCBUSY.reg);
+}
+
 /// TODO: put reference voltage stuff into gossamer?
 void _watch_set_analog_reference_voltage(uint8_t reference);
 void _watch_set_analog_reference_voltage(uint8_t reference) {
@@ -67,11 +86,8 @@ void _watch_set_analog_reference_voltage(uint8_t reference) {
 uint16_t watch_get_vcc_voltage(void) {
     // stash the previous reference so we can restore it when we're done.
     uint8_t oldref = ADC->REFCTRL.bit.REFSEL;
-    // same with the previous state of the ADC
-    bool adc_was_disabled = !adc_is_enabled();
-
-    // enable the ADC if needed
-    if (adc_was_disabled) watch_enable_adc();
+    // if nobody else has the ADC enabled, this turns it on for the length of the measurement.
+    watch_enable_adc();
 
     // if we weren't already using the internal reference voltage, select it now.
     if (oldref != ADC_REFCTRL_REFSEL_INTREF_Val) _watch_set_analog_reference_voltage(ADC_REFCTRL_REFSEL_INTREF_Val);
@@ -82,10 +98,14 @@ uint16_t watch_get_vcc_voltage(void) {
     // restore the old reference, if needed.
     if (oldref != ADC_REFCTRL_REFSEL_INTREF_Val) _watch_set_analog_reference_voltage(oldref);
 
-    // and restore the ADC to its previous state
-    if (adc_was_disabled) watch_disable_adc();
+    // and let go of the ADC.
+    watch_disable_adc();
+
+    // past 16 samples, the ADC scales the result back down to 16 bits on its own.
+    uint8_t samplenum = ADC->AVGCTRL.bit.SAMPLENUM;
+    if (samplenum > ADC_AVGCTRL_SAMPLENUM_16_Val) samplenum = ADC_AVGCTRL_SAMPLENUM_16_Val;
 
-    return (uint16_t)((raw_val * 1000) / (1024 * 1 << ADC->AVGCTRL.bit.SAMPLENUM));
+    return (uint16_t)((raw_val * 1000) / (1024 * 1 << samplenum));
 }
 
 inline void watch_disable_analog_input(const uint16_t port_pin) {
@@ -97,6 +117,12 @@ inline void watch_disable_analog_input(const uint16_t port_pin) {
     PORT->Group[port].PINCFG[pin].reg &= ~PORT_PINCFG_PMUXEN;	\
 }
 
-inline void watch_disable_adc(void) {
+void watch_disable_adc(void) {
+    if (_adc_users == 0 || --_adc_users) return;
+    adc_disable();
+}
+
+void _watch_adc_power_off(void) {
+    _adc_users = 0;
     adc_disable();
 }
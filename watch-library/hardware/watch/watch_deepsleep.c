@@ -153,7 +153,7 @@ static void _watch_disable_all_pins_except_rtc(void) {
 static void _watch_disable_all_peripherals_except_slcd(void) {
     watch_disable_leds();
     watch_disable_buzzer();
-    watch_disable_adc();
+    _watch_adc_power_off();
     watch_disable_external_interrupts();
 
     /// TODO: Actually disable all these peripherals? Disabling I2C seems to have no impact fwiw.
@@ -27,23 +27,306 @@
 
 #ifdef I2C_SERCOM
 
+#ifdef WATCH_I2C_INTERRUPTS
+
+// With WATCH_I2C_INTERRUPTS (I2C_INTERRUPTS=1 in the Makefile), transactions run from the SERCOM interrupt, one after
+// another, in the order they were submitted. The CPU only gets involved once per byte (and that's just a few register
+// accesses), so it can sleep while the bus works. Smart mode has the SERCOM acknowledge each byte we read as soon as
+// we take it out of DATA. This hasn't been run on enough hardware to be the default yet; without the flag, submitting
+// a transaction runs it to completion on the spot with gossamer's blocking driver.
+
+#define _WATCH_I2C_IRQ_HANDLER_(n) irq_handler_sercom##n
+#define _WATCH_I2C_IRQ_HANDLER(n) _WATCH_I2C_IRQ_HANDLER_(n)
+#define WATCH_I2C_IRQ_HANDLER _WATCH_I2C_IRQ_HANDLER(I2C_SERCOM)
+#define WATCH_I2C_IRQn ((IRQn_Type)(SERCOM0_IRQn + I2C_SERCOM))
+
+static SercomI2cm *_watch_i2c_sercom(void) {
+    static Sercom * const instances[] = SERCOM_INSTS;
+    return &instances[I2C_SERCOM]->I2CM;
+}
+
+static watch_i2c_transaction_t * volatile _queue_head = NULL;
+static watch_i2c_transaction_t * volatile _queue_tail = NULL;
+static bool _i2c_enabled = false;
+
+// progress through the transaction at the head of the queue.
+static uint16_t _bytes_written;
+static uint16_t _bytes_read;
+
+static inline void _watch_i2c_sync(SercomI2cm *i2cm) {
+    while (i2cm->SYNCBUSY.bit.SYSOP);
+}
+
+static void _watch_i2c_start(watch_i2c_transaction_t *transaction) {
+    SercomI2cm *i2cm = _watch_i2c_sercom();
+    _bytes_written = 0;
+    _bytes_read = 0;
+    i2cm->CTRLB.reg &= ~SERCOM_I2CM_CTRLB_ACKACT;
+    _watch_i2c_sync(i2cm);
+    // writing ADDR sends a start condition (or a repeated start, if we already own the bus) and the address.
+    i2cm->ADDR.reg = (transaction->addr << 1) | (transaction->write_length ? 0 : 1);
+}
+
+// Finishes the transaction at the head of the queue, and starts the next one. Runs with the SERCOM interrupt
+// masked or from inside it.
+static void _watch_i2c_finish(int8_t result) {
+    watch_i2c_transaction_t *transaction = _queue_head;
+    _queue_head = transaction->next;
+    if (_queue_head == NULL) _queue_tail = NULL;
+
+    // start the next one before the callback, so a callback that waits on something queued behind us gets it.
+    if (_queue_head != NULL) _watch_i2c_start(_queue_head);
+
+    transaction->result = result;
+    if (transaction->callback != NULL) transaction->callback(transaction);
+}
+
+static void _watch_i2c_stop(SercomI2cm *i2cm) {
+    _watch_i2c_sync(i2cm);
+    i2cm->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+}
+
+void WATCH_I2C_IRQ_HANDLER(void);
+void WATCH_I2C_IRQ_HANDLER(void) {
+    SercomI2cm *i2cm = _watch_i2c_sercom();
+    watch_i2c_transaction_t *transaction = _queue_head;
+    uint8_t flags = i2cm->INTFLAG.reg;
+
+    if (transaction == NULL) {
+        i2cm->INTFLAG.reg = flags;
+        return;
+    }
+
+    if ((flags & SERCOM_I2CM_INTFLAG_ERROR) || (i2cm->STATUS.reg & (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST))) {
+        // the bus is in a bad way; whatever we were doing is over. Writing the status bits back clears them.
+        i2cm->STATUS.reg = SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST;
+        i2cm->INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR | SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB;
+        _watch_i2c_stop(i2cm);
+        _watch_i2c_finish(WATCH_I2C_RESULT_ERR_BUS);
+        return;
+    }
+
+    if (flags & SERCOM_I2CM_INTFLAG_MB) {
+        // we're writing: the address or the last byte went out.
+        if (i2cm->STATUS.bit.RXNACK) {
+            _watch_i2c_stop(i2cm);
+            _watch_i2c_finish(WATCH_I2C_RESULT_ERR_NACK);
+        } else if (_bytes_written < transaction->write_length) {
+            i2cm->DATA.reg = transaction->write_buf[_bytes_written++];
+        } else if (transaction->read_length) {
+            // turn the bus around with a repeated start, so nobody can get a word in between the write and the read.
+            _watch_i2c_sync(i2cm);
+            i2cm->ADDR.reg = (transaction->addr << 1) | 1;
+        } else {
+            _watch_i2c_stop(i2cm);
+            _watch_i2c_finish(WATCH_I2C_RESULT_SUCCESS);
+        }
+    } else if (flags & SERCOM_I2CM_INTFLAG_SB) {
+        // we're reading: a byte came in.
+        if (_bytes_read + 1 >= transaction->read_length) {
+            // NACK the last byte to tell the device we're done, then stop.
+            i2cm->CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT;
+            _watch_i2c_stop(i2cm);
+            _watch_i2c_sync(i2cm);
+            transaction->read_buf[_bytes_read++] = i2cm->DATA.reg;
+            _watch_i2c_finish(WATCH_I2C_RESULT_SUCCESS);
+        } else {
+            _watch_i2c_sync(i2cm);
+            transaction->read_buf[_bytes_read++] = i2cm->DATA.reg;
+        }
+    }
+}
+
 void watch_enable_i2c(void) {
     HAL_GPIO_SDA_pmuxen(HAL_GPIO_PMUX_SERCOM);
     HAL_GPIO_SCL_pmuxen(HAL_GPIO_PMUX_SERCOM);
     i2c_init();
+
+    SercomI2cm *i2cm = _watch_i2c_sercom();
+    i2cm->CTRLB.reg |= SERCOM_I2CM_CTRLB_SMEN;
+    _watch_i2c_sync(i2cm);
+
     i2c_enable();
+
+    i2cm->INTENSET.reg = SERCOM_I2CM_INTENSET_MB | SERCOM_I2CM_INTENSET_SB | SERCOM_I2CM_INTENSET_ERROR;
+    NVIC_ClearPendingIRQ(WATCH_I2C_IRQn);
+    NVIC_EnableIRQ(WATCH_I2C_IRQn);
+    _i2c_enabled = true;
 }
 
 void watch_disable_i2c(void) {
+    NVIC_DisableIRQ(WATCH_I2C_IRQn);
+    _i2c_enabled = false;
+
+    // anything still queued isn't going to happen.
+    while (_queue_head != NULL) {
+        watch_i2c_transaction_t *transaction = _queue_head;
+        _queue_head = transaction->next;
+        transaction->result = WATCH_I2C_RESULT_ERR_BUS;
+        if (transaction->callback != NULL) transaction->callback(transaction);
+    }
+    _queue_tail = NULL;
+
     i2c_disable();
 }
 
+bool watch_i2c_submit(watch_i2c_transaction_t *transaction) {
+    if (!_i2c_enabled || (transaction->write_length == 0 && transaction->read_length == 0)) {
+        transaction->result = WATCH_I2C_RESULT_ERR_BUS;
+        return false;
+    }
+
+    transaction->result = WATCH_I2C_RESULT_PENDING;
+    transaction->next = NULL;
+
+    NVIC_DisableIRQ(WATCH_I2C_IRQn);
+    if (_queue_tail != NULL) {
+        _queue_tail->next = transaction;
+        _queue_tail = transaction;
+    } else {
+        _queue_head = transaction;
+        _queue_tail = transaction;
+        _watch_i2c_start(transaction);
+    }
+    NVIC_EnableIRQ(WATCH_I2C_IRQn);
+
+    return true;
+}
+
+int8_t watch_i2c_wait(watch_i2c_transaction_t *transaction) {
+    if (__get_IPSR() != 0) {
+        // Inside an interrupt handler (including our own, from a callback), the SERCOM interrupt can't preempt us
+        // if its priority isn't higher, so WFI would wait forever. Run its handler ourselves until we're done.
+        SercomI2cm *i2cm = _watch_i2c_sercom();
+        NVIC_DisableIRQ(WATCH_I2C_IRQn);
+        while (transaction->result == WATCH_I2C_RESULT_PENDING) {
+            if (i2cm->INTFLAG.reg & (SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR)) {
+                WATCH_I2C_IRQ_HANDLER();
+            }
+        }
+        NVIC_ClearPendingIRQ(WATCH_I2C_IRQn);
+        NVIC_EnableIRQ(WATCH_I2C_IRQn);
+
+        return transaction->result;
+    }
+
+    uint8_t previous_sleep_mode = PM->SLEEPCFG.bit.SLEEPMODE;
+
+    __disable_irq();
+    while (transaction->result == WATCH_I2C_RESULT_PENDING) {
+        // IDLE keeps the SERCOM clocked; its interrupt ends the WFI even with interrupts masked, and runs once
+        // we unmask them.
+        sleep(2);
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+
+    PM->SLEEPCFG.bit.SLEEPMODE = previous_sleep_mode;
+    while (PM->SLEEPCFG.bit.SLEEPMODE != previous_sleep_mode);
+
+    return transaction->result;
+}
+
+bool watch_i2c_is_busy(void) {
+    return _queue_head != NULL;
+}
+
+#else
+
+static bool _i2c_enabled = false;
+
+void watch_enable_i2c(void) {
+    HAL_GPIO_SDA_pmuxen(HAL_GPIO_PMUX_SERCOM);
+    HAL_GPIO_SCL_pmuxen(HAL_GPIO_PMUX_SERCOM);
+    i2c_init();
+    i2c_enable();
+    _i2c_enabled = true;
+}
+
+void watch_disable_i2c(void) {
+    _i2c_enabled = false;
+    i2c_disable();
+}
+
+bool watch_i2c_submit(watch_i2c_transaction_t *transaction) {
+    if (!_i2c_enabled || (transaction->write_length == 0 && transaction->read_length == 0)) {
+        transaction->result = WATCH_I2C_RESULT_ERR_BUS;
+        return false;
+    }
+
+    // the blocking driver has no repeated start, so a register read is a write and then a separate read.
+    int8_t result = WATCH_I2C_RESULT_SUCCESS;
+    transaction->next = NULL;
+    if (transaction->write_length) {
+        result = (int8_t)i2c_write(transaction->addr, (uint8_t *)transaction->write_buf, transaction->write_length);
+    }
+    if (result == WATCH_I2C_RESULT_SUCCESS && transaction->read_length) {
+        result = (int8_t)i2c_read(transaction->addr, transaction->read_buf, transaction->read_length);
+    }
+
+    transaction->result = result;
+    if (transaction->callback != NULL) transaction->callback(transaction);
+
+    return true;
+}
+
+int8_t watch_i2c_wait(watch_i2c_transaction_t *transaction) {
+    // submitting it already ran it.
+    return transaction->result;
+}
+
+bool watch_i2c_is_busy(void) {
+    return false;
+}
+
+#endif // WATCH_I2C_INTERRUPTS
+
+int8_t watch_i2c_transfer(int16_t addr, const uint8_t *write_buf, uint16_t write_length, uint8_t *read_buf, uint16_t read_length) {
+    watch_i2c_transaction_t transaction = {
+        .addr = addr,
+        .write_buf = write_buf,
+        .write_length = write_length,
+        .read_buf = read_buf,
+        .read_length = read_length,
+    };
+
+    if (!watch_i2c_submit(&transaction)) return WATCH_I2C_RESULT_ERR_BUS;
+
+    return watch_i2c_wait(&transaction);
+}
+
+int8_t watch_i2c_write8_batch(int16_t addr, const uint8_t (*reg_values)[2], uint8_t count) {
+    watch_i2c_transaction_t transactions[WATCH_I2C_MAX_BATCH];
+    int8_t result = WATCH_I2C_RESULT_SUCCESS;
+
+    if (count > WATCH_I2C_MAX_BATCH) return WATCH_I2C_RESULT_ERR_BUS;
+    if (count == 0) return WATCH_I2C_RESULT_SUCCESS;
+
+    for (uint8_t i = 0; i < count; i++) {
+        transactions[i] = (watch_i2c_transaction_t) {
+            .addr = addr,
+            .write_buf = reg_values[i],
+            .write_length = 2,
+        };
+        if (!watch_i2c_submit(&transactions[i])) return WATCH_I2C_RESULT_ERR_BUS;
+    }
+
+    // the queue runs in order, so once the last one is done, they all are.
+    watch_i2c_wait(&transactions[count - 1]);
+    for (uint8_t i = 0; i < count; i++) {
+        if (transactions[i].result != WATCH_I2C_RESULT_SUCCESS) result = transactions[i].result;
+    }
+
+    return result;
+}
+
 int8_t watch_i2c_send(int16_t addr, uint8_t *buf, uint16_t length) {
-    return (int8_t)i2c_write(addr, buf, length);
+    return watch_i2c_transfer(addr, buf, length, NULL, 0);
 }
 
 int8_t watch_i2c_receive(int16_t addr, uint8_t *buf, uint16_t length) {
-    return (int8_t)i2c_read(addr, buf, length);
+    return watch_i2c_transfer(addr, NULL, 0, buf, length);
 }
 
 int8_t watch_i2c_write8(int16_t addr, uint8_t reg, uint8_t data) {
@@ -51,16 +334,17 @@ int8_t watch_i2c_write8(int16_t addr, uint8_t reg, uint8_t data) {
     buf[0] = reg;
     buf[1] = data;
 
-    return (int8_t)watch_i2c_send(addr, (uint8_t *)&buf, 2);
+    return watch_i2c_transfer(addr, buf, 2, NULL, 0);
+}
+
+int8_t watch_i2c_read(int16_t addr, uint8_t reg, uint8_t *buf, uint16_t length) {
+    return watch_i2c_transfer(addr, &reg, 1, buf, length);
 }
 
 uint8_t watch_i2c_read8(int16_t addr, uint8_t reg) {
     uint8_t data;
 
-    if (watch_i2c_send(addr, (uint8_t *)&reg, 1) != 0) {
-        return 0;
-    }
-    if (watch_i2c_receive(addr, (uint8_t *)&data, 1) != 0) {
+    if (watch_i2c_read(addr, reg, &data, 1) != 0) {
         return 0;
     }
 
@@ -70,10 +354,7 @@ uint8_t watch_i2c_read8(int16_t addr, uint8_t reg) {
 uint16_t watch_i2c_read16(int16_t addr, uint8_t reg) {
     uint16_t data;
 
-    if (watch_i2c_send(addr, (uint8_t *)&reg, 1) != 0) {
-        return 0;
-    }
-    if (watch_i2c_receive(addr, (uint8_t *)&data, 2) != 0) {
+    if (watch_i2c_read(addr, reg, (uint8_t *)&data, 2) != 0) {
         return 0;
     }
     return data;
@@ -83,10 +364,7 @@ uint32_t watch_i2c_read24(int16_t addr, uint8_t reg) {
     uint32_t data;
     data = 0;
 
-    if (watch_i2c_send(addr, (uint8_t *)&reg, 1) != 0) {
-        return 0;
-    }
-    if (watch_i2c_receive(addr, (uint8_t *)&data, 3) != 0) {
+    if (watch_i2c_read(addr, reg, (uint8_t *)&data, 3) != 0) {
         return 0;
     }
     return data << 8;
@@ -95,10 +373,7 @@ uint32_t watch_i2c_read24(int16_t addr, uint8_t reg) {
 uint32_t watch_i2c_read32(int16_t addr, uint8_t reg) {
     uint32_t data;
 
-    if (watch_i2c_send(addr, (uint8_t *)&reg, 1) != 0) {
-        return 0;
-    }
-    if (watch_i2c_receive(addr, (uint8_t *)&data, 4) != 0) {
+    if (watch_i2c_read(addr, reg, (uint8_t *)&data, 4) != 0) {
         return 0;
     }
     return data;
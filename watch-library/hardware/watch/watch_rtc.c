@@ -29,6 +29,7 @@
 #include "watch_rtc.h"
 #include "watch_private.h"
 #include "watch_utility.h"
+#include "delay.h"
 
 static const uint32_t RTC_OSC_DIV = 10;
 static const uint32_t RTC_OSC_HZ = 1 << RTC_OSC_DIV; // 2^10 = 1024
@@ -105,6 +106,11 @@ rtc_date_time_t watch_rtc_get_date_time(void) {
     return cached_date_time.datetime;
 }
 
+static void _watch_rtc_set_unix_time_at_counter(unix_timestamp_t unix_time, rtc_counter_t counter) {
+    unix_timestamp_t tb = unix_time - (counter >> RTC_CNT_DIV) - ((counter & RTC_CNT_SUBSECOND_MASK) >> (RTC_CNT_DIV - 1)) + 1;
+    watch_store_backup_data(tb, TB_BKUP_REG);
+}
+
 void watch_rtc_set_unix_time(unix_timestamp_t unix_time) {
     /* unix_time = time_backup + counter / RTC_CNT_HZ - 0.5
      *
@@ -121,9 +127,7 @@ void watch_rtc_set_unix_time(unix_timestamp_t unix_time) {
      * 64Hz:  1, 3, 5, ..., 127
      * 128Hz: 0, 1, 2, ..., 127
     */
-    rtc_counter_t counter = rtc_get_counter();
-    unix_timestamp_t tb = unix_time - (counter >> RTC_CNT_DIV) - ((counter & RTC_CNT_SUBSECOND_MASK) >> (RTC_CNT_DIV - 1)) + 1;
-    watch_store_backup_data(tb, TB_BKUP_REG);
+    _watch_rtc_set_unix_time_at_counter(unix_time, rtc_get_counter());
 }
 
 unix_timestamp_t watch_rtc_get_unix_time(void) {
@@ -133,6 +137,43 @@ unix_timestamp_t watch_rtc_get_unix_time(void) {
     return tb + (counter >> RTC_CNT_DIV) + ((counter & RTC_CNT_SUBSECOND_MASK) >> (RTC_CNT_DIV - 1)) - 1;
 }
 
+static uint16_t _watch_rtc_counter_to_ms(rtc_counter_t counter) {
+    // the second starts at subsecond tick 64, so that's where the milliseconds start counting from too.
+    return (((counter + (RTC_CNT_HZ >> 1)) & RTC_CNT_SUBSECOND_MASK) * 1000) >> RTC_CNT_DIV;
+}
+
+unix_timestamp_t watch_rtc_get_unix_time_ms(uint16_t *ms) {
+    rtc_counter_t counter = rtc_get_counter();
+    unix_timestamp_t tb = watch_get_backup_data(TB_BKUP_REG);
+    *ms = _watch_rtc_counter_to_ms(counter);
+    return tb + (counter >> RTC_CNT_DIV) + ((counter & RTC_CNT_SUBSECOND_MASK) >> (RTC_CNT_DIV - 1)) - 1;
+}
+
+void watch_rtc_set_unix_time_ms(unix_timestamp_t unix_time, uint16_t ms) {
+    uint16_t current_ms;
+    watch_rtc_get_unix_time_ms(&current_ms);
+
+    // We never write the counter (see watch_rtc_get_counter), so the only way to move the subsecond phase is to
+    // hold the RTC for however long it takes the current millisecond to line up with the requested one. Counter
+    // deadlines slip by the same amount; the header says so, and callers have to re-arm them.
+    uint16_t lag = (current_ms + 1000 - ms) % 1000;
+    if (lag) {
+        watch_rtc_enable(false);
+        delay_ms(lag);
+        watch_rtc_enable(true);
+    }
+
+    // now the phase matches, and real time has moved on by the lag plus whatever it took us to get here. Work out
+    // which second we're in from the same counter value we store the time base against, so a second boundary
+    // passing in between can't put us off by one.
+    rtc_counter_t counter = rtc_get_counter();
+    uint32_t target = ms + lag;
+    int32_t elapsed = (_watch_rtc_counter_to_ms(counter) + 1000 - target % 1000) % 1000;
+    if (elapsed > 500) elapsed -= 1000;
+    int32_t now_ms = (int32_t)target + elapsed;
+    _watch_rtc_set_unix_time_at_counter(unix_time + (now_ms < 0 ? -1 : now_ms / 1000), counter);
+}
+
 rtc_counter_t watch_rtc_get_counter(void) {
     return rtc_get_counter();
 }
@@ -7,6 +7,8 @@
 #define RWWEE_ADDR_END (NVMCTRL_RWW_EEPROM_ADDR + NVMCTRL_PAGE_SIZE * NVMCTRL_RWWEE_PAGES)
 #define NVM_MEMORY ((volatile uint16_t *)FLASH_ADDR)
 
+void irq_handler_nvmctrl(void);
+
 static bool _is_valid_address(uint32_t addr, uint32_t size) {
     if ((addr < NVMCTRL_RWW_EEPROM_ADDR) || (addr > (NVMCTRL_RWW_EEPROM_ADDR + NVMCTRL_PAGE_SIZE * NVMCTRL_RWWEE_PAGES))) {
         return false;
@@ -18,32 +20,24 @@ static bool _is_valid_address(uint32_t addr, uint32_t size) {
     return true;
 }
 
-bool watch_storage_read(uint32_t row, uint32_t offset, uint8_t *buffer, uint32_t size) {
+const uint8_t *watch_storage_get_address(uint32_t row, uint32_t offset) {
     uint32_t address = RWWEE_ADDR_START + row * NVMCTRL_ROW_SIZE + offset;
-    if (!_is_valid_address(address, size)) return false;
-
-    uint32_t nvm_address = address / 2;
-    uint32_t i;
-    uint16_t data;
+    // there has to be at least one byte there to read.
+    if (!_is_valid_address(address, 1)) return NULL;
 
+    // the RWWEE area reads back garbage while a write or erase is in progress.
     watch_storage_sync();
 
-    if (address % 2) {
-        data      = NVM_MEMORY[nvm_address++];
-        buffer[0] = data >> 8;
-        i         = 1;
-    } else {
-        i = 0;
-    }
+    return (const uint8_t *)address;
+}
+
+bool watch_storage_read(uint32_t row, uint32_t offset, uint8_t *buffer, uint32_t size) {
+    uint32_t address = RWWEE_ADDR_START + row * NVMCTRL_ROW_SIZE + offset;
+    if (!_is_valid_address(address, size)) return false;
+
+    // RWWEE is memory mapped, so once the controller is idle a read is just a copy.
+    memcpy(buffer, watch_storage_get_address(row, offset), size);
 
-    while (i < size) {
-        data = NVM_MEMORY[nvm_address++];
-        buffer[i] = (data & 0xFF);
-        if (i < (size - 1)) {
-            buffer[i + 1] = (data >> 8);
-        }
-        i += 2;
-    }
     return true;
 }
 
@@ -83,12 +77,45 @@ bool watch_storage_erase(uint32_t row) {
     return true;
 }
 
+bool watch_storage_is_busy(void) {
+    return !NVMCTRL->INTFLAG.bit.READY;
+}
+
 bool watch_storage_sync(void) {
-    while (!NVMCTRL->INTFLAG.bit.READY) {
-        // wait for flash to become ready
+    if (watch_storage_is_busy()) {
+        // A row erase takes several milliseconds, so rather than spinning at full power, we idle the CPU until
+        // the NVMCTRL READY interrupt fires. Flash keeps its clocks in IDLE, which it would not in STANDBY.
+        uint8_t previous_sleep_mode = PM->SLEEPCFG.bit.SLEEPMODE;
+        PM->SLEEPCFG.bit.SLEEPMODE = PM_SLEEPCFG_SLEEPMODE_IDLE_Val;
+        while (PM->SLEEPCFG.bit.SLEEPMODE != PM_SLEEPCFG_SLEEPMODE_IDLE_Val);
+
+        NVIC_ClearPendingIRQ(NVMCTRL_IRQn);
+        NVIC_EnableIRQ(NVMCTRL_IRQn);
+
+        // Interrupts are masked while we check the flag, so the READY interrupt can't slip in between the check and
+        // the WFI. A pending interrupt still wakes the core from WFI with PRIMASK set; any other interrupt (RTC tick,
+        // button, USB) just sends us around the loop again.
+        __disable_irq();
+        while (watch_storage_is_busy()) {
+            NVMCTRL->INTENSET.reg = NVMCTRL_INTENSET_READY;
+            __DSB();
+            __WFI();
+            __enable_irq();
+            __disable_irq();
+        }
+        __enable_irq();
+
+        PM->SLEEPCFG.bit.SLEEPMODE = previous_sleep_mode;
+        while (PM->SLEEPCFG.bit.SLEEPMODE != previous_sleep_mode);
     }
 
     NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
 
     return true;
 }
+
+void irq_handler_nvmctrl(void) {
+    // READY is a level flag that stays set while the controller is idle, so this interrupt is one-shot:
+    // watch_storage_sync re-arms it each time it needs to wait.
+    NVMCTRL->INTENCLR.reg = NVMCTRL_INTENCLR_READY;
+}
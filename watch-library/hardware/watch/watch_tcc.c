@@ -50,6 +50,28 @@ static volatile bool _led_is_active = false;
 static volatile bool _buzzer_is_active = false;
 static volatile uint8_t _current_led_color[3] = {0, 0, 0};
 
+// With WATCH_BUZZER_DMA (BUZZER_DMA=1 in the Makefile), note sequences are played by the DMAC: on every TC0 overflow,
+// an event tells three DMA channels to load the next note's TCC period and duty cycle, and the TC0 period that sets
+// how long the note after that will last. The CPU only wakes up once, when the sequence is over. Sequences longer
+// than this (after resolving repeats), or played while the LED is on, fall back to the 64 Hz TC0 interrupt.
+// This takes over the whole DMAC (its descriptor and write-back base addresses), and hasn't been tried on enough
+// hardware to be the default yet; without the flag, every sequence uses the TC0 interrupt.
+#ifdef WATCH_BUZZER_DMA
+#define WATCH_BUZZER_DMA_MAX_NOTES (176)
+#define WATCH_BUZZER_DMA_CHANNEL_PERIOD (0)
+#define WATCH_BUZZER_DMA_CHANNEL_DUTY (1)
+#define WATCH_BUZZER_DMA_CHANNEL_TICKS (2)
+#define WATCH_BUZZER_DMA_NUM_CHANNELS (3)
+#define WATCH_BUZZER_EVSYS_CHANNEL (0)
+
+static uint16_t _dma_periods[WATCH_BUZZER_DMA_MAX_NOTES + 1];
+static uint16_t _dma_duties[WATCH_BUZZER_DMA_MAX_NOTES + 1];
+static uint8_t _dma_ticks[WATCH_BUZZER_DMA_MAX_NOTES + 1];
+static DmacDescriptor _dma_descriptors[WATCH_BUZZER_DMA_NUM_CHANNELS] __attribute__((aligned(16)));
+static DmacDescriptor _dma_writeback[WATCH_BUZZER_DMA_NUM_CHANNELS] __attribute__((aligned(16)));
+static volatile bool _dma_is_active = false;
+#endif
+
 static void _watch_set_led_duty_cycle(uint32_t period, uint8_t red, uint8_t green, uint8_t blue);
 
 static void _tcc_write_RUNSTDBY(bool value) {
@@ -81,6 +103,151 @@ static void _tc0_initialize() {
     NVIC_EnableIRQ (TC0_IRQn);
 }
 
+#ifdef WATCH_BUZZER_DMA
+
+static bool _watch_buzzer_dma_init(void) {
+    if (DMAC->CTRL.bit.DMAENABLE) {
+        // if someone else set up the DMAC, their descriptors are in charge and we can't use it.
+        return DMAC->BASEADDR.reg == (uint32_t)_dma_descriptors;
+    }
+
+    MCLK->AHBMASK.reg |= MCLK_AHBMASK_DMAC;
+    DMAC->BASEADDR.reg = (uint32_t)_dma_descriptors;
+    DMAC->WRBADDR.reg = (uint32_t)_dma_writeback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+    NVIC_ClearPendingIRQ(DMAC_IRQn);
+    NVIC_EnableIRQ(DMAC_IRQn);
+
+    return true;
+}
+
+// Resolves a note sequence into one flat entry per note, with repeats unrolled exactly as cb_watch_buzzer_seq
+// would play them. After the last note comes one tick of silence, whose loading marks the end of the sequence.
+// Returns the number of notes, or 0 if the sequence is empty or can't be played by the DMAC.
+static uint16_t _watch_buzzer_compile_sequence(int8_t *sequence) {
+    uint16_t position = 0;
+    uint16_t count = 0;
+    int8_t repeat_counter = -1;
+    uint16_t period = 1000;
+
+    while (true) {
+        if (sequence[position] < 0 && sequence[position + 1]) {
+            if (repeat_counter == -1) repeat_counter = sequence[position + 1];
+            else repeat_counter--;
+            if (repeat_counter > 0) {
+                if (position > sequence[position] * -2) position += sequence[position] * 2;
+                else position = 0;
+            } else {
+                position += 2;
+                repeat_counter = -1;
+            }
+        }
+        if (!sequence[position] || !sequence[position + 1]) break;
+
+        // out of room, or a repeat marker where a note should be; leave it to the interrupt.
+        if (count == WATCH_BUZZER_DMA_MAX_NOTES || sequence[position] < 0) return 0;
+
+        watch_buzzer_note_t note = sequence[position];
+        if (note != BUZZER_NOTE_REST) {
+            period = NotePeriods[note];
+            _dma_duties[count] = period / (100 / _volume);
+        } else {
+            // a rest keeps the pin on the TCC, but with a duty cycle of zero.
+            _dma_duties[count] = 0;
+        }
+        _dma_periods[count] = period;
+        _dma_ticks[count] = sequence[position + 1] - 1;
+        count++;
+        position += 2;
+    }
+
+    _dma_periods[count] = period;
+    _dma_duties[count] = 0;
+    _dma_ticks[count] = 0;
+
+    return count;
+}
+
+static void _watch_buzzer_setup_dma_channel(uint8_t channel, const void *source, uint8_t beat_size, volatile void *destination, uint16_t beats, bool interrupt) {
+    DmacDescriptor *descriptor = &_dma_descriptors[channel];
+    descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC |
+                             (beat_size == 2 ? DMAC_BTCTRL_BEATSIZE_HWORD : DMAC_BTCTRL_BEATSIZE_BYTE) |
+                             (interrupt ? DMAC_BTCTRL_BLOCKACT_INT : DMAC_BTCTRL_BLOCKACT_NOACT);
+    descriptor->BTCNT.reg = beats;
+    // when the source address increments, the descriptor points at the end of the block.
+    descriptor->SRCADDR.reg = (uint32_t)source + beats * beat_size;
+    descriptor->DSTADDR.reg = (uint32_t)destination;
+    descriptor->DESCADDR.reg = 0;
+
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg = 0;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.bit.SWRST);
+    // no peripheral trigger: one beat per event from EVSYS.
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_EVIE | DMAC_CHCTRLB_EVACT_TRIG | DMAC_CHCTRLB_TRIGACT_BEAT;
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+    if (interrupt) DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+    else DMAC->CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE | DMAC_CHCTRLA_RUNSTDBY;
+}
+
+static void _watch_buzzer_start_dma_sequence(uint16_t count) {
+    _dma_is_active = true;
+
+    // the first note is set up by hand...
+    tcc_set_period(0, _dma_periods[0], true);
+    tcc_set_cc(0, (WATCH_BUZZER_TCC_CHANNEL) % 4, _dma_duties[0], true);
+    watch_set_buzzer_on();
+
+    // ...and TC0 counts ticks of 64 Hz, overflowing at the end of each note. PER is double buffered, so when a
+    // note starts, the length of the next one has to be in PERBUF already: the DMA stays one note ahead for it.
+    tc_init(0, GENERIC_CLOCK_3, TC_PRESCALER_DIV16);
+    tc_set_counter_mode(0, TC_COUNTER_MODE_8BIT);
+    tc_set_run_in_standby(0, true);
+    tc_count8_set_period(0, _dma_ticks[0]);
+    TC0->COUNT8.PERBUF.reg = _dma_ticks[1];
+    TC0->COUNT8.INTENCLR.reg = TC_INTENCLR_OVF;
+    TC0->COUNT8.EVCTRL.reg = TC_EVCTRL_OVFEO;
+
+    // one event channel from TC0 overflow to all three DMA channels.
+    MCLK->APBCMASK.reg |= MCLK_APBCMASK_EVSYS;
+    GCLK->PCHCTRL[EVSYS_GCLK_ID_0 + WATCH_BUZZER_EVSYS_CHANNEL].reg = GCLK_PCHCTRL_GEN(GENERIC_CLOCK_3) | GCLK_PCHCTRL_CHEN;
+    while (!(GCLK->PCHCTRL[EVSYS_GCLK_ID_0 + WATCH_BUZZER_EVSYS_CHANNEL].reg & GCLK_PCHCTRL_CHEN));
+    EVSYS->CHANNEL[WATCH_BUZZER_EVSYS_CHANNEL].reg = EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_TC0_OVF) |
+                                                     EVSYS_CHANNEL_PATH_RESYNCHRONIZED |
+                                                     EVSYS_CHANNEL_EDGSEL_RISING_EDGE |
+                                                     EVSYS_CHANNEL_RUNSTDBY;
+    for (uint8_t i = 0; i < WATCH_BUZZER_DMA_NUM_CHANNELS; i++) {
+        EVSYS->USER[EVSYS_ID_USER_DMAC_CH_0 + i].reg = EVSYS_USER_CHANNEL(WATCH_BUZZER_EVSYS_CHANNEL + 1);
+    }
+
+    // notes 1 through the closing silence. Only the duty cycle channel interrupts: its last beat is the silence.
+    _watch_buzzer_setup_dma_channel(WATCH_BUZZER_DMA_CHANNEL_PERIOD, &_dma_periods[1], 2, &TCC0->PERBUF.reg, count, false);
+    _watch_buzzer_setup_dma_channel(WATCH_BUZZER_DMA_CHANNEL_DUTY, &_dma_duties[1], 2, &TCC0->CCBUF[(WATCH_BUZZER_TCC_CHANNEL) % 4].reg, count, true);
+    if (count > 1) {
+        _watch_buzzer_setup_dma_channel(WATCH_BUZZER_DMA_CHANNEL_TICKS, &_dma_ticks[2], 1, &TC0->COUNT8.PERBUF.reg, count - 1, false);
+    }
+
+    _tc0_start();
+}
+
+static void _watch_buzzer_stop_dma_sequence(void) {
+    _dma_is_active = false;
+
+    for (uint8_t i = 0; i < WATCH_BUZZER_DMA_NUM_CHANNELS; i++) {
+        DMAC->CHID.reg = DMAC_CHID_ID(i);
+        DMAC->CHCTRLA.reg = 0;
+        DMAC->CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+        DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+        EVSYS->USER[EVSYS_ID_USER_DMAC_CH_0 + i].reg = 0;
+    }
+    EVSYS->CHANNEL[WATCH_BUZZER_EVSYS_CHANNEL].reg = 0;
+    GCLK->PCHCTRL[EVSYS_GCLK_ID_0 + WATCH_BUZZER_EVSYS_CHANNEL].reg = 0;
+    TC0->COUNT8.EVCTRL.reg = 0;
+}
+
+#endif // WATCH_BUZZER_DMA
+
 void watch_buzzer_play_sequence(int8_t *note_sequence, void (*callback_on_end)(void)) {
     watch_buzzer_play_sequence_with_volume(note_sequence, callback_on_end, WATCH_BUZZER_VOLUME_LOUD);
 }
@@ -102,7 +269,19 @@ void watch_buzzer_play_sequence_with_volume(int8_t *note_sequence, void (*callba
     _tone_ticks = 0;
     _repeat_counter = -1;
     // prepare buzzer
-    
+
+#ifdef WATCH_BUZZER_DMA
+    // The LED's duty cycles have to follow the buzzer's period, which the DMA can't do.
+    if (!_led_is_active && _watch_buzzer_dma_init()) {
+        uint16_t count = _watch_buzzer_compile_sequence(note_sequence);
+        if (count) {
+            _cb_tc0 = NULL;
+            _watch_buzzer_start_dma_sequence(count);
+            return;
+        }
+    }
+#endif
+
     _cb_tc0 = cb_watch_buzzer_seq;
     // setup TC0 timer
     _tc0_initialize();
@@ -214,6 +393,9 @@ void watch_buzzer_abort_sequence(void) {
     }
 
     _tc0_stop();
+#ifdef WATCH_BUZZER_DMA
+    if (_dma_is_active) _watch_buzzer_stop_dma_sequence();
+#endif
 
     watch_set_buzzer_off();
 
@@ -242,6 +424,18 @@ void irq_handler_tc0(void) {
     TC0->COUNT8.INTFLAG.reg |= TC_INTFLAG_OVF;
 }
 
+#ifdef WATCH_BUZZER_DMA
+void irq_handler_dmac(void);
+void irq_handler_dmac(void) {
+    // the duty cycle channel finished its block: the sequence is over.
+    DMAC->CHID.reg = DMAC_CHID_ID(WATCH_BUZZER_DMA_CHANNEL_DUTY);
+    if (DMAC->CHINTFLAG.bit.TCMPL) {
+        DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+        watch_buzzer_abort_sequence();
+    }
+}
+#endif
+
 void _watch_maybe_enable_tcc(void) {
     if (!_buzzer_is_active && !_led_is_active) {
         return;
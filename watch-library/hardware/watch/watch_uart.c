@@ -23,10 +23,22 @@
  */
 
 #include "watch_uart.h"
+#include "watch_extint.h"
 #include "uart.h"
 #include "usb.h"
 #include <string.h>
 
+// How long the shell stays awake after the last character it received.
+#define WATCH_UART_SHELL_AWAKE_SECONDS (10)
+
+static bool s_shell_enabled = false;
+static uint16_t s_shell_rx_pin = 0;
+// Set whenever a character comes in (or a start bit wakes us); cleared by the app loop.
+static volatile bool s_shell_rx_activity = false;
+// When set, the RX pin is routed to the EIC instead of the SERCOM, and the next start bit will wake us up.
+static volatile bool s_shell_asleep = false;
+static rtc_counter_t s_shell_awake_until = 0;
+
 void watch_enable_uart(const uint16_t tx_pin, const uint16_t rx_pin, uint32_t baud) {
     uart_rxpo_t rxpo = UART_RXPO_NONE;
 
@@ -69,7 +81,83 @@ size_t watch_uart_gets(char *data, size_t max_length) {
     return uart_read_instance(3, data, max_length);
 }
 
+static void _watch_uart_set_rx_pmux(uint16_t rx_pin, uint8_t pmux) {
+    if (rx_pin == HAL_GPIO_A1_pin()) {
+        HAL_GPIO_A1_pmuxen(pmux);
+    } else if (rx_pin == HAL_GPIO_A2_pin()) {
+        HAL_GPIO_A2_pmuxen(pmux);
+    } else if (rx_pin == HAL_GPIO_A3_pin()) {
+        HAL_GPIO_A3_pmuxen(pmux);
+    } else if (rx_pin == HAL_GPIO_A4_pin()) {
+        HAL_GPIO_A4_pmuxen(pmux);
+    }
+}
+
+static void _watch_uart_shell_cb_start_bit(void) {
+    // hand the pin back to the SERCOM right away; with any luck it catches the rest of this character.
+    _watch_uart_set_rx_pmux(s_shell_rx_pin, HAL_GPIO_PMUX_SERCOM);
+    s_shell_asleep = false;
+    s_shell_rx_activity = true;
+}
+
+void watch_uart_shell_enable(const uint16_t tx_pin, const uint16_t rx_pin, uint32_t baud) {
+    s_shell_rx_pin = rx_pin;
+
+    // configure the EIC channel once; after this, sleeping and waking only move the pin between EIC and SERCOM.
+    watch_register_interrupt_callback(rx_pin, _watch_uart_shell_cb_start_bit, INTERRUPT_TRIGGER_FALLING);
+    watch_enable_uart(tx_pin, rx_pin, baud);
+
+    s_shell_enabled = true;
+    s_shell_asleep = false;
+    s_shell_rx_activity = true;
+}
+
+void watch_uart_shell_disable(void) {
+    s_shell_enabled = false;
+    s_shell_asleep = false;
+    uart_disable_instance(3);
+}
+
+bool watch_uart_shell_is_enabled(void) {
+    return s_shell_enabled;
+}
+
+bool watch_uart_shell_is_awake(void) {
+    if (!s_shell_enabled || s_shell_asleep) return false;
+
+    rtc_counter_t now = watch_rtc_get_counter();
+    if (s_shell_rx_activity) {
+        s_shell_rx_activity = false;
+        s_shell_awake_until = now + WATCH_UART_SHELL_AWAKE_SECONDS * watch_rtc_get_frequency();
+    }
+
+    if ((int32_t)(now - s_shell_awake_until) >= 0) {
+        // quiet for long enough: let the next start bit wake us through the EIC, so we can go to STANDBY.
+        s_shell_asleep = true;
+        _watch_uart_set_rx_pmux(s_shell_rx_pin, HAL_GPIO_PMUX_EIC);
+        return false;
+    }
+
+    return true;
+}
+
+bool watch_uart_shell_has_pending_input(void) {
+    return s_shell_enabled && s_shell_rx_activity;
+}
+
+int watch_uart_shell_write(char *ptr, int len) {
+    uart_write_instance(3, ptr, len);
+    return len;
+}
+
+int watch_uart_shell_read(char *ptr, int len) {
+    size_t bytes_read = uart_read_instance(3, ptr, len);
+    // like the USB CDC version, report an empty buffer as an error rather than end of file.
+    return bytes_read ? (int)bytes_read : -1;
+}
+
 void irq_handler_sercom3(void);
 void irq_handler_sercom3(void) {
+    if (SERCOM3->USART.INTFLAG.bit.RXC) s_shell_rx_activity = true;
     uart_irq_handler(3);
 }
\ No newline at end of file
@@ -24,7 +24,10 @@
  */
 
 #include <stddef.h>
+#include <string.h>
 #include "watch_usb_cdc.h"
+#include "watch_uart.h"
+#include "sam.h"
 #include "tusb.h"
 
 /*
@@ -42,6 +45,10 @@ static char s_write_buf[CDC_WRITE_BUF_SZ] = {0};
 static size_t s_write_buf_pos = 0;
 static size_t s_write_buf_len = 0;
 
+// When set, _write waits for room in the buffer instead of overwriting unsent output.
+static bool s_blocking_writes = false;
+static cdc_write_stats_t s_write_stats = {0};
+
 #define CDC_READ_BUF_SZ  (256)
 #define CDC_READ_BUF_IDX(x)  ((x) & (CDC_READ_BUF_SZ - 1))
 static char s_read_buf[CDC_READ_BUF_SZ] = {0};
@@ -55,23 +62,51 @@ int _write(int file, char *ptr, int len) {
         return -1;
     }
 
+    // A shell attached to the UART takes over stdio.
+    if (watch_uart_shell_is_enabled()) {
+        return watch_uart_shell_write(ptr, len);
+    }
+
     int bytes_written = 0;
 
-    for (int i = 0; i < len; i++) {
-        s_write_buf[s_write_buf_pos] = ptr[i];
-        s_write_buf_pos = CDC_WRITE_BUF_IDX(s_write_buf_pos + 1);
-        if (s_write_buf_len < CDC_WRITE_BUF_SZ) {
-            s_write_buf_len++;
+    while (bytes_written < len) {
+        size_t remaining = len - bytes_written;
+
+        // Blocking mode can't spin from inside an interrupt handler; the USB stack wouldn't get serviced.
+        if (s_blocking_writes && __get_IPSR() == 0) {
+            cdc_wait_for_write_space(remaining < CDC_WRITE_BUF_SZ ? remaining : CDC_WRITE_BUF_SZ);
         }
-        bytes_written++;
+
+        // Copy the largest span that doesn't wrap around the end of the buffer.
+        size_t span = CDC_WRITE_BUF_SZ - s_write_buf_pos;
+        if (span > remaining) {
+            span = remaining;
+        }
+        memcpy(&s_write_buf[s_write_buf_pos], &ptr[bytes_written], span);
+        s_write_buf_pos = CDC_WRITE_BUF_IDX(s_write_buf_pos + span);
+
+        // Anything beyond the buffer's capacity overwrote the oldest unsent output.
+        s_write_buf_len += span;
+        if (s_write_buf_len > CDC_WRITE_BUF_SZ) {
+            s_write_stats.bytes_dropped += s_write_buf_len - CDC_WRITE_BUF_SZ;
+            s_write_buf_len = CDC_WRITE_BUF_SZ;
+        }
+
+        bytes_written += span;
     }
 
+    s_write_stats.bytes_queued += bytes_written;
+
     return bytes_written;
 }
 
 int _read(int file, char *ptr, int len) {
     (void) file;
 
+    if (ptr != NULL && len > 0 && watch_uart_shell_is_enabled()) {
+        return watch_uart_shell_read(ptr, len);
+    }
+
     if (ptr == NULL || len <= 0 || s_read_buf_len == 0) {
         return -1;
     }
@@ -112,21 +147,34 @@ static void prv_handle_reads(void) {
 
 static void prv_handle_writes(void) {
     if (s_write_buf_len > 0) {
-        const size_t start_pos =
-            CDC_WRITE_BUF_IDX(s_write_buf_pos - s_write_buf_len);
-        for (size_t i = 0; i < (size_t) s_write_buf_len; i++) {
-            const size_t idx = CDC_WRITE_BUF_IDX(start_pos + i);
+        while (s_write_buf_len > 0) {
             if (tud_cdc_available() > 0) {
                 // If we receive data while doing a large write, we need to
                 // fully service it before continuing to write, or the
                 // stack will crash.
                 prv_handle_reads();
             }
-            if (tud_cdc_write_available()) {
-                tud_cdc_write(&s_write_buf[idx], 1);
+
+            // Hand TinyUSB the largest span it will take that doesn't wrap
+            // around the end of our buffer.
+            const size_t start_pos =
+                CDC_WRITE_BUF_IDX(s_write_buf_pos - s_write_buf_len);
+            size_t span = CDC_WRITE_BUF_SZ - start_pos;
+            if (span > s_write_buf_len) {
+                span = s_write_buf_len;
+            }
+            size_t available = tud_cdc_write_available();
+            if (span > available) {
+                span = available;
             }
-            s_write_buf[idx] = 0;
-            s_write_buf_len--;
+            if (span == 0) {
+                // TinyUSB's FIFO is full; leave the rest in our buffer for next time.
+                break;
+            }
+
+            span = tud_cdc_write(&s_write_buf[start_pos], span);
+            s_write_buf_len -= span;
+            s_write_stats.bytes_sent += span;
         }
         tud_cdc_write_flush();
     }
@@ -136,3 +184,48 @@ void cdc_task(void) {
     prv_handle_reads();
     prv_handle_writes();
 }
+
+bool cdc_has_pending_work(void) {
+    // tud_task_event_ready is set from the USB interrupt when the stack has events queued for tud_task.
+    return tud_task_event_ready() ||
+           tud_cdc_available() > 0 ||
+           s_read_buf_len > 0 ||
+           (s_write_buf_len > 0 && tud_cdc_write_available() > 0);
+}
+
+bool cdc_service(void) {
+    if (!tud_cdc_connected()) {
+        return false;
+    }
+    tud_task();
+    cdc_task();
+    return true;
+}
+
+void cdc_set_blocking_writes(bool blocking) {
+    s_blocking_writes = blocking;
+}
+
+cdc_write_stats_t cdc_get_write_stats(void) {
+    cdc_write_stats_t stats = s_write_stats;
+    stats.bytes_pending = s_write_buf_len;
+    return stats;
+}
+
+void cdc_reset_write_stats(void) {
+    memset(&s_write_stats, 0, sizeof(s_write_stats));
+}
+
+bool cdc_wait_for_write_space(size_t len) {
+    if (len > CDC_WRITE_BUF_SZ) {
+        len = CDC_WRITE_BUF_SZ;
+    }
+
+    while (CDC_WRITE_BUF_SZ - s_write_buf_len < len) {
+        if (!cdc_service()) {
+            return false;
+        }
+    }
+
+    return true;
+}
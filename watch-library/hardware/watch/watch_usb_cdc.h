@@ -25,6 +25,49 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t bytes_queued;   // bytes passed to _write
+    uint32_t bytes_sent;     // bytes handed to TinyUSB
+    uint32_t bytes_dropped;  // bytes overwritten before they could be sent
+    uint32_t bytes_pending;  // bytes still waiting in the write buffer
+} cdc_write_stats_t;
+
 int _write(int file, char *ptr, int len);
 int _read(int file, char *ptr, int len);
 void cdc_task(void);
+
+/*
+ * Returns true if there is USB work for cdc_task or tud_task to do: events
+ * queued by the USB interrupt, input for the shell, or output that TinyUSB
+ * has room for. If this returns false, it's safe to idle until the next
+ * interrupt.
+ */
+bool cdc_has_pending_work(void);
+
+/*
+ * Services the USB stack and moves data in and out of the CDC buffers once.
+ * For code that has to wait on the host without returning to the main loop.
+ * Returns false if the host has disconnected.
+ */
+bool cdc_service(void);
+
+/*
+ * Services the USB stack until at least len bytes can be written to stdout
+ * without overwriting anything that hasn't been sent yet. Returns false if
+ * the host has disconnected.
+ */
+bool cdc_wait_for_write_space(size_t len);
+
+/*
+ * By default, output that doesn't fit in the write buffer overwrites the
+ * oldest unsent output. In blocking mode, _write instead services the USB
+ * stack until there's room, so nothing is lost while a host is connected.
+ */
+void cdc_set_blocking_writes(bool blocking);
+
+cdc_write_stats_t cdc_get_write_stats(void);
+void cdc_reset_write_stats(void);
@@ -27,13 +27,18 @@
 
 bool lis2dw_begin(void) {
 #ifdef I2C_SERCOM
+    static const uint8_t reset_sequence[][2] = {
+        { LIS2DW_REG_CTRL2, LIS2DW_CTRL2_VAL_BOOT },
+        { LIS2DW_REG_CTRL2, LIS2DW_CTRL2_VAL_SOFT_RESET },
+        // Enable block data update (output registers not updated until MSB and LSB have been read) and address autoincrement
+        { LIS2DW_REG_CTRL2, LIS2DW_CTRL2_VAL_BDU | LIS2DW_CTRL2_VAL_IF_ADD_INC },
+    };
+
     if (lis2dw_get_device_id() != LIS2DW_WHO_AM_I_VAL) {
         return false;
     }
-    watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL2, LIS2DW_CTRL2_VAL_BOOT);
-    watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL2, LIS2DW_CTRL2_VAL_SOFT_RESET);
-    // Enable block data update (output registers not updated until MSB and LSB have been read) and address autoincrement
-    watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL2, LIS2DW_CTRL2_VAL_BDU | LIS2DW_CTRL2_VAL_IF_ADD_INC);
+    // queue the whole reset at once, and sleep until the bus is done with it.
+    watch_i2c_write8_batch(LIS2DW_ADDRESS, reset_sequence, sizeof(reset_sequence) / sizeof(reset_sequence[0]));
 
     // Parameters at startup: 
     //  * Data rate 0 (powered down)
@@ -277,27 +282,42 @@ inline void lis2dw_disable_fifo(void) {
 #endif
 }
 
-bool lis2dw_read_fifo(lis2dw_fifo_t *fifo_data, uint32_t timeout) {
-    // timeout is in terms of 1/RTC_CNT_HZ seconds (likely 128 timeouts is one second)
-#ifdef I2C_SERCOM
-    uint8_t temp = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_FIFO_SAMPLE);
-    bool overrun = !!(temp & LIS2DW_FIFO_SAMPLE_OVERRUN);
+bool lis2dw_read_fifo(lis2dw_fifo_t *fifo_data) {
+    bool overrun;
+
+    fifo_data->count = lis2dw_read_fifo_burst(fifo_data->readings, sizeof(fifo_data->readings) / sizeof(lis2dw_reading_t), &overrun);
+
+    return overrun;
+}
 
-    fifo_data->count = temp & LIS2DW_FIFO_SAMPLE_COUNT;
+void lis2dw_configure_fifo(lis2dw_fifo_mode_t mode, uint8_t threshold) {
+#ifdef I2C_SERCOM
+    watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_FIFO_CTRL, (mode << 5) | (threshold & LIS2DW_FIFO_CTRL_FTH));
+#else
+    (void)mode;
+    (void)threshold;
+#endif
+}
 
-    rtc_counter_t timeout_counter = watch_rtc_get_counter() + timeout;
-    for(int i = 0; i < fifo_data->count; i++) {
-        if (watch_rtc_get_counter() > timeout_counter) {
-            break;
-        }
-        fifo_data->readings[i] = lis2dw_get_raw_reading();
+uint8_t lis2dw_read_fifo_burst(lis2dw_reading_t *readings, uint8_t max_count, bool *overrun) {
+#ifdef I2C_SERCOM
+    uint8_t temp = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_FIFO_SAMPLE);
+    uint8_t count = temp & LIS2DW_FIFO_SAMPLE_COUNT;
+    if (count > max_count) count = max_count;
+    if (overrun != NULL) *overrun = !!(temp & LIS2DW_FIFO_SAMPLE_OVERRUN);
+
+    if (count) {
+        // with the FIFO on, the output register address wraps from OUT_Z_H back to OUT_X_L, so the whole FIFO
+        // comes out in one transaction. The samples arrive little-endian, X, Y, Z: the same layout as our struct.
+        watch_i2c_read(LIS2DW_ADDRESS, LIS2DW_REG_OUT_X_L | 0x80, (uint8_t *)readings, count * sizeof(lis2dw_reading_t));
     }
 
-    return overrun;
+    return count;
 #else
-    (void) fifo_data;
-    (void) timeout;
-    return false;
+    (void) readings;
+    (void) max_count;
+    if (overrun != NULL) *overrun = false;
+    return 0;
 #endif
 }
 
@@ -336,6 +356,14 @@ void lis2dw_disable_sleep(void) {
 #endif
 }
 
+bool lis2dw_get_sleep_enabled(void) {
+#ifdef I2C_SERCOM
+    return (watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_THS) & LIS2DW_WAKE_UP_THS_VAL_SLEEP_ON) != 0;
+#else
+    return false;
+#endif
+}
+
 void lis2dw_enable_stationary_motion_detection(void) {
 #ifdef I2C_SERCOM
     uint8_t configuration = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_DUR);
@@ -350,6 +378,14 @@ void lis2dw_disable_stationary_motion_detection(void) {
 #endif
 }
 
+bool lis2dw_get_stationary_motion_detection(void) {
+#ifdef I2C_SERCOM
+    return (watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_DUR) & LIS2DW_WAKE_UP_DUR_STATIONARY) != 0;
+#else
+    return false;
+#endif
+}
+
 void lis2dw_configure_wakeup_threshold(uint8_t threshold) {
 #ifdef I2C_SERCOM
     uint8_t configuration = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_THS) & 0b11000000;
@@ -359,6 +395,18 @@ void lis2dw_configure_wakeup_threshold(uint8_t threshold) {
 #endif
 }
 
+void lis2dw_configure_wakeup_duration(uint8_t wake_duration, uint8_t sleep_duration) {
+#ifdef I2C_SERCOM
+    // leave the free-fall duration and stationary detection bits alone.
+    uint8_t configuration = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_DUR) & 0b10010000;
+    configuration |= ((wake_duration & 0b11) << 5) | (sleep_duration & 0b1111);
+    watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_DUR, configuration);
+#else
+    (void)wake_duration;
+    (void)sleep_duration;
+#endif
+}
+
 void lis2dw_configure_6d_threshold(uint8_t threshold) {
 #ifdef I2C_SERCOM
     uint8_t configuration = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_TAP_THS_X) & 0b01100000;
@@ -409,6 +457,14 @@ void lis2dw_configure_int1(uint8_t sources) {
 #endif
 }
 
+uint8_t lis2dw_get_int1_configuration(void) {
+#ifdef I2C_SERCOM
+    return watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL4_INT1);
+#else
+    return 0;
+#endif
+}
+
 void lis2dw_configure_int2(uint8_t sources) {
 #ifdef I2C_SERCOM
     watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL5_INT2, sources);
@@ -423,7 +479,7 @@ void lis2dw12_int_notification_set(lis2dw12_lir_t val) {
     if (val == LIS2DW12_INT_LATCHED) {
         configuration |= LIS2DW_CTRL3_VAL_LIR;
     } else {
-        configuration &= ~LIS2DW_CTRL7_VAL_DRDY_PULSED;
+        configuration &= ~LIS2DW_CTRL3_VAL_LIR;
     }
     watch_i2c_write8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL3, configuration);
 #else
@@ -434,7 +490,7 @@ void lis2dw12_int_notification_set(lis2dw12_lir_t val) {
 lis2dw12_lir_t lis2dw12_int_notification_get(void) {
 #ifdef I2C_SERCOM
     uint8_t configuration = watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_CTRL3);
-    if (configuration & LIS2DW12_INT_LATCHED) {
+    if (configuration & LIS2DW_CTRL3_VAL_LIR) {
         return LIS2DW12_INT_LATCHED;
     } else {
         return LIS2DW12_INT_PULSED;
@@ -488,6 +544,22 @@ lis2dw_interrupt_source_t lis2dw_get_interrupt_source(void) {
 #endif
 }
 
+uint8_t lis2dw_get_6d_source(void) {
+#ifdef I2C_SERCOM
+    return watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_SIXD_SRC);
+#else
+    return 0;
+#endif
+}
+
+bool lis2dw_get_sleep_state(void) {
+#ifdef I2C_SERCOM
+    return watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_STATUS) & LIS2DW_STATUS_VAL_SLEEP_STATE;
+#else
+    return false;
+#endif
+}
+
 uint8_t lis2dw_get_wakeup_threshold(void) {
 #ifdef I2C_SERCOM
     return watch_i2c_read8(LIS2DW_ADDRESS, LIS2DW_REG_WAKE_UP_THS) & 0b00111111;
@@ -301,8 +301,6 @@ typedef enum {
 #define LIS2DW_CTRL7_VAL_HP_REF_MODE        0b00000010
 #define LIS2DW_CTRL7_VAL_LPASS_ON6D         0b00000001
 
-#define LIS2DW_FIFO_TIMEOUT                 100  // timeout is in terms of 1/RTC_CNT_HZ seconds (likely 128 timeouts is one second)
-
 bool lis2dw_begin(void);
 
 uint8_t lis2dw_get_device_id(void);
@@ -347,10 +345,16 @@ void lis2dw_enable_fifo(void);
 
 void lis2dw_disable_fifo(void);
 
-bool lis2dw_read_fifo(lis2dw_fifo_t *fifo_data, uint32_t timeout);
+// Reads everything in the FIFO with lis2dw_read_fifo_burst. Returns true if the FIFO overran.
+bool lis2dw_read_fifo(lis2dw_fifo_t *fifo_data);
 
 void lis2dw_clear_fifo(void);
 
+void lis2dw_configure_fifo(lis2dw_fifo_mode_t mode, uint8_t threshold);
+
+// Reads up to max_count samples out of the FIFO in a single I2C transaction. Returns the number of samples read.
+uint8_t lis2dw_read_fifo_burst(lis2dw_reading_t *readings, uint8_t max_count, bool *overrun);
+
 void lis2dw_enable_double_tap(void);
 
 void lis2dw_disable_double_tap(void);
@@ -359,16 +363,25 @@ void lis2dw_enable_sleep(void);
 
 void lis2dw_disable_sleep(void);
 
+// Returns true if the accelerometer is allowed to drop to its sleep rate when it's still.
+bool lis2dw_get_sleep_enabled(void);
+
 void lis2dw_enable_stationary_motion_detection(void);
 
 void lis2dw_disable_stationary_motion_detection(void);
 
+bool lis2dw_get_stationary_motion_detection(void);
+
 void lis2dw_enable_tap_detection(void);
 
 void lis2dw_disable_tap_detection(void);
 
 void lis2dw_configure_wakeup_threshold(uint8_t threshold);
 
+// wake_duration is how long motion has to last to wake the accelerometer, in samples (0-3). sleep_duration is how
+// long it has to be still before it goes back to sleep: 0 is 16 samples, and from there each step is 512 samples.
+void lis2dw_configure_wakeup_duration(uint8_t wake_duration, uint8_t sleep_duration);
+
 void lis2dw_configure_6d_threshold(uint8_t threshold);
 
 void lis2dw_configure_tap_threshold(uint8_t threshold_x, uint8_t threshold_y, uint8_t threshold_z, uint8_t axes_to_enable);
@@ -381,6 +394,8 @@ lis2dw12_lir_t lis2dw12_int_notification_get(void);
 
 void lis2dw_configure_int1(uint8_t sources);
 
+uint8_t lis2dw_get_int1_configuration(void);
+
 void lis2dw_configure_int2(uint8_t sources);
 
 void lis2dw_enable_interrupts(void);
@@ -395,6 +410,12 @@ lis2dw_interrupt_source_t lis2dw_get_interrupt_source(void);
 
 lis2dw_wakeup_source_t lis2dw_get_wakeup_source(void);
 
+// Returns the SIXD_SRC register: the LIS2DW_WAKE_UP_SRC_VAL_[XYZ][HL] bits say which way the device is facing.
+uint8_t lis2dw_get_6d_source(void);
+
+// Returns true if the accelerometer is in its sleep (inactive) state.
+bool lis2dw_get_sleep_state(void);
+
 uint8_t lis2dw_get_wakeup_threshold(void);
 
 #endif // LIS2DW_H
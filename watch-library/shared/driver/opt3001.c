@@ -36,16 +36,15 @@ THE SOFTWARE.
 uint16_t opt3001_readManufacturerID(uint8_t devaddr) {
 	uint8_t buf[2];
 	buf[0] = (uint8_t) OPT3001_MANUFACTURER_ID; 
-	watch_i2c_send(devaddr, buf, 1);
-	watch_i2c_receive(devaddr, buf, 2);
+	watch_i2c_read(devaddr, buf[0], buf, 2);
     return ((uint16_t) buf[0] << 8) | ((uint16_t) buf[1]);
 }
 
 uint16_t opt3001_readDeviceID(uint8_t devaddr) {
-	uint8_t buf[2];
+	// zeroed, so a sensor that isn't there doesn't read back as one.
+	uint8_t buf[2] = {0};
    	buf[0] = (uint8_t) OPT3001_DEVICE_ID; 
-	watch_i2c_send(devaddr, buf, 1);
-	watch_i2c_receive(devaddr, buf, 2);
+	watch_i2c_read(devaddr, buf[0], buf, 2);
     return ((uint16_t) buf[0] << 8) | ((uint16_t) buf[1]);
 }
 
@@ -53,8 +52,7 @@ opt3001_Config_t opt3001_readConfig(uint8_t devaddr) {
 	opt3001_Config_t config;
 	uint8_t buf[2];
 	buf[0] = (uint8_t) OPT3001_CONFIG; 
-	watch_i2c_send(devaddr, buf, 1);
-	watch_i2c_receive(devaddr, buf, 2);
+	watch_i2c_read(devaddr, buf[0], buf, 2);
     config.rawData = ((uint16_t) buf[0] << 8) | ((uint16_t) buf[1]);
 	return config;
 }
@@ -82,10 +80,65 @@ opt3001_t opt3001_readRegister(uint8_t devaddr, opt3001_Command_t command) {
     opt3001_ER_t er;
     uint8_t buf[2]; 
 	buf[0] = (uint8_t) command; 
-	watch_i2c_send(devaddr, buf, 1);
-	watch_i2c_receive(devaddr, buf, 2);
+	watch_i2c_read(devaddr, buf[0], buf, 2);
     er.rawData = ((uint16_t) buf[0] << 8) | ((uint16_t) buf[1]);
     result.raw = er;
     result.lux = 0.01*pow(2, er.Exponent)*er.Result;
     return result;
 }
+
+opt3001_ER_t opt3001_luxToRaw(float lux) {
+    opt3001_ER_t er;
+    // lux = 0.01 * 2^Exponent * Result, with a 12-bit Result.
+    float result = lux < 0 ? 0 : lux * 100;
+    uint8_t exponent = 0;
+    while (result > 4095 && exponent < 11) {
+        result /= 2;
+        exponent++;
+    }
+    er.Exponent = exponent;
+    er.Result = result > 4095 ? 4095 : (uint16_t)result;
+    return er;
+}
+
+static void _opt3001_writeLimit(uint8_t devaddr, opt3001_Command_t command, float lux) {
+    opt3001_ER_t er = opt3001_luxToRaw(lux);
+    uint8_t buf[3] = {command, (uint8_t)(er.rawData >> 8), (uint8_t)(er.rawData & 0x00FF)};
+    watch_i2c_send(devaddr, buf, 3);
+}
+
+void opt3001_writeHighLimit(uint8_t devaddr, float lux) {
+    _opt3001_writeLimit(devaddr, OPT3001_HIGH_LIMIT, lux);
+}
+
+void opt3001_writeLowLimit(uint8_t devaddr, float lux) {
+    _opt3001_writeLimit(devaddr, OPT3001_LOW_LIMIT, lux);
+}
+
+void opt3001_setWindow(uint8_t devaddr, float low_lux, float high_lux) {
+    opt3001_writeLowLimit(devaddr, low_lux);
+    opt3001_writeHighLimit(devaddr, high_lux);
+}
+
+static opt3001_Config_t _opt3001_windowConfig(uint8_t mode) {
+    opt3001_Config_t config = {0};
+    config.RangeNumber = OPT3001_RANGE_AUTOMATIC;
+    config.ModeOfConversionOperation = mode;
+    // latched window-style comparison, INT active low, on the first reading out of the window.
+    config.Latch = 1;
+    return config;
+}
+
+void opt3001_startSingleShot(uint8_t devaddr) {
+    opt3001_writeConfig(devaddr, _opt3001_windowConfig(0b01));
+}
+
+void opt3001_startContinuous(uint8_t devaddr, bool long_conversion) {
+    opt3001_Config_t config = _opt3001_windowConfig(0b11);
+    config.ConversionTime = long_conversion;
+    opt3001_writeConfig(devaddr, config);
+}
+
+void opt3001_shutdown(uint8_t devaddr) {
+    opt3001_writeConfig(devaddr, _opt3001_windowConfig(0b00));
+}
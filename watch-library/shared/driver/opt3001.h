@@ -31,6 +31,13 @@ THE SOFTWARE.
 #ifndef OPT3001_
 #define OPT3001_
 #include <stdint.h>
+#include <stdbool.h>
+
+// I2C address with the ADDR pin tied to ground; 0x45-0x47 for VDD, SDA and SCL.
+#define OPT3001_ADDRESS_GND			0x44
+#define OPT3001_DEVICE_ID_VALUE		0x3001
+// RangeNumber setting that lets the sensor pick its own full scale for each conversion.
+#define OPT3001_RANGE_AUTOMATIC		0b1100
 
 typedef enum {
 	OPT3001_RESULT		= 0x00,
@@ -84,4 +91,24 @@ opt3001_Config_t opt3001_readConfig(uint8_t devaddr);
 void opt3001_writeConfig(uint8_t devaddr, opt3001_Config_t config);
 opt3001_t opt3001_readRegister(uint8_t devaddr, opt3001_Command_t command);
 
+// Encodes a lux value in the sensor's exponent and mantissa format, as used by the limit registers.
+opt3001_ER_t opt3001_luxToRaw(float lux);
+void opt3001_writeHighLimit(uint8_t devaddr, float lux);
+void opt3001_writeLowLimit(uint8_t devaddr, float lux);
+
+// Window comparator: with the latched window-style comparison the config functions below set up, the INT pin
+// (active low, open drain) asserts once a conversion lands outside [low_lux, high_lux], and FlagLow or FlagHigh says
+// which side. Both stay that way until the config register is read.
+void opt3001_setWindow(uint8_t devaddr, float low_lux, float high_lux);
+
+// Takes one 100 ms reading, automatically ranged, and shuts down again; ConversionReady is set when it's done.
+// Between readings, the sensor draws well under a microamp.
+void opt3001_startSingleShot(uint8_t devaddr);
+
+// Converts continuously, every 100 or 800 ms, and only raises INT when the light leaves the window.
+void opt3001_startContinuous(uint8_t devaddr, bool long_conversion);
+
+// Stops continuous conversions.
+void opt3001_shutdown(uint8_t devaddr);
+
 #endif // OPT3001_
@@ -28,6 +28,12 @@
 
 #include "spiflash.h"
 
+// The chip select is on A3. Movement takes the LIS2DW's INT1 (taps, the FIFO watermark, orientation changes) on the
+// same pin, so the two can't share a build.
+#if !defined(MOVEMENT_NO_ACCELEROMETER)
+#error "SPI flash uses A3 as its chip select, which is also the accelerometer's INT1. Build with NO_ACCELEROMETER=1."
+#endif
+
 #define SPI_FLASH_FAST_READ false
 
 static void flash_enable(void) {
@@ -39,6 +45,7 @@ static void flash_disable(void) {
 }
 
 static bool transfer(uint8_t *command, uint32_t command_length, uint8_t *data_in, uint8_t *data_out, uint32_t data_length) {
+    flash_enable();
     bool status = watch_spi_write(command, command_length);
     if (status) {
         if (data_in != NULL && data_out != NULL) {
@@ -113,8 +120,25 @@ bool spi_flash_read_data(uint32_t address, uint8_t *data, uint32_t data_length)
     return status;
 }
 
+bool spi_flash_is_busy(void) {
+    uint8_t status;
+    if (!spi_flash_read_command(CMD_READ_STATUS, &status, 1)) return false;
+
+    return (status & STATUS_BUSY) != 0;
+}
+
+bool spi_flash_wait_until_ready(void) {
+    while (spi_flash_is_busy()) {
+        // a 4K sector erase can take tens of milliseconds; page programs finish in under one.
+    }
+
+    return true;
+}
+
 void spi_flash_init(void) {
-	gpio_set_pin_level(A3, true);
-	gpio_set_pin_direction(A3, GPIO_DIRECTION_OUT);
+    HAL_GPIO_A3_set();
+    HAL_GPIO_A3_out();
     watch_enable_spi();
+    // the flash may have been left in deep power-down; this is harmless if it wasn't.
+    spi_flash_command(CMD_WAKE);
 }
@@ -49,10 +49,15 @@
 #define CMD_RESET 0x99
 #define CMD_WAKE 0xab
 
+#define STATUS_BUSY 0x01
+#define STATUS_WRITE_ENABLED 0x02
+
 bool spi_flash_command(uint8_t command);
 bool spi_flash_read_command(uint8_t command, uint8_t *response, uint32_t length);
 bool spi_flash_write_command(uint8_t command, uint8_t *data, uint32_t length);
 bool spi_flash_sector_command(uint8_t command, uint32_t address);
 bool spi_flash_write_data(uint32_t address, uint8_t *data, uint32_t data_length);
 bool spi_flash_read_data(uint32_t address, uint8_t *data, uint32_t data_length);
+bool spi_flash_is_busy(void);
+bool spi_flash_wait_until_ready(void);
 void spi_flash_init(void);
@@ -83,6 +83,9 @@ void thermistor_driver_enable(void) {
 
     // Enable the ADC peripheral, which we'll use to read the thermistor value.
     watch_enable_adc();
+    // Something else may be using the ADC, so disable puts these back to the defaults.
+    watch_set_analog_num_samples(THERMISTOR_NUM_SAMPLES);
+    watch_set_analog_sampling_length(THERMISTOR_SAMPLING_LENGTH);
     // Enable analog circuitry on the sense pin, which is tied to the thermistor resistor divider.
     HAL_GPIO_TEMPSENSE_in();
     HAL_GPIO_TEMPSENSE_pmuxen(HAL_GPIO_PMUX_ADC);
@@ -95,7 +98,9 @@ void thermistor_driver_enable(void) {
 void thermistor_driver_disable(void) {
     if (!has_thermistor) return;
 
-    // Disable the ADC peripheral.
+    // Put the ADC back the way we found it, and let go of it.
+    watch_set_analog_num_samples(16);
+    watch_set_analog_sampling_length(1);
     watch_disable_adc();
     // Disable analog circuitry on the sense pin to save power.
     HAL_GPIO_TEMPSENSE_pmuxdis();
@@ -109,6 +114,8 @@ float thermistor_driver_get_temperature(void) {
 
     // set the enable pin to the level that powers the thermistor circuit.
     HAL_GPIO_TS_ENABLE_write(THERMISTOR_ENABLE_VALUE);
+    // let it settle
+    delay_ms(THERMISTOR_SETTLING_TIME_MS);
     // get the sense pin level
     uint16_t value = watch_get_analog_pin_level(HAL_GPIO_TEMPSENSE_pin());
     // and then set the enable pin to the opposite value to power down the thermistor circuit.
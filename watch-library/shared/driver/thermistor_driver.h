@@ -35,6 +35,13 @@
 #define THERMISTOR_NOMINAL_RESISTANCE (10000.0)
 #define THERMISTOR_SERIES_RESISTANCE (10000.0)
 
+// The temperature changes slowly, so we can afford to average a lot of samples in hardware.
+#define THERMISTOR_NUM_SAMPLES (64)
+// The divider looks like about 5k to the ADC; give the sample capacitor a few cycles to charge through that.
+#define THERMISTOR_SAMPLING_LENGTH (4)
+// Time for the divider to settle once it's powered, before we start sampling.
+#define THERMISTOR_SETTLING_TIME_MS (1)
+
 bool thermistor_driver_init(void);
 void thermistor_driver_enable(void);
 void thermistor_driver_disable(void);
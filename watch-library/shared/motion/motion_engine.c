@@ -0,0 +1,222 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include "motion_engine.h"
+
+// All of these are in 1/1024 g.
+// A step has to rise at least this far above the filtered baseline, no matter how quiet things have been.
+#define MOTION_ENGINE_MIN_PEAK (40)
+// Wrist movement adding up to less than this across the three axes is just noise.
+#define MOTION_ENGINE_STILL_ENERGY (48)
+// Steps this hard are running even at a walking cadence; a long stride lands harder than it turns over.
+#define MOTION_ENGINE_RUN_PEAK (700)
+// ...and anything at or above this cadence is running whatever the peaks look like.
+#define MOTION_ENGINE_RUN_CADENCE (150)
+
+typedef struct {
+    lis2dw_data_rate_t data_rate;
+    uint16_t rate_chz;
+    uint8_t dc_shift;
+    uint8_t lp_shift;
+} motion_engine_rate_t;
+
+// The gravity filter's time constant stays around 0.6 seconds, and the two low-pass stages together roll off
+// around 3 Hz, which keeps a brisk 2.5 Hz run and loses most of the buzz above it. At 12.5 Hz there's nothing up
+// there to lose, so we don't low-pass at all.
+static const motion_engine_rate_t _motion_engine_rates[] = {
+    { LIS2DW_DATA_RATE_12_5_HZ, 1250, 3, 0 },
+    { LIS2DW_DATA_RATE_25_HZ, 2500, 4, 1 },
+    { LIS2DW_DATA_RATE_50_HZ, 5000, 5, 2 },
+    { LIS2DW_DATA_RATE_100_HZ, 10000, 6, 3 },
+};
+
+static uint16_t _motion_engine_isqrt(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) bit >>= 2;
+    while (bit) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return result;
+}
+
+static bool _motion_engine_is_stepping(const motion_engine_t *engine) {
+    return engine->run_length >= MOTION_ENGINE_MIN_RUN && engine->since_step <= engine->max_step_interval;
+}
+
+static uint8_t _motion_engine_cadence(const motion_engine_t *engine) {
+    if (!_motion_engine_is_stepping(engine) || engine->interval_average == 0) return 0;
+    // steps per minute = 60 * rate / interval; rate is in hundredths of a Hz and the interval has 4 fractional bits.
+    uint32_t cadence = ((uint32_t)engine->rate_chz * 60 * 16 / 100) / engine->interval_average;
+    return cadence > UINT8_MAX ? UINT8_MAX : cadence;
+}
+
+static void _motion_engine_step(motion_engine_t *engine) {
+    engine->peak_average += (engine->peak - engine->peak_average) / 4;
+
+    if (engine->since_step <= engine->max_step_interval) {
+        uint16_t interval = engine->since_step << 4;
+        if (engine->run_length <= 1) engine->interval_average = interval;
+        else engine->interval_average += ((int32_t)interval - engine->interval_average) / 4;
+
+        if (engine->run_length < MOTION_ENGINE_MIN_RUN) {
+            // the steps we held back while we made sure this was a walk all count now.
+            if (++engine->run_length == MOTION_ENGINE_MIN_RUN) engine->minute_steps += MOTION_ENGINE_MIN_RUN;
+        } else {
+            engine->minute_steps++;
+        }
+    } else {
+        // too long since the last one: this might be the first step of a new run, or nothing at all.
+        engine->run_length = 1;
+        engine->interval_average = 0;
+    }
+
+    engine->since_step = 0;
+}
+
+static void _motion_engine_end_window(motion_engine_t *engine) {
+    uint16_t energy = engine->window_energy / engine->window_samples;
+
+    if (_motion_engine_is_stepping(engine)) {
+        uint8_t cadence = _motion_engine_cadence(engine);
+        if (cadence >= MOTION_ENGINE_RUN_CADENCE || engine->peak_average >= MOTION_ENGINE_RUN_PEAK) {
+            engine->activity = MOTION_ACTIVITY_RUN;
+        } else {
+            engine->activity = MOTION_ACTIVITY_WALK;
+        }
+        engine->minute_cadence_sum += cadence;
+        engine->minute_stepping_windows++;
+    } else {
+        // if the steps have stopped, let the threshold come back down to meet whatever comes next.
+        engine->peak_average -= engine->peak_average / 4;
+        engine->activity = (energy >= MOTION_ENGINE_STILL_ENERGY) ? MOTION_ACTIVITY_WRIST : MOTION_ACTIVITY_STILL;
+    }
+
+    engine->minute_windows[engine->activity]++;
+    engine->window_energy = 0;
+    engine->window_samples = 0;
+}
+
+bool motion_engine_init(motion_engine_t *engine, lis2dw_data_rate_t data_rate) {
+    const motion_engine_rate_t *rate = NULL;
+    for (uint8_t i = 0; i < sizeof(_motion_engine_rates) / sizeof(motion_engine_rate_t); i++) {
+        if (_motion_engine_rates[i].data_rate == data_rate) rate = &_motion_engine_rates[i];
+    }
+    if (rate == NULL) return false;
+
+    memset(engine, 0, sizeof(motion_engine_t));
+    engine->rate_chz = rate->rate_chz;
+    engine->dc_shift = rate->dc_shift;
+    engine->lp_shift = rate->lp_shift;
+    // 4 steps a second is a sprint; one every 2 seconds is barely a walk.
+    engine->min_step_interval = rate->rate_chz / 400;
+    engine->max_step_interval = rate->rate_chz / 50;
+    engine->window_length = (rate->rate_chz + 50) / 100;
+
+    return true;
+}
+
+void motion_engine_process(motion_engine_t *engine, const lis2dw_reading_t *readings, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        // 12 bits is all the resolution we need, and it keeps the sum of squares well inside 32 bits.
+        int32_t axes[3] = { readings[i].x >> 4, readings[i].y >> 4, readings[i].z >> 4 };
+        int32_t magnitude = _motion_engine_isqrt(axes[0] * axes[0] + axes[1] * axes[1] + axes[2] * axes[2]);
+
+        if (!engine->primed) {
+            // start the filters where the signal is, rather than have them spend a few seconds catching up from 0.
+            engine->magnitude_dc = magnitude << 8;
+            for (uint8_t axis = 0; axis < 3; axis++) engine->axis_dc[axis] = axes[axis] << 8;
+            engine->primed = true;
+        }
+
+        // band-pass the magnitude: take out gravity, then smooth what's left.
+        engine->magnitude_dc += ((magnitude << 8) - engine->magnitude_dc) >> engine->dc_shift;
+        int32_t signal = magnitude - (engine->magnitude_dc >> 8);
+        engine->lp[0] += (signal - engine->lp[0]) >> engine->lp_shift;
+        engine->lp[1] += (engine->lp[0] - engine->lp[1]) >> engine->lp_shift;
+        signal = engine->lp[1];
+
+        // the magnitude doesn't change when you just turn your wrist, but the axes do. That's our measure of activity.
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            engine->axis_dc[axis] += ((axes[axis] << 8) - engine->axis_dc[axis]) >> engine->dc_shift;
+            int32_t deviation = axes[axis] - (engine->axis_dc[axis] >> 8);
+            engine->window_energy += deviation < 0 ? -deviation : deviation;
+        }
+
+        if (engine->since_step < UINT16_MAX) engine->since_step++;
+
+        // a step is a peak above the threshold, and it's over when the signal drops back below the baseline.
+        if (signal > engine->peak) engine->peak = signal > INT16_MAX ? INT16_MAX : signal;
+        int16_t threshold = engine->peak_average / 2;
+        if (threshold < MOTION_ENGINE_MIN_PEAK) threshold = MOTION_ENGINE_MIN_PEAK;
+        if (signal > threshold) engine->armed = true;
+        if (signal < 0) {
+            if (engine->armed && engine->since_step >= engine->min_step_interval) _motion_engine_step(engine);
+            engine->armed = false;
+            engine->peak = 0;
+        }
+
+        if (++engine->window_samples >= engine->window_length) _motion_engine_end_window(engine);
+    }
+}
+
+motion_activity_t motion_engine_get_activity(const motion_engine_t *engine) {
+    return engine->activity;
+}
+
+uint8_t motion_engine_get_cadence(const motion_engine_t *engine) {
+    return _motion_engine_cadence(engine);
+}
+
+uint32_t motion_engine_get_total_steps(const motion_engine_t *engine) {
+    return engine->total_steps + engine->minute_steps;
+}
+
+motion_minute_t motion_engine_end_minute(motion_engine_t *engine) {
+    motion_minute_t minute = {0};
+
+    minute.steps = engine->minute_steps;
+    if (engine->minute_stepping_windows) minute.cadence = engine->minute_cadence_sum / engine->minute_stepping_windows;
+    minute.activity = MOTION_ACTIVITY_STILL;
+    for (uint8_t activity = 1; activity < MOTION_NUM_ACTIVITIES; activity++) {
+        if (engine->minute_windows[activity] > engine->minute_windows[minute.activity]) minute.activity = activity;
+    }
+
+    engine->total_steps += engine->minute_steps;
+    engine->minute_steps = 0;
+    engine->minute_cadence_sum = 0;
+    engine->minute_stepping_windows = 0;
+    memset(engine->minute_windows, 0, sizeof(engine->minute_windows));
+
+    return minute;
+}
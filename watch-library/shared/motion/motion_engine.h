@@ -0,0 +1,134 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lis2dw.h"
+
+/** @addtogroup motion Motion Engine
+  * @brief Step counting and activity classification from raw accelerometer samples.
+  * @details The engine takes batches of lis2dw_reading_t straight out of the FIFO (see movement_accelerometer_subscribe)
+  *          and works in integer math with a fixed amount of state, so it can run on every batch without
+  *          allocating anything or touching the FPU.
+  *
+  *          Steps come from the magnitude of the acceleration, so they don't depend on how the watch sits on the
+  *          wrist: a high-pass filter takes out gravity, a low-pass filter takes out jitter, and each peak that
+  *          clears an adaptive threshold (half the recent peak height, never less than a noise floor) counts as a
+  *          step. Like most pedometers, it only starts counting once it has seen MOTION_ENGINE_MIN_RUN regular
+  *          steps in a row, so waving your arms around doesn't add up to a walk.
+  *
+  *          Every second or so, the engine also decides what the wearer is doing: still, moving their wrist,
+  *          walking or running. Faces and logs get a summary of each minute from motion_engine_end_minute.
+  *
+  *          Readings are expected at ±2 g, which is how Movement configures the accelerometer.
+  */
+/// @{
+
+/// Steps in a row it takes before the engine believes they're steps.
+#define MOTION_ENGINE_MIN_RUN (4)
+
+typedef enum {
+    MOTION_ACTIVITY_STILL = 0,  ///< not moving, or barely.
+    MOTION_ACTIVITY_WRIST,      ///< moving, but not walking: typing, washing hands, gesturing.
+    MOTION_ACTIVITY_WALK,       ///< walking.
+    MOTION_ACTIVITY_RUN,        ///< running, or walking very fast.
+    MOTION_NUM_ACTIVITIES
+} motion_activity_t;
+
+/// What happened over one minute, as reported by motion_engine_end_minute.
+typedef struct {
+    uint16_t steps;             ///< steps counted this minute.
+    uint8_t cadence;            ///< average cadence while stepping, in steps per minute; 0 if there were no steps.
+    motion_activity_t activity; ///< whichever activity took up most of the minute.
+} motion_minute_t;
+
+typedef struct {
+    // set up by motion_engine_init from the sample rate.
+    uint16_t rate_chz;          // sample rate, in hundredths of a Hz
+    uint8_t dc_shift;           // time constant of the gravity (high-pass) filter, as a power of two
+    uint8_t lp_shift;           // time constant of each low-pass stage, as a power of two
+    uint16_t min_step_interval; // in samples; the fastest cadence we'll believe
+    uint16_t max_step_interval; // in samples; any slower and the steps aren't a run anymore
+    uint16_t window_length;     // samples per classification window, about a second
+
+    // filters. dc values carry 8 fractional bits, everything else is in 1/1024 g.
+    bool primed;
+    int32_t magnitude_dc;
+    int32_t axis_dc[3];
+    int32_t lp[2];
+
+    // peak detection
+    int16_t peak;               // highest point since the signal last went negative
+    int16_t peak_average;       // recent step peak height, which sets the threshold
+    bool armed;                 // the signal has cleared the threshold since the last step
+    uint16_t since_step;        // samples since the last step
+    uint16_t interval_average;  // recent step interval in samples, with 4 fractional bits
+    uint8_t run_length;         // regular steps in a row, up to MOTION_ENGINE_MIN_RUN
+
+    // classification window
+    uint32_t window_energy;
+    uint16_t window_samples;
+    motion_activity_t activity;
+
+    // the minute so far
+    uint16_t minute_steps;
+    uint16_t minute_windows[MOTION_NUM_ACTIVITIES];
+    uint32_t minute_cadence_sum;
+    uint16_t minute_stepping_windows;
+
+    uint32_t total_steps;
+} motion_engine_t;
+
+/** @brief Resets the engine for a given accelerometer data rate.
+  * @param engine The engine state to set up.
+  * @param data_rate The rate the readings will arrive at: LIS2DW_DATA_RATE_12_5_HZ to LIS2DW_DATA_RATE_100_HZ.
+  * @return false if the engine can't work at that rate.
+  */
+bool motion_engine_init(motion_engine_t *engine, lis2dw_data_rate_t data_rate);
+
+/** @brief Runs a batch of readings through the engine.
+  * @param engine The engine state.
+  * @param readings Raw readings, oldest first.
+  * @param count The number of readings.
+  */
+void motion_engine_process(motion_engine_t *engine, const lis2dw_reading_t *readings, uint16_t count);
+
+/// @brief Returns what the wearer was doing as of the last full window (about a second).
+motion_activity_t motion_engine_get_activity(const motion_engine_t *engine);
+
+/// @brief Returns the current cadence in steps per minute, or 0 if the wearer isn't walking or running.
+uint8_t motion_engine_get_cadence(const motion_engine_t *engine);
+
+/// @brief Returns all the steps counted since motion_engine_init.
+uint32_t motion_engine_get_total_steps(const motion_engine_t *engine);
+
+/** @brief Summarizes the minute so far, and starts a new one.
+  * @details Call this once a minute, e.g. from your face's advise callback. The engine doesn't keep time itself,
+  *          so a "minute" is just whatever happened between two calls.
+  */
+motion_minute_t motion_engine_end_minute(motion_engine_t *engine);
+
+/// @}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Writes synthetic_traces.txt, the motion dump that test_main.c replays.
+
+The dump is in the same format the accel shell command writes and utils/motion_express_utilities reads: a
+"XX.NAME.CSV" line naming each event (the XX is the activity code, and NAME ends with the sample rate, as in
+STREAM_25HZ or STREAM_12_5HZ), then "index,x,y,z" lines of raw ±2 g readings, then "=== END ===".
+
+These are modeled, not recorded: gravity plus a bounce at the step frequency, arm swing at half of it, and
+sensor noise. They pin down the engine's behavior; real recordings made with `accel stream ... csv` replay through
+the same test binary (see test_main.c). The generator is seeded, so the file comes out the same every time; `make
+test` writes it, and it isn't checked in.
+"""
+
+import math
+import random
+
+ONE_G = 16384
+
+
+def rotate(vector, yaw, pitch):
+    x, y, z = vector
+    x, y = x * math.cos(yaw) - y * math.sin(yaw), x * math.sin(yaw) + y * math.cos(yaw)
+    x, z = x * math.cos(pitch) - z * math.sin(pitch), x * math.sin(pitch) + z * math.cos(pitch)
+    return x, y, z
+
+
+def stepping(rate, seconds, cadence, bounce, swing, rng):
+    frequency = cadence / 60
+    phase = rng.uniform(0, 2 * math.pi)
+    for i in range(int(rate * seconds)):
+        t = i / rate
+        step = 2 * math.pi * frequency * t + phase
+        # wrist hanging at the side: gravity mostly along -x, bounce along it, arm swing along y.
+        vertical = 1 + bounce * math.sin(step) + bounce * 0.3 * math.sin(2 * step)
+        forward = swing * math.sin(step / 2)
+        yield rotate((-vertical, forward, 0.15), 0.2 * math.sin(step / 2), 0.1)
+
+
+def still(rate, seconds, rng):
+    for _ in range(int(rate * seconds)):
+        yield (0.05, -0.1, 0.99)
+
+
+def wrist(rate, seconds, rng):
+    # gestures: turn the wrist to a new orientation every second or so, with a little scrubbing buzz on top.
+    yaw, pitch = 0, 0
+    target_yaw, target_pitch = 0, 0
+    for i in range(int(rate * seconds)):
+        t = i / rate
+        if rng.random() < 1.2 / rate:
+            target_yaw, target_pitch = rng.uniform(-1.5, 1.5), rng.uniform(-1.0, 1.0)
+        yaw += (target_yaw - yaw) * 4 / rate
+        pitch += (target_pitch - pitch) * 4 / rate
+        buzz = 0.08 * math.sin(2 * math.pi * 5 * t)
+        yield rotate((buzz, 0.1, 1.0), yaw, pitch)
+
+
+def event(out, code, name, rate, samples, rng, noise=0.01):
+    out.write(f'{code}.{name}.CSV\n')
+    for index, (x, y, z) in enumerate(samples):
+        # LIS2DW low power mode 1 is 12 bits, left-justified in the 16-bit output registers.
+        values = [max(-2048, min(2047, round((v + rng.gauss(0, noise)) * ONE_G / 16))) * 16 for v in (x, y, z)]
+        out.write(f'{index},{values[0]},{values[1]},{values[2]}\n')
+    out.write('=== END ===\n')
+
+
+def main():
+    rng = random.Random(2025)
+    with open('synthetic_traces.txt', 'w') as out:
+        event(out, 'ID', 'STREAM_12_5HZ', 12.5, still(12.5, 60, rng), rng)
+        event(out, 'WA', 'STREAM_12_5HZ', 12.5, stepping(12.5, 60, 108, 0.35, 0.2, rng), rng)
+        event(out, 'WA', 'STREAM_25HZ', 25, stepping(25, 60, 108, 0.35, 0.2, rng), rng)
+        event(out, 'RU', 'STREAM_25HZ', 25, stepping(25, 60, 162, 1.0, 0.5, rng), rng)
+        event(out, 'WH', 'STREAM_25HZ', 25, wrist(25, 60, rng), rng)
+        event(out, 'WA', 'STREAM_100HZ', 100, stepping(100, 20, 120, 0.3, 0.2, rng), rng)
+
+
+if __name__ == '__main__':
+    main()
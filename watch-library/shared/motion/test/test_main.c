@@ -0,0 +1,257 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Replays motion dumps through the motion engine. From this directory:
+ *
+ *     make test
+ *
+ * runs the tests against synthetic_traces.txt, which make_synthetic_traces.py writes. Pass one or more dump files
+ * instead, e.g. the output of `accel stream 25 120 csv` or an old motion express dump, and it prints what the engine
+ * made of each minute of each event rather than testing anything.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "../motion_engine.h"
+#include "unity.h"
+
+#define TRACE_FILE "synthetic_traces.txt"
+#define MAX_EVENTS (16)
+#define BATCH_SIZE (32)
+
+typedef struct {
+    char code[3];
+    lis2dw_data_rate_t data_rate;
+    uint16_t rate_chz;
+    lis2dw_reading_t *readings;
+    uint32_t count;
+} trace_event_t;
+
+static trace_event_t events[MAX_EVENTS];
+static uint8_t num_events;
+
+static const char *activity_names[] = {"still", "wrist", "walk", "run"};
+
+// Event names end in the sample rate: STREAM_25HZ, STREAM_12_5HZ. Old dumps without one are assumed to be 25 Hz.
+static void parse_rate(const char *name, trace_event_t *event) {
+    event->data_rate = LIS2DW_DATA_RATE_25_HZ;
+    event->rate_chz = 2500;
+    const char *hz = strstr(name, "HZ");
+    if (hz == NULL) return;
+    while (hz > name && (hz[-1] == '_' || (hz[-1] >= '0' && hz[-1] <= '9'))) hz--;
+    if (*hz == '_') hz++;
+
+    if (!strncmp(hz, "12_5HZ", 6)) { event->data_rate = LIS2DW_DATA_RATE_12_5_HZ; event->rate_chz = 1250; }
+    else if (!strncmp(hz, "25HZ", 4)) { event->data_rate = LIS2DW_DATA_RATE_25_HZ; event->rate_chz = 2500; }
+    else if (!strncmp(hz, "50HZ", 4)) { event->data_rate = LIS2DW_DATA_RATE_50_HZ; event->rate_chz = 5000; }
+    else if (!strncmp(hz, "100HZ", 5)) { event->data_rate = LIS2DW_DATA_RATE_100_HZ; event->rate_chz = 10000; }
+}
+
+static void load_trace(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "can't open %s\n", filename);
+        exit(1);
+    }
+
+    char line[128];
+    trace_event_t *event = NULL;
+    uint32_t capacity = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = 0;
+        size_t length = strlen(line);
+        if (!strcmp(line, "=== END ===")) {
+            event = NULL;
+        } else if (length > 4 && !strcmp(line + length - 4, ".CSV") && num_events < MAX_EVENTS) {
+            event = &events[num_events++];
+            memset(event, 0, sizeof(trace_event_t));
+            strncpy(event->code, line, 2);
+            parse_rate(line, event);
+            capacity = 0;
+        } else if (event != NULL) {
+            // index,x,y,z; anything else (like a column header) is skipped.
+            long index, x, y, z;
+            if (sscanf(line, "%ld,%ld,%ld,%ld", &index, &x, &y, &z) != 4) continue;
+            if (event->count == capacity) {
+                capacity = capacity ? capacity * 2 : 1024;
+                event->readings = realloc(event->readings, capacity * sizeof(lis2dw_reading_t));
+            }
+            event->readings[event->count++] = (lis2dw_reading_t){ .x = x, .y = y, .z = z };
+        }
+    }
+
+    fclose(file);
+}
+
+// Feeds an event through the engine in FIFO-sized batches, the way Movement's accelerometer service delivers them.
+static motion_minute_t replay(motion_engine_t *engine, const trace_event_t *event, uint16_t batch_size) {
+    TEST_ASSERT_TRUE(motion_engine_init(engine, event->data_rate));
+    for (uint32_t i = 0; i < event->count; i += batch_size) {
+        uint32_t count = event->count - i < batch_size ? event->count - i : batch_size;
+        motion_engine_process(engine, event->readings + i, count);
+    }
+    return motion_engine_end_minute(engine);
+}
+
+static const trace_event_t *find_event(const char *code, lis2dw_data_rate_t data_rate) {
+    for (uint8_t i = 0; i < num_events; i++) {
+        if (!strcmp(events[i].code, code) && events[i].data_rate == data_rate) return &events[i];
+    }
+    TEST_FAIL_MESSAGE("event missing from " TRACE_FILE);
+    return NULL;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_rates(void) {
+    motion_engine_t engine;
+    TEST_ASSERT_FALSE(motion_engine_init(&engine, LIS2DW_DATA_RATE_POWERDOWN));
+    TEST_ASSERT_FALSE(motion_engine_init(&engine, LIS2DW_DATA_RATE_LOWEST));
+    TEST_ASSERT_FALSE(motion_engine_init(&engine, LIS2DW_DATA_RATE_HP_400_HZ));
+    TEST_ASSERT_TRUE(motion_engine_init(&engine, LIS2DW_DATA_RATE_12_5_HZ));
+    TEST_ASSERT_TRUE(motion_engine_init(&engine, LIS2DW_DATA_RATE_100_HZ));
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_STILL, motion_engine_get_activity(&engine));
+    TEST_ASSERT_EQUAL(0, motion_engine_get_total_steps(&engine));
+}
+
+void test_still(void) {
+    motion_engine_t engine;
+    motion_minute_t minute = replay(&engine, find_event("ID", LIS2DW_DATA_RATE_12_5_HZ), BATCH_SIZE);
+    TEST_ASSERT_EQUAL(0, minute.steps);
+    TEST_ASSERT_EQUAL(0, minute.cadence);
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_STILL, minute.activity);
+}
+
+void test_walk_12_5_hz(void) {
+    motion_engine_t engine;
+    // 108 steps per minute for a minute.
+    motion_minute_t minute = replay(&engine, find_event("WA", LIS2DW_DATA_RATE_12_5_HZ), BATCH_SIZE);
+    TEST_ASSERT_UINT_WITHIN(5, 108, minute.steps);
+    TEST_ASSERT_UINT_WITHIN(8, 108, minute.cadence);
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_WALK, minute.activity);
+}
+
+void test_walk_25_hz(void) {
+    motion_engine_t engine;
+    motion_minute_t minute = replay(&engine, find_event("WA", LIS2DW_DATA_RATE_25_HZ), BATCH_SIZE);
+    TEST_ASSERT_UINT_WITHIN(5, 108, minute.steps);
+    TEST_ASSERT_UINT_WITHIN(8, 108, minute.cadence);
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_WALK, minute.activity);
+    TEST_ASSERT_EQUAL(minute.steps, motion_engine_get_total_steps(&engine));
+}
+
+void test_walk_100_hz(void) {
+    motion_engine_t engine;
+    // 120 steps per minute for 20 seconds.
+    motion_minute_t minute = replay(&engine, find_event("WA", LIS2DW_DATA_RATE_100_HZ), BATCH_SIZE);
+    TEST_ASSERT_UINT_WITHIN(3, 40, minute.steps);
+    TEST_ASSERT_UINT_WITHIN(8, 120, minute.cadence);
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_WALK, minute.activity);
+}
+
+void test_run(void) {
+    motion_engine_t engine;
+    motion_minute_t minute = replay(&engine, find_event("RU", LIS2DW_DATA_RATE_25_HZ), BATCH_SIZE);
+    TEST_ASSERT_UINT_WITHIN(8, 162, minute.steps);
+    TEST_ASSERT_UINT_WITHIN(10, 162, minute.cadence);
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_RUN, minute.activity);
+}
+
+void test_wrist_motion_is_not_walking(void) {
+    motion_engine_t engine;
+    motion_minute_t minute = replay(&engine, find_event("WH", LIS2DW_DATA_RATE_25_HZ), BATCH_SIZE);
+    TEST_ASSERT_LESS_OR_EQUAL(MOTION_ENGINE_MIN_RUN, minute.steps);
+    TEST_ASSERT_EQUAL(MOTION_ACTIVITY_WRIST, minute.activity);
+}
+
+void test_batch_size_does_not_matter(void) {
+    motion_engine_t whole, one_at_a_time;
+    const trace_event_t *event = find_event("WA", LIS2DW_DATA_RATE_25_HZ);
+    motion_minute_t a = replay(&whole, event, UINT16_MAX);
+    motion_minute_t b = replay(&one_at_a_time, event, 1);
+    TEST_ASSERT_EQUAL_MEMORY(&whole, &one_at_a_time, sizeof(motion_engine_t));
+    TEST_ASSERT_EQUAL_MEMORY(&a, &b, sizeof(motion_minute_t));
+}
+
+void test_end_minute_starts_over(void) {
+    motion_engine_t engine;
+    motion_minute_t first = replay(&engine, find_event("WA", LIS2DW_DATA_RATE_25_HZ), BATCH_SIZE);
+    motion_minute_t second = motion_engine_end_minute(&engine);
+    TEST_ASSERT_NOT_EQUAL(0, first.steps);
+    TEST_ASSERT_EQUAL(0, second.steps);
+    TEST_ASSERT_EQUAL(0, second.cadence);
+    TEST_ASSERT_EQUAL(first.steps, motion_engine_get_total_steps(&engine));
+}
+
+static void print_replay(const char *filename) {
+    num_events = 0;
+    load_trace(filename);
+    for (uint8_t i = 0; i < num_events; i++) {
+        trace_event_t *event = &events[i];
+        motion_engine_t engine;
+        if (!motion_engine_init(&engine, event->data_rate)) continue;
+
+        printf("%s: %s, %lu samples at %u.%02u Hz\n", filename, event->code, (unsigned long)event->count,
+               event->rate_chz / 100, event->rate_chz % 100);
+        uint32_t samples_per_minute = (uint32_t)event->rate_chz * 60 / 100;
+        for (uint32_t start = 0, minute_index = 0; start < event->count; start += samples_per_minute, minute_index++) {
+            uint32_t count = event->count - start < samples_per_minute ? event->count - start : samples_per_minute;
+            for (uint32_t j = 0; j < count; j += BATCH_SIZE) {
+                motion_engine_process(&engine, event->readings + start + j, count - j < BATCH_SIZE ? count - j : BATCH_SIZE);
+            }
+            motion_minute_t minute = motion_engine_end_minute(&engine);
+            printf("  minute %lu: %u steps, %u spm, %s\n", (unsigned long)minute_index, minute.steps, minute.cadence,
+                   activity_names[minute.activity]);
+        }
+        free(event->readings);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) print_replay(argv[i]);
+        return 0;
+    }
+
+    load_trace(TRACE_FILE);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_rates);
+    RUN_TEST(test_still);
+    RUN_TEST(test_walk_12_5_hz);
+    RUN_TEST(test_walk_25_hz);
+    RUN_TEST(test_walk_100_hz);
+    RUN_TEST(test_run);
+    RUN_TEST(test_wrist_motion_is_not_walking);
+    RUN_TEST(test_batch_size_does_not_matter);
+    RUN_TEST(test_end_minute_starts_over);
+    return UNITY_END();
+}
@@ -36,6 +36,9 @@
 /// @{
 /** @brief Enables the ADC peripheral. You must call this before attempting to read a value
   *        from an analog pin.
+  * @details The ADC may have more than one user at a time (say, the thermistor and the battery
+  *          voltage check), so each call to this function must be matched by a call to
+  *          watch_disable_adc. Only the first call turns the ADC on.
   */
 void watch_enable_adc(void);
 
@@ -47,11 +50,35 @@ void watch_enable_analog_input(const uint16_t pin);
 /** @brief Reads an analog value from one of the pins.
   * @param pin One of the analog pins, access using the HAL_GPIO_Ax_pin() macro.
   * @return a 16-bit unsigned integer from 0-65535 representing the sampled value, unless you
-  *         have changed the number of samples. @see watch_set_num_analog_samples for details
+  *         have changed the number of samples. @see watch_set_analog_num_samples for details
   *         on how that function changes the values returned from this one.
   **/
 uint16_t watch_get_analog_pin_level(const uint16_t pin);
 
+/** @brief Sets the number of samples to accumulate when measuring a pin level. Default is 16.
+  * @param samples A power of 2 <= 1024. Specifically: 1, 2, 4, 8, 16, 32, 64, 128, 256, 512
+  *                or 1024. Any other value will be ignored.
+  * @details The SAM L22's ADC has a resolution of 12 bits. By default, the ADC takes 16 samples
+  *          of the analog input and accumulates them in the result register, which effectively
+  *          gives us 16 bits of resolution. Slowly changing signals like a thermistor's can use
+  *          more samples to average out the noise, at the cost of a longer measurement. Fewer
+  *          samples change the range of values returned from watch_get_analog_pin_level:
+  *           - For 1 sample, the returned value will be 12 bits (0-4095).
+  *           - For 2 samples, the returned value will be 13 bits (0-8191).
+  *           - For 4 samples, the returned value will be 14 bits (0-16383).
+  *           - For 8 samples, the returned value will be 15 bits (0-32767).
+  *          For 16 samples and up, the returned value is always 16 bits (0-65535); the ADC shifts
+  *          the accumulated result right by whatever it takes to fit.
+  * @see watch_get_analog_pin_level
+  **/
+void watch_set_analog_num_samples(uint16_t samples);
+
+/** @brief Sets the length of time spent sampling, which allows measurement of higher impedance inputs.
+  *        Default is 1.
+  * @param cycles The number of ADC clock cycles to sample, between 1 and 64.
+  **/
+void watch_set_analog_sampling_length(uint8_t cycles);
+
 /** @brief Returns the voltage of the VCC supply in millivolts (i.e. 3000 mV == 3.0 V). If running on
   *        a coin cell, this will be the battery voltage. If the ADC is not running when this function
   *        is called, it enabled the ADC briefly, and returns it to the off state.
@@ -70,10 +97,11 @@ uint16_t watch_get_vcc_voltage(void);
   */
 void watch_disable_analog_input(const uint16_t pin);
 
-/** @brief Disables the ADC peripheral.
-  * @note You will need to call watch_enable_adc to re-enable the ADC peripheral. When you do, it will
-  *       have the default settings of 16 samples and 1 measurement cycle; if you customized these
-  *       parameters, you will need to set them up again.
+/** @brief Disables the ADC peripheral, once every caller of watch_enable_adc has called this.
+  * @note If you customized the number of samples or the measurement length, set them back to the
+  *       defaults (16 samples and 1 measurement cycle) before you call this; the ADC may still be
+  *       on for someone else. Once it does turn off, the next call to watch_enable_adc sets it up
+  *       with the defaults again.
   **/
 void watch_disable_adc(void);
 
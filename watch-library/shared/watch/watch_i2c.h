@@ -31,8 +31,47 @@
   * @brief This section covers functions related to the SAM L22's built-I2C driver, including
   *        configuring the I2C bus, putting values directly on the bus and reading data from
   *        registers on I2C devices.
+  * @details Everything on the bus is a transaction: a write, a read, or a write followed by a read with a
+  *          repeated start in between, which is how you read a register. In builds with I2C_INTERRUPTS=1,
+  *          transactions are queued and run from the SERCOM interrupt, so you can submit several at once and
+  *          sleep while the bus works through them. Otherwise, watch_i2c_submit runs each transaction to
+  *          completion before it returns, using gossamer's blocking driver (and a write and a separate read
+  *          in place of the repeated start). Either way, the blocking functions below are built on submit;
+  *          they just submit one transaction and wait until it's done.
   */
 /// @{
+
+/// Results of an I2C transaction.
+typedef enum {
+    WATCH_I2C_RESULT_SUCCESS = 0,   ///< The transaction completed.
+    WATCH_I2C_RESULT_PENDING = 1,   ///< The transaction is queued or in progress.
+    WATCH_I2C_RESULT_ERR_NACK = -1, ///< The device didn't acknowledge its address or a byte we sent.
+    WATCH_I2C_RESULT_ERR_BUS = -2,  ///< Bus error or lost arbitration, or the bus was off or disabled before we got to it.
+} watch_i2c_result_t;
+
+/// The most register writes watch_i2c_write8_batch can queue at once.
+#define WATCH_I2C_MAX_BATCH (16)
+
+typedef struct watch_i2c_transaction watch_i2c_transaction_t;
+
+/// Called when a transaction finishes (from the SERCOM interrupt, with I2C_INTERRUPTS); check transaction->result.
+typedef void (*watch_i2c_callback_t)(watch_i2c_transaction_t *transaction);
+
+/** @brief An I2C transaction. Fill in the address, buffers and (optionally) callback, and submit it with
+  *        watch_i2c_submit. The transaction and its buffers must stay valid until it's done.
+  */
+struct watch_i2c_transaction {
+    uint8_t addr;                   ///< The 7-bit address of the device.
+    const uint8_t *write_buf;       ///< Bytes to send, if any.
+    uint16_t write_length;          ///< How many bytes to send; 0 for a plain read.
+    uint8_t *read_buf;              ///< Storage for the bytes to receive, if any.
+    uint16_t read_length;           ///< How many bytes to receive after a repeated start; 0 for a plain write.
+    watch_i2c_callback_t callback;  ///< Called when the transaction is done, or NULL.
+    void *context;                  ///< Yours to use, e.g. from the callback.
+    volatile int8_t result;         ///< WATCH_I2C_RESULT_PENDING until it's done, then a watch_i2c_result_t.
+    watch_i2c_transaction_t *next;  ///< Used by the queue.
+};
+
 /** @brief Enables the I2C peripheral. Call this before attempting to interface with I2C devices.
   */
 void watch_enable_i2c(void);
@@ -41,11 +80,49 @@ void watch_enable_i2c(void);
   */
 void watch_disable_i2c(void);
 
+/** @brief Queues a transaction. It will run after everything submitted before it.
+  * @param transaction The transaction to run.
+  * @return false if the transaction was rejected (the bus is disabled, or there's nothing to do), in which case
+  *         its result is WATCH_I2C_RESULT_ERR_BUS and its callback won't be called.
+  */
+bool watch_i2c_submit(watch_i2c_transaction_t *transaction);
+
+/** @brief Sleeps until a submitted transaction is done.
+  * @param transaction The transaction to wait for. Since the queue runs in order, waiting for the last
+  *        transaction in a batch waits for all of them.
+  * @return The transaction's result, a watch_i2c_result_t.
+  * @note From an interrupt handler, or a transaction's callback, this can't sleep until the SERCOM interrupt
+  *       comes in, because it may never get to run. Instead it runs the bus from here, which holds up
+  *       everything else for as long as the transactions ahead of this one take.
+  */
+int8_t watch_i2c_wait(watch_i2c_transaction_t *transaction);
+
+/// @brief Returns true if there are transactions queued or in progress.
+bool watch_i2c_is_busy(void);
+
+/** @brief Writes and then reads in one transaction, with a repeated start in between, and sleeps until it's done.
+  * @param addr The address of the device you wish to talk to.
+  * @param write_buf The bytes to send.
+  * @param write_length The number of bytes to send; may be 0.
+  * @param read_buf Storage for the received bytes.
+  * @param read_length The number of bytes to receive; may be 0.
+  * @return 0 if no error code, otherwise a code via watch_i2c_result_t
+  */
+int8_t watch_i2c_transfer(int16_t addr, const uint8_t *write_buf, uint16_t write_length, uint8_t *read_buf, uint16_t read_length);
+
+/** @brief Writes a series of registers in an I2C device as one queued batch, and sleeps until it's done.
+  * @param addr The address of the device you wish to address.
+  * @param reg_values Pairs of register and value, written in order.
+  * @param count The number of pairs, up to WATCH_I2C_MAX_BATCH.
+  * @return 0 if every write succeeded, otherwise the code from the last one that failed.
+  */
+int8_t watch_i2c_write8_batch(int16_t addr, const uint8_t (*reg_values)[2], uint8_t count);
+
 /** @brief Sends a series of values to a device on the I2C bus.
   * @param addr The address of the device you wish to talk to.
   * @param buf A series of unsigned bytes; the data you wish to transmit.
   * @param length The number of bytes in buf that you wish to send.
-  * @return 0 if no error code, otherwise a code via i2c_result_t
+  * @return 0 if no error code, otherwise a code via watch_i2c_result_t
   */
 int8_t watch_i2c_send(int16_t addr, uint8_t *buf, uint16_t length);
 
@@ -53,7 +130,7 @@ int8_t watch_i2c_send(int16_t addr, uint8_t *buf, uint16_t length);
   * @param addr The address of the device you wish to hear from.
   * @param buf Storage for the incoming bytes; on return, it will contain the received data.
   * @param length The number of bytes that you wish to receive.
-  * @return 0 if no error code, otherwise a code via i2c_result_t
+  * @return 0 if no error code, otherwise a code via watch_i2c_result_t
   */
 int8_t watch_i2c_receive(int16_t addr, uint8_t *buf, uint16_t length);
 
@@ -61,10 +138,19 @@ int8_t watch_i2c_receive(int16_t addr, uint8_t *buf, uint16_t length);
   * @param addr The address of the device you wish to address.
   * @param reg The register on the device that you wish to set.
   * @param data The value that you wish to set the register to.
-  * @return 0 if no error code, otherwise a code via i2c_result_t
+  * @return 0 if no error code, otherwise a code via watch_i2c_result_t
   */
 int8_t watch_i2c_write8(int16_t addr, uint8_t reg, uint8_t data);
 
+/** @brief Reads a series of bytes, starting at a register in an I2C device.
+  * @param addr The address of the device you wish to address.
+  * @param reg The register on the device that you wish to start reading from.
+  * @param buf Storage for the incoming bytes.
+  * @param length The number of bytes that you wish to receive.
+  * @return 0 if no error code, otherwise a code via watch_i2c_result_t
+  */
+int8_t watch_i2c_read(int16_t addr, uint8_t reg, uint8_t *buf, uint16_t length);
+
 /** @brief Reads a byte from a register in an I2C device.
   * @param addr The address of the device you wish to address.
   * @param reg The register on the device that you wish to read.
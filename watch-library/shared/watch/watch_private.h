@@ -35,4 +35,7 @@ void _watch_enable_usb(void);
 /// Initializes the real-time clock peripheral. Implemented in watch_rtc.c
 void _watch_rtc_init(void);
 
+/// Turns the ADC off no matter who has it enabled, before the watch goes to sleep. Implemented in watch_adc.c
+void _watch_adc_power_off(void);
+
 #endif
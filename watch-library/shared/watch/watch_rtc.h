@@ -84,6 +84,26 @@ void watch_rtc_set_unix_time(unix_timestamp_t unix_time);
  */ 
 unix_timestamp_t watch_rtc_get_unix_time(void);
 
+/** @brief Set the current UTC date and time to the millisecond.
+  * @param unix_time The unix timestamp.
+  * @param ms Milliseconds past unix_time, from 0 to 999.
+  * @details Besides the time base, this moves the phase of the counter so that the second (and the tick
+  *          interrupts) start when they should. It does this by pausing the RTC for up to a second, so it
+  *          blocks for that long. Resolution is one counter tick (about 8 ms). In the simulator, only the
+  *          seconds are set.
+  * @warning The counter stands still while the RTC is paused, so anything scheduled against
+  *          watch_rtc_get_counter() (comparator alarms, timeouts, deadlines kept as counter values) happens
+  *          that much later in real time, up to a second. Wall-clock times are fine, because the time base is
+  *          set against the counter afterwards. Callers that keep counter-based deadlines across this call
+  *          should work them out again afterwards, the way Movement re-arms its top-of-minute alarm.
+  */
+void watch_rtc_set_unix_time_ms(unix_timestamp_t unix_time, uint16_t ms);
+
+/** @brief Get the current UTC date and time as a unix timestamp, plus milliseconds.
+  * @param ms Set to the milliseconds past the returned timestamp, in steps of one counter tick.
+  */
+unix_timestamp_t watch_rtc_get_unix_time_ms(uint16_t *ms);
+
 /** @brief Get the current value of the internal hardware counter
  *  @details The counter starts at 0 and it increases at a 128Hz rate until it overflows and starts over.
  *           We never manually set the counter. Doing so allows us to calculate absolute elapsed and more.
@@ -73,6 +73,15 @@
   */
 bool watch_storage_read(uint32_t row, uint32_t offset, uint8_t *buffer, uint32_t size);
 
+/** @brief Returns a pointer that can be used to read the storage area in place, without copying it to RAM.
+  * @details The storage area is memory mapped on hardware, and backed by a RAM array in the simulator. In
+  *          either case, the returned pointer stays valid until the row is next erased or written.
+  * @param row The row you want to read.
+  * @param offset The offset from the beginning of the row.
+  * @return A pointer to the requested location, or NULL if it lies outside the storage area.
+  */
+const uint8_t *watch_storage_get_address(uint32_t row, uint32_t offset);
+
 /** @brief Writes bytes to a page in the storage area. Note that the row should already be erased before writing.
   * @param row The row containing the page you want to write.
   * @param offset The offset from the beginning of the row. Must be a multiple of 64.
@@ -83,10 +92,20 @@ bool watch_storage_write(uint32_t row, uint32_t offset, const uint8_t *buffer, u
 
 /** @brief Erases a row in the storage area, setting all its bytes to 0xFF.
   * @param row The row you want to erase.
+  * @note Like watch_storage_write, this function only starts the operation and returns immediately; the erase
+  *       runs in the background (the RWWEE area can be erased while the main array is being read). The next
+  *       read, write, erase or sync will wait for it to finish.
   */
 bool watch_storage_erase(uint32_t row);
 
-/** @brief Waits for any pending writes to complete.
+/** @brief Checks whether a write or erase is still in progress.
+  * @return true if the flash controller is busy; false if it is ready for the next command.
+  */
+bool watch_storage_is_busy(void);
+
+/** @brief Waits for any pending writes or erases to complete.
+  * @details On hardware, the CPU idles until the flash controller's READY interrupt fires instead of
+  *          busy-waiting, since a row erase can take several milliseconds.
   */
 bool watch_storage_sync(void);
 /// @}
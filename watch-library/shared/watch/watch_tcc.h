@@ -202,6 +202,9 @@ void watch_buzzer_play_sequence(int8_t *note_sequence, void (*callback_on_end)(v
   *        an eternal loop.
   * @param callback_on_end A pointer to a callback function to be invoked when the sequence has finished playing.
   * @param volume either WATCH_BUZZER_VOLUME_SOFT or WATCH_BUZZER_VOLUME_LOUD
+  * @note On hardware built with BUZZER_DMA=1, sequences of up to 176 notes (after repeats) are played by DMA,
+  *       and the callback is invoked from the DMAC interrupt instead of TC0's. Sequences played while the LED
+  *       is on still use the 64 Hz TC0 interrupt, so the LED's brightness can follow each note's period.
   */
 void watch_buzzer_play_sequence_with_volume(int8_t *note_sequence, void (*callback_on_end)(void), watch_buzzer_volume_t volume);
 
@@ -54,5 +54,46 @@ void watch_uart_puts(char *s);
   */
 size_t watch_uart_gets(char *data, size_t max_length);
 
+/** @brief Attaches the serial shell to the UART, for debugging or pulling data from a watch without USB.
+  * @details Once enabled, shell output and input go over the UART instead of USB CDC. After a few seconds
+  *          without input, the RX pin is handed to the external interrupt controller so the watch can go back
+  *          to STANDBY; the start bit of the next character wakes it up again. Characters that arrive while
+  *          the watch is waking up may be lost, so send a newline first and wait for the prompt.
+  * @param tx_pin The pin the watch will use to transmit; either HAL_GPIO_A2_pin() or HAL_GPIO_A4_pin().
+  * @param rx_pin The pin the watch will use to receive; A1, A2, A3 or A4.
+  * @param baud The baud rate for the UART. A typical value is 19200.
+  */
+void watch_uart_shell_enable(const uint16_t tx_pin, const uint16_t rx_pin, uint32_t baud);
+
+/** @brief Detaches the serial shell from the UART and disables the UART.
+  */
+void watch_uart_shell_disable(void);
+
+/** @brief Returns true if the serial shell is attached to the UART.
+  */
+bool watch_uart_shell_is_enabled(void);
+
+/** @brief Checks whether the UART shell has heard from its host recently.
+  * @details Call this from the app loop. When it returns true, the app should keep running the shell and only
+  *          IDLE between characters. When the shell has been quiet for long enough, this arms the RX pin to
+  *          wake the watch on the next start bit and returns false, so the app can go to STANDBY.
+  * @return true if the shell is attached and awake.
+  */
+bool watch_uart_shell_is_awake(void);
+
+/** @brief Returns true if characters came in on the UART shell since watch_uart_shell_is_awake last looked.
+  * @note Safe to call with interrupts disabled, to decide whether it's safe to go to sleep.
+  */
+bool watch_uart_shell_has_pending_input(void);
+
+/** @brief Writes shell output to the UART. Used by _write when the UART shell is enabled.
+  */
+int watch_uart_shell_write(char *ptr, int len);
+
+/** @brief Reads shell input from the UART. Used by _read when the UART shell is enabled.
+  * @return The number of bytes read, or -1 if there was nothing to read.
+  */
+int watch_uart_shell_read(char *ptr, int len);
+
 /// @}
 #endif
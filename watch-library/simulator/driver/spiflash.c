@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Second Movement contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// The simulator's SPI flash: the same interface as shared/driver/spiflash.c, backed by a RAM array that behaves like
+// the W25Q-series parts the boards use. It answers a JEDEC ID, keeps the write-enable latch, and programs and erases
+// the way NOR flash does (a program can only clear bits, and wraps around at the end of its 256-byte page), so
+// filesystem.c's external volume runs against it unchanged, in the simulator and in the filesystem host tests.
+
+#include <string.h>
+#include "spiflash.h"
+
+// log2 of the capacity in bytes, which is also the third byte of the JEDEC ID. 2^18 is 256 KB, 64 sectors.
+#ifndef SPI_FLASH_RAM_SIZE_LOG2
+#define SPI_FLASH_RAM_SIZE_LOG2 18
+#endif
+
+#define SPI_FLASH_RAM_SIZE (1UL << SPI_FLASH_RAM_SIZE_LOG2)
+#define SPI_FLASH_RAM_SECTOR_SIZE 4096
+#define SPI_FLASH_RAM_PAGE_SIZE 256
+
+uint8_t spi_flash_storage[SPI_FLASH_RAM_SIZE];
+static bool write_enabled = false;
+static bool initialized = false;
+
+bool spi_flash_command(uint8_t command) {
+    switch (command) {
+        case CMD_ENABLE_WRITE:
+            write_enabled = true;
+            break;
+        case CMD_DISABLE_WRITE:
+            write_enabled = false;
+            break;
+        case CMD_CHIP_ERASE:
+            if (write_enabled) memset(spi_flash_storage, 0xff, sizeof(spi_flash_storage));
+            write_enabled = false;
+            break;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+bool spi_flash_read_command(uint8_t command, uint8_t *data, uint32_t data_length) {
+    uint8_t response[3] = {0};
+
+    switch (command) {
+        case CMD_READ_JEDEC_ID:
+            // Winbond, SPI NOR, then the capacity.
+            response[0] = 0xef;
+            response[1] = 0x40;
+            response[2] = SPI_FLASH_RAM_SIZE_LOG2;
+            break;
+        case CMD_READ_STATUS:
+            // never busy: every program and erase finishes before its command returns.
+            response[0] = write_enabled ? STATUS_WRITE_ENABLED : 0;
+            break;
+        default:
+            break;
+    }
+    for (uint32_t i = 0; i < data_length; i++) data[i] = i < sizeof(response) ? response[i] : 0;
+
+    return true;
+}
+
+bool spi_flash_write_command(uint8_t command, uint8_t *data, uint32_t data_length) {
+    (void) command;
+    (void) data;
+    (void) data_length;
+
+    return true;
+}
+
+bool spi_flash_sector_command(uint8_t command, uint32_t address) {
+    if (command == CMD_SECTOR_ERASE && write_enabled) {
+        address = (address % SPI_FLASH_RAM_SIZE) & ~(SPI_FLASH_RAM_SECTOR_SIZE - 1);
+        memset(spi_flash_storage + address, 0xff, SPI_FLASH_RAM_SECTOR_SIZE);
+    }
+    write_enabled = false;
+
+    return true;
+}
+
+bool spi_flash_write_data(uint32_t address, uint8_t *data, uint32_t data_length) {
+    if (!write_enabled) return true;
+
+    address %= SPI_FLASH_RAM_SIZE;
+    uint32_t page = address & ~(SPI_FLASH_RAM_PAGE_SIZE - 1);
+    for (uint32_t i = 0; i < data_length; i++) {
+        // like the real part, a program that runs off the end of its page starts over at the beginning of it.
+        spi_flash_storage[page + ((address + i) % SPI_FLASH_RAM_PAGE_SIZE)] &= data[i];
+    }
+    write_enabled = false;
+
+    return true;
+}
+
+bool spi_flash_read_data(uint32_t address, uint8_t *data, uint32_t data_length) {
+    for (uint32_t i = 0; i < data_length; i++) data[i] = spi_flash_storage[(address + i) % SPI_FLASH_RAM_SIZE];
+
+    return true;
+}
+
+bool spi_flash_is_busy(void) {
+    return false;
+}
+
+bool spi_flash_wait_until_ready(void) {
+    return true;
+}
+
+void spi_flash_init(void) {
+    // a new chip comes erased; after that, the contents last as long as the process does, like the RWWEE array.
+    if (!initialized) memset(spi_flash_storage, 0xff, sizeof(spi_flash_storage));
+    initialized = true;
+}
@@ -28,6 +28,34 @@ void watch_enable_i2c(void) {}
 
 void watch_disable_i2c(void) {}
 
+bool watch_i2c_submit(watch_i2c_transaction_t *transaction) {
+    // there's nothing on the simulator's bus, but nothing ever fails either; finish right away.
+    transaction->result = WATCH_I2C_RESULT_SUCCESS;
+    transaction->next = NULL;
+    if (transaction->callback != NULL) transaction->callback(transaction);
+    return true;
+}
+
+int8_t watch_i2c_wait(watch_i2c_transaction_t *transaction) {
+    return transaction->result;
+}
+
+bool watch_i2c_is_busy(void) {
+    return false;
+}
+
+int8_t watch_i2c_transfer(int16_t addr, const uint8_t *write_buf, uint16_t write_length, uint8_t *read_buf, uint16_t read_length) {
+    return 0;
+}
+
+int8_t watch_i2c_write8_batch(int16_t addr, const uint8_t (*reg_values)[2], uint8_t count) {
+    return 0;
+}
+
+int8_t watch_i2c_read(int16_t addr, uint8_t reg, uint8_t *buf, uint16_t length) {
+    return 0;
+}
+
 int8_t watch_i2c_send(int16_t addr, uint8_t *buf, uint16_t length) {
     return 0;
 }
@@ -110,6 +110,17 @@ unix_timestamp_t watch_rtc_get_unix_time(void) {
     return reference_timestamp + (counter >> RTC_CNT_DIV) + ((counter & RTC_CNT_SUBSECOND_MASK) >> (RTC_CNT_DIV - 1)) - 1;
 }
 
+unix_timestamp_t watch_rtc_get_unix_time_ms(uint16_t *ms) {
+    rtc_counter_t counter = watch_rtc_get_counter();
+    *ms = (((counter + (RTC_CNT_HZ >> 1)) & RTC_CNT_SUBSECOND_MASK) * 1000) >> RTC_CNT_DIV;
+    return reference_timestamp + (counter >> RTC_CNT_DIV) + ((counter & RTC_CNT_SUBSECOND_MASK) >> (RTC_CNT_DIV - 1)) - 1;
+}
+
+void watch_rtc_set_unix_time_ms(unix_timestamp_t unix_time, uint16_t ms) {
+    // the simulated counter's phase follows the browser's timer, so the best we can do is the nearest second.
+    watch_rtc_set_unix_time(unix_time + (ms >= 500));
+}
+
 rtc_counter_t watch_rtc_get_counter(void) {
     return counter;
 }
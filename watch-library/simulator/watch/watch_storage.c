@@ -5,6 +5,12 @@
 
 uint8_t storage[NVMCTRL_ROW_SIZE * NVMCTRL_RWWEE_PAGES];
 
+const uint8_t *watch_storage_get_address(uint32_t row, uint32_t offset) {
+    if (row * NVMCTRL_ROW_SIZE + offset >= sizeof(storage)) return NULL;
+
+    return storage + row * NVMCTRL_ROW_SIZE + offset;
+}
+
 bool watch_storage_read(uint32_t row, uint32_t offset, uint8_t *buffer, uint32_t size) {
     // printf("read row %ld offset %ld size %ld\n", row, offset, size);
     memcpy(buffer, storage + row * NVMCTRL_ROW_SIZE + offset, size);
@@ -26,6 +32,10 @@ bool watch_storage_erase(uint32_t row) {
     return true;
 }
 
+bool watch_storage_is_busy(void) {
+    return false;
+}
+
 bool watch_storage_sync(void) {
     // nothing to do here!
     return true;
@@ -44,3 +44,34 @@ size_t watch_uart_gets(char *data, size_t max_length) {
     }
     return 0;
 }
+
+void watch_uart_shell_enable(const uint16_t tx_pin, const uint16_t rx_pin, uint32_t baud) {
+    // the simulator's shell already has its own transport.
+    watch_enable_uart(tx_pin, rx_pin, baud);
+}
+
+void watch_uart_shell_disable(void) {
+}
+
+bool watch_uart_shell_is_enabled(void) {
+    return false;
+}
+
+bool watch_uart_shell_is_awake(void) {
+    return false;
+}
+
+bool watch_uart_shell_has_pending_input(void) {
+    return false;
+}
+
+int watch_uart_shell_write(char *ptr, int len) {
+    (void) ptr;
+    return len;
+}
+
+int watch_uart_shell_read(char *ptr, int len) {
+    (void) ptr;
+    (void) len;
+    return -1;
+}